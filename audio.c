@@ -0,0 +1,370 @@
+/**
+ * Audio mixer
+ * Synthesis, the command ring, and scalar, SSE2, AVX2 and AVX-512 mixing
+ * kernels compiled with target attributes and picked through cpu_dispatch.
+ */
+
+#include "audio.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AUDIO_X86 1
+#endif
+
+#define PI 3.14159265f
+
+// Music: 4 bars of 8 eighth notes at 120 beats per minute
+#define MUSIC_BARS 4
+#define MUSIC_STEPS 8
+#define MUSIC_STEP_FRAMES (AUDIO_RATE / 4)
+
+void audio_queue_init(AudioQueue *queue)
+{
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+bool audio_queue_push(AudioQueue *queue, AudioCommand command)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == AUDIO_QUEUE_SIZE)
+        return false;
+    queue->commands[head & (AUDIO_QUEUE_SIZE - 1)] = command;
+    // Publishes the command written above
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool audio_queue_pop(AudioQueue *queue, AudioCommand *command)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail)
+        return false;
+    *command = queue->commands[tail & (AUDIO_QUEUE_SIZE - 1)];
+    // Hands the slot back only after reading it
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Synthesis, all run once by mixer_init
+
+// Sine sweeping from start_hz to end_hz, fading out
+static void synth_chirp(float *out, uint32_t length, float start_hz, float end_hz)
+{
+    float phase = 0;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        float t = (float)i / length;
+        phase += 2 * PI * (start_hz + (end_hz - start_hz) * t) / AUDIO_RATE;
+        out[i] = 0.5f * sinf(phase) * (1 - t) * (1 - t);
+    }
+}
+
+// Two soft square-ish tones, the second a fifth above
+static void synth_ding(float *out, uint32_t length, float hz)
+{
+    uint32_t half = length / 2;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        float tone = i < half ? hz : hz * 1.5f;
+        float t = (float)(i < half ? i : i - half) / half;
+        float phase = 2 * PI * tone * i / AUDIO_RATE;
+        float wave = sinf(phase) + sinf(3 * phase) / 3;
+        out[i] = 0.35f * wave * (1 - t);
+    }
+}
+
+// Low-passed noise burst over a falling thump
+static void synth_crash(float *out, uint32_t length, Rng *rng)
+{
+    float low = 0, phase = 0;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        float t = (float)i / length;
+        float noise = (float)rng_range(rng, 65536) / 32768 - 1;
+        low += 0.2f * (noise - low);
+        phase += 2 * PI * (120 - 80 * t) / AUDIO_RATE;
+        float envelope = (1 - t) * (1 - t) * (1 - t);
+        out[i] = (0.6f * low + 0.5f * sinf(phase)) * envelope;
+    }
+}
+
+// Triangle wave note added into out, with a short attack and release
+static void synth_note(float *out, uint32_t length, float hz, float gain)
+{
+    uint32_t ramp = AUDIO_RATE / 200;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        float cycle = fmodf(hz * i / AUDIO_RATE, 1);
+        float wave = 4 * fabsf(cycle - 0.5f) - 1;
+        float envelope = 1;
+        if (i < ramp)
+            envelope = (float)i / ramp;
+        else if (i > length - ramp)
+            envelope = (float)(length - i) / ramp;
+        out[i] += gain * wave * envelope;
+    }
+}
+
+// A bass line walking a I-vi-IV-V progression under a melody that wanders
+// the major pentatonic scale, both picked from seed
+static void synth_music(float *out, Rng *rng)
+{
+    static const int scale[] = {0, 2, 4, 7, 9, 12, 14, 16, 19, 21};
+    static const int roots[MUSIC_BARS] = {0, 9, 5, 7};
+    int key = (int)rng_range(rng, 5); // semitones above A3
+    int degree = 4;
+    for (int bar = 0; bar < MUSIC_BARS; bar++)
+    {
+        float *bar_out = out + bar * MUSIC_STEPS * MUSIC_STEP_FRAMES;
+        float root_hz = 110 * powf(2, (key + roots[bar]) / 12.0f);
+        synth_note(bar_out, MUSIC_STEPS * MUSIC_STEP_FRAMES, root_hz, 0.25f);
+
+        for (int step = 0; step < MUSIC_STEPS; step++)
+        {
+            degree += (int)rng_range(rng, 5) - 2;
+            degree = degree < 0 ? 1 : degree > 9 ? 8 : degree;
+            if (rng_range(rng, 5) == 0)
+                continue; // a rest
+            float hz = 220 * powf(2, (key + scale[degree]) / 12.0f);
+            synth_note(bar_out + step * MUSIC_STEP_FRAMES, MUSIC_STEP_FRAMES, hz, 0.15f);
+        }
+    }
+}
+
+bool mixer_init(Mixer *mixer, uint64_t seed)
+{
+    memset(mixer, 0, sizeof(*mixer));
+    audio_queue_init(&mixer->queue);
+    mixer->level = simd_level();
+
+    static const float durations[SOUND_COUNT] = {0.15f, 0.2f, 0.4f};
+    for (int s = 0; s < SOUND_COUNT; s++)
+    {
+        mixer->sound_lengths[s] = (uint32_t)(durations[s] * AUDIO_RATE);
+        mixer->sounds[s] = calloc(mixer->sound_lengths[s], sizeof(float));
+    }
+    mixer->music_length = MUSIC_BARS * MUSIC_STEPS * MUSIC_STEP_FRAMES;
+    mixer->music = calloc(mixer->music_length, sizeof(float));
+    if (mixer->sounds[SOUND_JUMP] == NULL || mixer->sounds[SOUND_SCORE] == NULL ||
+        mixer->sounds[SOUND_HIT] == NULL || mixer->music == NULL)
+    {
+        mixer_free(mixer);
+        return false;
+    }
+
+    Rng rng;
+    rng_seed(&rng, seed);
+    synth_chirp(mixer->sounds[SOUND_JUMP], mixer->sound_lengths[SOUND_JUMP], 400, 900);
+    synth_ding(mixer->sounds[SOUND_SCORE], mixer->sound_lengths[SOUND_SCORE], 880);
+    synth_crash(mixer->sounds[SOUND_HIT], mixer->sound_lengths[SOUND_HIT], &rng);
+    synth_music(mixer->music, &rng);
+    mixer->music_voice = (Voice){mixer->music, mixer->music_length, 0, 0};
+    return true;
+}
+
+void mixer_free(Mixer *mixer)
+{
+    for (int s = 0; s < SOUND_COUNT; s++)
+    {
+        free(mixer->sounds[s]);
+        mixer->sounds[s] = NULL;
+    }
+    free(mixer->music);
+    mixer->music = NULL;
+}
+
+static void send(Mixer *mixer, AudioCommand command)
+{
+    if (!audio_queue_push(&mixer->queue, command))
+        mixer->dropped++;
+}
+
+void mixer_play(Mixer *mixer, Sound sound, float gain)
+{
+    send(mixer, (AudioCommand){AUDIO_PLAY, (uint8_t)sound, gain});
+}
+
+void mixer_set_music(Mixer *mixer, float gain)
+{
+    send(mixer, (AudioCommand){AUDIO_MUSIC, 0, gain});
+}
+
+void mixer_stop(Mixer *mixer)
+{
+    send(mixer, (AudioCommand){AUDIO_STOP, 0, 0});
+}
+
+// Mixing kernels: out[i] += gain * in[i], and clipping to [-1, 1]
+
+static void mix_scalar(float *out, const float *in, float gain, int n)
+{
+    for (int i = 0; i < n; i++)
+        out[i] += gain * in[i];
+}
+
+static void clip_scalar(float *out, int n)
+{
+    for (int i = 0; i < n; i++)
+        out[i] = out[i] > 1 ? 1 : out[i] < -1 ? -1 : out[i];
+}
+
+#ifdef AUDIO_X86
+
+// The device buffer has no alignment promise, so every kernel loads and
+// stores unaligned and finishes the tail with the scalar kernel
+
+__attribute__((target("sse2"))) static void mix_sse2(float *out, const float *in, float gain, int n)
+{
+    __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(g, _mm_loadu_ps(in + i))));
+    mix_scalar(out + i, in + i, gain, n - i);
+}
+
+__attribute__((target("sse2"))) static void clip_sse2(float *out, int n)
+{
+    __m128 high = _mm_set1_ps(1), low = _mm_set1_ps(-1);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, _mm_max_ps(low, _mm_min_ps(high, _mm_loadu_ps(out + i))));
+    clip_scalar(out + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void mix_avx2(float *out, const float *in, float gain, int n)
+{
+    __m256 g = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(out + i,
+                         _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(g, _mm256_loadu_ps(in + i))));
+    mix_scalar(out + i, in + i, gain, n - i);
+}
+
+__attribute__((target("avx2"))) static void clip_avx2(float *out, int n)
+{
+    __m256 high = _mm256_set1_ps(1), low = _mm256_set1_ps(-1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_max_ps(low, _mm256_min_ps(high, _mm256_loadu_ps(out + i))));
+    clip_scalar(out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static void mix_avx512(float *out, const float *in, float gain, int n)
+{
+    __m512 g = _mm512_set1_ps(gain);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(out + i,
+                         _mm512_add_ps(_mm512_loadu_ps(out + i), _mm512_mul_ps(g, _mm512_loadu_ps(in + i))));
+    mix_scalar(out + i, in + i, gain, n - i);
+}
+
+__attribute__((target("avx512f"))) static void clip_avx512(float *out, int n)
+{
+    __m512 high = _mm512_set1_ps(1), low = _mm512_set1_ps(-1);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(out + i, _mm512_max_ps(low, _mm512_min_ps(high, _mm512_loadu_ps(out + i))));
+    clip_scalar(out + i, n - i);
+}
+
+#endif
+
+typedef void (*MixKernel)(float *out, const float *in, float gain, int n);
+typedef void (*ClipKernel)(float *out, int n);
+
+// Indexed by SimdLevel
+#ifdef AUDIO_X86
+static const MixKernel mix_kernels[SIMD_LEVEL_COUNT] = {mix_scalar, mix_sse2, mix_avx2, mix_avx512};
+static const ClipKernel clip_kernels[SIMD_LEVEL_COUNT] = {clip_scalar, clip_sse2, clip_avx2, clip_avx512};
+#else
+static const MixKernel mix_kernels[SIMD_LEVEL_COUNT] = {mix_scalar, mix_scalar, mix_scalar, mix_scalar};
+static const ClipKernel clip_kernels[SIMD_LEVEL_COUNT] = {clip_scalar, clip_scalar, clip_scalar, clip_scalar};
+#endif
+
+// Takes a free voice, or the one nearest its end
+static Voice *claim_voice(Mixer *mixer)
+{
+    Voice *best = &mixer->voices[0];
+    for (int v = 0; v < AUDIO_MAX_VOICES; v++)
+    {
+        Voice *voice = &mixer->voices[v];
+        if (voice->samples == NULL)
+            return voice;
+        if (voice->length - voice->position < best->length - best->position)
+            best = voice;
+    }
+    return best;
+}
+
+static void apply_commands(Mixer *mixer)
+{
+    AudioCommand command;
+    while (audio_queue_pop(&mixer->queue, &command))
+    {
+        switch (command.type)
+        {
+        case AUDIO_PLAY:
+            if (command.sound < SOUND_COUNT)
+            {
+                *claim_voice(mixer) =
+                    (Voice){mixer->sounds[command.sound], mixer->sound_lengths[command.sound], 0, command.gain};
+            }
+            break;
+        case AUDIO_MUSIC:
+            mixer->music_voice.gain = command.gain;
+            break;
+        case AUDIO_STOP:
+            for (int v = 0; v < AUDIO_MAX_VOICES; v++)
+                mixer->voices[v].samples = NULL;
+            break;
+        }
+    }
+}
+
+void mixer_render_with(Mixer *mixer, float *out, int frames, SimdLevel level)
+{
+    apply_commands(mixer);
+    MixKernel mix = mix_kernels[level];
+    memset(out, 0, frames * sizeof(float));
+
+    for (int v = 0; v < AUDIO_MAX_VOICES; v++)
+    {
+        Voice *voice = &mixer->voices[v];
+        if (voice->samples == NULL)
+            continue;
+        uint32_t left = voice->length - voice->position;
+        int n = left < (uint32_t)frames ? (int)left : frames;
+        mix(out, voice->samples + voice->position, voice->gain, n);
+        voice->position += n;
+        if (voice->position == voice->length)
+            voice->samples = NULL;
+    }
+
+    // The music keeps its place while silent, so it comes back in time
+    Voice *music = &mixer->music_voice;
+    for (int done = 0; done < frames;)
+    {
+        uint32_t left = music->length - music->position;
+        int n = left < (uint32_t)(frames - done) ? (int)left : frames - done;
+        if (music->gain != 0)
+            mix(out + done, music->samples + music->position, music->gain, n);
+        music->position = (music->position + n) % music->length;
+        done += n;
+    }
+
+    clip_kernels[level](out, frames);
+}
+
+void mixer_render(Mixer *mixer, float *out, int frames)
+{
+    mixer_render_with(mixer, out, frames, mixer->level);
+}
@@ -0,0 +1,103 @@
+/**
+ * Audio mixer
+ * Sound effects (jump, score, hit) and a music loop, all synthesized up
+ * front by mixer_init, mixed on demand by mixer_render from the audio
+ * callback. The game thread never touches the voices: it pushes commands
+ * onto a single-producer single-consumer ring, and the callback drains it
+ * before mixing. Neither side takes a lock, and the callback never
+ * allocates, so it can't stall behind the game and a small device buffer
+ * (a few milliseconds) is safe.
+ *
+ * Voices are summed into the output with SIMD kernels picked through
+ * cpu_dispatch, then clipped to [-1, 1]. Output is mono float at
+ * AUDIO_RATE.
+ */
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <stdatomic.h>
+
+#include "cpu_dispatch.h"
+#include "game.h"
+
+#define AUDIO_RATE 48000
+#define AUDIO_MAX_VOICES 16
+#define AUDIO_QUEUE_SIZE 64 // commands, a power of two
+
+typedef enum
+{
+    SOUND_JUMP,
+    SOUND_SCORE,
+    SOUND_HIT,
+    SOUND_COUNT,
+} Sound;
+
+typedef enum
+{
+    AUDIO_PLAY,  // start sound at gain
+    AUDIO_MUSIC, // set the music's gain, 0 to stop it
+    AUDIO_STOP,  // silence every effect
+} AudioCommandType;
+
+typedef struct
+{
+    uint8_t type; // AudioCommandType
+    uint8_t sound;
+    float gain;
+} AudioCommand;
+
+// Head and tail sit on their own cache lines so the two threads don't
+// keep taking the line from each other
+typedef struct
+{
+    AudioCommand commands[AUDIO_QUEUE_SIZE];
+    _Alignas(64) _Atomic uint32_t head; // next to write, producer only
+    _Alignas(64) _Atomic uint32_t tail; // next to read, consumer only
+} AudioQueue;
+
+void audio_queue_init(AudioQueue *queue);
+
+// Producer side; false (and the command dropped) if the ring is full
+bool audio_queue_push(AudioQueue *queue, AudioCommand command);
+
+// Consumer side; false if the ring is empty
+bool audio_queue_pop(AudioQueue *queue, AudioCommand *command);
+
+typedef struct
+{
+    const float *samples; // NULL when free
+    uint32_t length, position;
+    float gain;
+} Voice;
+
+typedef struct
+{
+    AudioQueue queue;
+    float *sounds[SOUND_COUNT];
+    uint32_t sound_lengths[SOUND_COUNT];
+    float *music;
+    uint32_t music_length;
+    SimdLevel level;  // picked by mixer_init, off the audio thread
+    uint32_t dropped; // game thread only: commands lost to a full ring
+
+    // Audio thread only
+    Voice voices[AUDIO_MAX_VOICES];
+    Voice music_voice; // loops
+} Mixer;
+
+// Synthesizes every sound and a music loop composed from seed
+bool mixer_init(Mixer *mixer, uint64_t seed);
+void mixer_free(Mixer *mixer);
+
+// Game thread
+void mixer_play(Mixer *mixer, Sound sound, float gain);
+void mixer_set_music(Mixer *mixer, float gain);
+void mixer_stop(Mixer *mixer);
+
+// Audio thread: applies waiting commands, then fills out with frames
+// samples; never blocks or allocates
+void mixer_render(Mixer *mixer, float *out, int frames);
+void mixer_render_with(Mixer *mixer, float *out, int frames, SimdLevel level);
+
+#endif
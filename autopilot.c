@@ -0,0 +1,54 @@
+/**
+ * Autopilot
+ * Noisy gap-following player for generating replays.
+ */
+
+#include "autopilot.h"
+
+void autopilot_init(Autopilot *pilot, uint64_t seed)
+{
+    rng_seed(&pilot->noise, seed);
+    pilot->aim_offset = (int)rng_range(&pilot->noise, 120) - 60;
+    pilot->random_jump_odds = 20 + rng_range(&pilot->noise, 200);
+}
+
+bool autopilot_wants_jump(Autopilot *pilot, const World *world)
+{
+    // Aim for the first pipe the bird hasn't cleared yet
+    int target = SCREEN_HEIGHT / 2;
+    const Pipes *pipes = &world->pipes;
+    for (int i = 0; i < pipes->count; i++)
+    {
+        if (pipes->x[i] <= SCREEN_WIDTH && pipes->x[i] + PIPE_WIDTH >= BIRD_X)
+        {
+            target = pipes->gap_y[i];
+            break;
+        }
+    }
+
+    const Birds *birds = &world->birds;
+    bool jump = birds->row[0] + BIRD_HEIGHT / 2 > target + pilot->aim_offset && birds->velocity[0] > 0;
+    return jump || rng_range(&pilot->noise, pilot->random_jump_odds) == 0;
+}
+
+void autopilot_record(Autopilot *pilot, Replay *replay, uint64_t seed, uint32_t max_ticks)
+{
+    World world;
+    world_reset(&world, seed);
+    replay->num_jumps = 0;
+    replay->seed = seed;
+    replay->features = 0;
+
+    while (!world.game_over && world.tick < max_ticks)
+    {
+        if (autopilot_wants_jump(pilot, &world))
+        {
+            replay_add_jump(replay, world.tick);
+            world_jump(&world);
+        }
+        update_game(&world);
+    }
+
+    replay->num_ticks = world.tick;
+    replay->score = world.score;
+}
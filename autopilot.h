@@ -0,0 +1,27 @@
+/**
+ * Autopilot
+ * A deliberately imperfect player used to produce replays: it aims for the
+ * next gap with a per-run offset and taps at random now and then, so its
+ * runs end on the ground, on pipes and at the ceiling, or survive a while.
+ */
+
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "game.h"
+#include "replay.h"
+
+typedef struct
+{
+    int aim_offset;
+    uint32_t random_jump_odds; // one random tap in this many ticks
+    Rng noise;
+} Autopilot;
+
+void autopilot_init(Autopilot *pilot, uint64_t seed);
+bool autopilot_wants_jump(Autopilot *pilot, const World *world);
+
+// Plays a run on course seed until game over or max_ticks and records it
+void autopilot_record(Autopilot *pilot, Replay *replay, uint64_t seed, uint32_t max_ticks);
+
+#endif
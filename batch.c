@@ -0,0 +1,334 @@
+/**
+ * Batched worlds
+ * Storage for the selected layout and the batch step kernel. The kernel
+ * only touches state through the BATCH_* accessors and matches
+ * update_game() world for world.
+ */
+
+#include "batch.h"
+#include "rng_wide.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BATCH_ALIGN 64
+
+static void *batch_alloc(size_t size)
+{
+    // aligned_alloc wants a multiple of the alignment
+    size = (size + BATCH_ALIGN - 1) / BATCH_ALIGN * BATCH_ALIGN;
+    void *p = aligned_alloc(BATCH_ALIGN, size);
+    if (p != NULL)
+    {
+        memset(p, 0, size);
+    }
+    return p;
+}
+
+const char *batch_layout_name()
+{
+#if BATCH_LAYOUT == BATCH_LAYOUT_AOS
+    return "aos";
+#elif BATCH_LAYOUT == BATCH_LAYOUT_SOA
+    return "soa";
+#elif BATCH_LAYOUT == BATCH_LAYOUT_AOSOA8
+    return "aosoa8";
+#else
+    return "aosoa16";
+#endif
+}
+
+bool batch_init(Batch *batch, int num_worlds)
+{
+    memset(batch, 0, sizeof(*batch));
+    batch->num_worlds = num_worlds;
+    batch->num_blocks = (num_worlds + BATCH_BLOCK - 1) / BATCH_BLOCK;
+
+    size_t lanes = (size_t)batch->num_blocks * BATCH_BLOCK;
+    bool ok = (batch->jump = batch_alloc(lanes)) != NULL;
+
+#if BATCH_LAYOUT == BATCH_LAYOUT_AOS
+    ok = ok && (batch->storage.worlds = batch_alloc(lanes * sizeof(BatchWorld))) != NULL;
+#elif BATCH_LAYOUT == BATCH_LAYOUT_SOA
+    BatchStorage *s = &batch->storage;
+    ok = ok && (s->bird_y = batch_alloc(lanes * sizeof(float))) != NULL;
+    ok = ok && (s->bird_velocity = batch_alloc(lanes * sizeof(float))) != NULL;
+    ok = ok && (s->bird_rect_y = batch_alloc(lanes * sizeof(int))) != NULL;
+    ok = ok && (s->score = batch_alloc(lanes * sizeof(int))) != NULL;
+    ok = ok && (s->game_over = batch_alloc(lanes)) != NULL;
+    ok = ok && (s->tick = batch_alloc(lanes * sizeof(uint32_t))) != NULL;
+    ok = ok && (s->last_pipe_tick = batch_alloc(lanes * sizeof(uint32_t))) != NULL;
+    ok = ok && (s->next_pipe = batch_alloc(lanes * sizeof(int))) != NULL;
+    for (int k = 0; k < 4; k++)
+    {
+        ok = ok && (s->rng[k] = batch_alloc(lanes * sizeof(uint32_t))) != NULL;
+    }
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        ok = ok && (s->pipe_x[p] = batch_alloc(lanes * sizeof(int))) != NULL;
+        ok = ok && (s->pipe_gap_y[p] = batch_alloc(lanes * sizeof(int))) != NULL;
+        ok = ok && (s->pipe_passed[p] = batch_alloc(lanes)) != NULL;
+    }
+#else
+    ok = ok && (batch->storage.blocks = batch_alloc(batch->num_blocks * sizeof(BatchBlock))) != NULL;
+#endif
+
+    if (!ok)
+    {
+        batch_free(batch);
+        return false;
+    }
+
+    // Real worlds start on a course of their index; padding lanes never run
+    for (int i = 0; i < (int)lanes; i++)
+    {
+        batch_reset_world(batch, i, i);
+        if (i >= num_worlds)
+        {
+            BATCH_GAME_OVER(batch, i / BATCH_BLOCK, i % BATCH_BLOCK) = true;
+        }
+    }
+    return true;
+}
+
+void batch_free(Batch *batch)
+{
+    free(batch->jump);
+#if BATCH_LAYOUT == BATCH_LAYOUT_AOS
+    free(batch->storage.worlds);
+#elif BATCH_LAYOUT == BATCH_LAYOUT_SOA
+    BatchStorage *s = &batch->storage;
+    free(s->bird_y);
+    free(s->bird_velocity);
+    free(s->bird_rect_y);
+    free(s->score);
+    free(s->game_over);
+    free(s->tick);
+    free(s->last_pipe_tick);
+    free(s->next_pipe);
+    for (int k = 0; k < 4; k++)
+    {
+        free(s->rng[k]);
+    }
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        free(s->pipe_x[p]);
+        free(s->pipe_gap_y[p]);
+        free(s->pipe_passed[p]);
+    }
+#else
+    free(batch->storage.blocks);
+#endif
+    memset(batch, 0, sizeof(*batch));
+}
+
+void batch_reset_world(Batch *batch, int index, uint64_t seed)
+{
+    World world;
+    world_reset(&world, seed);
+    batch_set_world(batch, index, &world);
+}
+
+void batch_set_world(Batch *batch, int index, const World *world)
+{
+    int blk = index / BATCH_BLOCK, lane = index % BATCH_BLOCK;
+    const Pipes *pipes = &world->pipes;
+
+    BATCH_BIRD_Y(batch, blk, lane) = world->birds.y[0];
+    BATCH_BIRD_VELOCITY(batch, blk, lane) = world->birds.velocity[0];
+    BATCH_BIRD_RECT_Y(batch, blk, lane) = world->birds.row[0];
+    BATCH_SCORE(batch, blk, lane) = world->score;
+    BATCH_GAME_OVER(batch, blk, lane) = world->game_over;
+    BATCH_TICK(batch, blk, lane) = world->tick;
+    BATCH_LAST_PIPE_TICK(batch, blk, lane) = world->last_pipe_tick;
+    BATCH_NEXT_PIPE(batch, blk, lane) = pipes->count % MAX_PIPES;
+    for (int k = 0; k < 4; k++)
+    {
+        BATCH_RNG(batch, blk, lane, k) = world->rng.s[k];
+    }
+
+    // Live pipes go in the first slots, oldest first; the rest are parked
+    // off screen, where the kernel leaves them alone
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        bool live = p < pipes->count;
+        BATCH_PIPE_X(batch, blk, lane, p) = live ? pipes->x[p] : SCREEN_WIDTH * 2;
+        BATCH_PIPE_GAP_Y(batch, blk, lane, p) = live ? pipes->gap_y[p] : 0;
+        BATCH_PIPE_PASSED(batch, blk, lane, p) = live && pipes->passed[p];
+    }
+    batch->jump[index] = 0;
+}
+
+void batch_get_world(const Batch *batch, int index, World *world)
+{
+    int blk = index / BATCH_BLOCK, lane = index % BATCH_BLOCK;
+
+    // Constant fields come from a fresh world, the rest from the batch
+    world_reset(world, 0);
+    world->birds.y[0] = BATCH_BIRD_Y(batch, blk, lane);
+    world->birds.velocity[0] = BATCH_BIRD_VELOCITY(batch, blk, lane);
+    world->birds.row[0] = BATCH_BIRD_RECT_Y(batch, blk, lane);
+    world->score = BATCH_SCORE(batch, blk, lane);
+    world->game_over = BATCH_GAME_OVER(batch, blk, lane);
+    world->tick = BATCH_TICK(batch, blk, lane);
+    world->last_pipe_tick = BATCH_LAST_PIPE_TICK(batch, blk, lane);
+    for (int k = 0; k < 4; k++)
+    {
+        world->rng.s[k] = BATCH_RNG(batch, blk, lane, k);
+    }
+
+    // Walk the ring oldest first, keeping the pipes World would still have:
+    // used slots (a zero gap marks one that never held a pipe) that are not
+    // yet off the left edge
+    Pipes *pipes = &world->pipes;
+    int next = BATCH_NEXT_PIPE(batch, blk, lane);
+    for (int n = 0; n < MAX_PIPES; n++)
+    {
+        int p = (next + n) % MAX_PIPES;
+        int x = BATCH_PIPE_X(batch, blk, lane, p);
+        int gap_y = BATCH_PIPE_GAP_Y(batch, blk, lane, p);
+        if (gap_y == 0 || x + PIPE_WIDTH < 0)
+            continue;
+
+        pipes->x[pipes->count] = x;
+        pipes->gap_y[pipes->count] = gap_y;
+        pipes->passed[pipes->count] = BATCH_PIPE_PASSED(batch, blk, lane, p);
+        pipes->count++;
+    }
+
+    // Batches don't keep the hash up to date, so work it out here
+    world->hash = world_hash_full(world);
+}
+
+// Same as create_pipe() for every lane in spawn, drawing all the gaps from
+// the worlds' own generators in one wide call
+static void batch_spawn_pipes(Batch *batch, int blk, const uint8_t *spawn)
+{
+    uint32_t rng[4][BATCH_BLOCK];
+    uint32_t gap[BATCH_BLOCK];
+    uint32_t *state[4] = {rng[0], rng[1], rng[2], rng[3]};
+
+    for (int k = 0; k < 4; k++)
+    {
+        for (int lane = 0; lane < BATCH_BLOCK; lane++)
+        {
+            rng[k][lane] = BATCH_RNG(batch, blk, lane, k);
+        }
+    }
+
+    rng_range_wide(state, spawn, MAX_GAP_Y - MIN_GAP_Y, gap, BATCH_BLOCK);
+
+    for (int k = 0; k < 4; k++)
+    {
+        for (int lane = 0; lane < BATCH_BLOCK; lane++)
+        {
+            BATCH_RNG(batch, blk, lane, k) = rng[k][lane];
+        }
+    }
+
+    for (int lane = 0; lane < BATCH_BLOCK; lane++)
+    {
+        if (!spawn[lane])
+            continue;
+
+        int slot = BATCH_NEXT_PIPE(batch, blk, lane);
+        BATCH_PIPE_X(batch, blk, lane, slot) = SCREEN_WIDTH;
+        BATCH_PIPE_GAP_Y(batch, blk, lane, slot) = MIN_GAP_Y + (int)gap[lane];
+        BATCH_PIPE_PASSED(batch, blk, lane, slot) = false;
+        BATCH_NEXT_PIPE(batch, blk, lane) = (slot + 1) % MAX_PIPES;
+        BATCH_LAST_PIPE_TICK(batch, blk, lane) = BATCH_TICK(batch, blk, lane);
+    }
+}
+
+static void batch_step_block(Batch *batch, int blk)
+{
+    uint8_t *jump = &batch->jump[blk * BATCH_BLOCK];
+    int alive[BATCH_BLOCK];
+    int dead[BATCH_BLOCK];
+    int bird_top[BATCH_BLOCK];
+
+    // Advance the clock and spawn pipes; worlds started together spawn on
+    // the same tick, so the whole block usually draws at once
+    uint8_t spawn[BATCH_BLOCK];
+    int any_spawn = 0;
+    for (int lane = 0; lane < BATCH_BLOCK; lane++)
+    {
+        alive[lane] = !BATCH_GAME_OVER(batch, blk, lane);
+        BATCH_TICK(batch, blk, lane) += alive[lane];
+        spawn[lane] = alive[lane] &
+                      (BATCH_TICK(batch, blk, lane) - BATCH_LAST_PIPE_TICK(batch, blk, lane) > PIPE_SPAWN_TICKS);
+        any_spawn |= spawn[lane];
+    }
+    if (any_spawn)
+    {
+        batch_spawn_pipes(batch, blk, spawn);
+    }
+
+    // Bird: jump, integrate and clamp to the ceiling; dead lanes keep their state
+    for (int lane = 0; lane < BATCH_BLOCK; lane++)
+    {
+        float velocity = BATCH_BIRD_VELOCITY(batch, blk, lane);
+        velocity = (jump[lane] & alive[lane]) ? (float)JUMP_FORCE : velocity;
+        jump[lane] = 0;
+
+        float new_velocity = velocity + GRAVITY;
+        float new_y = BATCH_BIRD_Y(batch, blk, lane) + new_velocity;
+        int rect_y = (int)new_y;
+        int below_ceiling = rect_y >= 0;
+        new_velocity = below_ceiling ? new_velocity : 0.0f;
+        new_y = below_ceiling ? new_y : 0.0f;
+        rect_y = below_ceiling ? rect_y : 0;
+
+        BATCH_BIRD_VELOCITY(batch, blk, lane) = alive[lane] ? new_velocity : velocity;
+        BATCH_BIRD_Y(batch, blk, lane) = alive[lane] ? new_y : BATCH_BIRD_Y(batch, blk, lane);
+        rect_y = alive[lane] ? rect_y : BATCH_BIRD_RECT_Y(batch, blk, lane);
+        BATCH_BIRD_RECT_Y(batch, blk, lane) = rect_y;
+
+        bird_top[lane] = rect_y;
+        dead[lane] = rect_y + BIRD_HEIGHT > SCREEN_HEIGHT - GROUND_HEIGHT;
+    }
+
+    // Pipes: scroll, score and collide, one pipe slot across all lanes at a time
+    const int bird_left = SCREEN_WIDTH / 4;
+    const int bird_right = bird_left + BIRD_WIDTH;
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        for (int lane = 0; lane < BATCH_BLOCK; lane++)
+        {
+            int x = BATCH_PIPE_X(batch, blk, lane, p);
+            int gap_y = BATCH_PIPE_GAP_Y(batch, blk, lane, p);
+            int passed = BATCH_PIPE_PASSED(batch, blk, lane, p);
+
+            int active = alive[lane] & (x <= SCREEN_WIDTH + 100);
+            x -= PIPE_SPEED * active;
+            BATCH_PIPE_X(batch, blk, lane, p) = x;
+
+            int newly_passed = active & !passed & (x + PIPE_WIDTH < bird_left);
+            BATCH_PIPE_PASSED(batch, blk, lane, p) = passed | newly_passed;
+            BATCH_SCORE(batch, blk, lane) += newly_passed;
+
+            int overlap_x = (bird_right > x) & (bird_left < x + PIPE_WIDTH);
+            int outside_gap = (bird_top[lane] < gap_y - PIPE_GAP / 2) |
+                              (bird_top[lane] + BIRD_HEIGHT > gap_y + PIPE_GAP / 2);
+            dead[lane] |= active & overlap_x & outside_gap;
+        }
+    }
+
+    for (int lane = 0; lane < BATCH_BLOCK; lane++)
+    {
+        BATCH_GAME_OVER(batch, blk, lane) |= alive[lane] & dead[lane];
+    }
+}
+
+void batch_step_blocks(Batch *batch, int first_block, int last_block)
+{
+    for (int blk = first_block; blk < last_block; blk++)
+    {
+        batch_step_block(batch, blk);
+    }
+}
+
+void batch_step(Batch *batch)
+{
+    batch_step_blocks(batch, 0, batch->num_blocks);
+}
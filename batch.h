@@ -0,0 +1,173 @@
+/**
+ * Batched worlds
+ * Steps many independent worlds at once. The storage layout is picked at
+ * build time with -DBATCH_LAYOUT=... and hidden behind the BATCH_* accessor
+ * macros, so the same kernel runs on every layout:
+ *
+ *   BATCH_LAYOUT_AOS      array of per-world structs
+ *   BATCH_LAYOUT_SOA      one array per field
+ *   BATCH_LAYOUT_AOSOA8   blocks of 8 worlds, one 8-wide array per field
+ *   BATCH_LAYOUT_AOSOA16  blocks of 16 worlds, one 16-wide array per field
+ *
+ * World i lives in block i / BATCH_BLOCK, lane i % BATCH_BLOCK. Kernels walk
+ * blocks and lanes so that lanes are contiguous in the SoA layouts.
+ *
+ * Every layout keeps a world's pipes in a fixed ring of MAX_PIPES slots
+ * (spawning overwrites the oldest) rather than World's packed table, so all
+ * lanes walk the same slots; batch_get_world packs them back.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "game.h"
+
+#define BATCH_LAYOUT_AOS 0
+#define BATCH_LAYOUT_SOA 1
+#define BATCH_LAYOUT_AOSOA8 2
+#define BATCH_LAYOUT_AOSOA16 3
+
+#ifndef BATCH_LAYOUT
+#define BATCH_LAYOUT BATCH_LAYOUT_AOS
+#endif
+
+#if BATCH_LAYOUT == BATCH_LAYOUT_AOSOA8
+#define BATCH_BLOCK 8
+#else
+#define BATCH_BLOCK 16
+#endif
+
+#if BATCH_LAYOUT == BATCH_LAYOUT_AOS
+
+typedef struct
+{
+    float bird_y;
+    float bird_velocity;
+    int bird_rect_y;
+    int score;
+    bool game_over;
+    uint32_t tick;
+    uint32_t last_pipe_tick;
+    int next_pipe;
+    Rng rng;
+    struct
+    {
+        int x;
+        int gap_y;
+        bool passed;
+    } pipes[MAX_PIPES];
+} BatchWorld;
+
+typedef struct
+{
+    BatchWorld *worlds;
+} BatchStorage;
+
+#define BATCH_WORLD(b, blk, lane) ((b)->storage.worlds[(blk) * BATCH_BLOCK + (lane)])
+#define BATCH_BIRD_Y(b, blk, lane) (BATCH_WORLD(b, blk, lane).bird_y)
+#define BATCH_BIRD_VELOCITY(b, blk, lane) (BATCH_WORLD(b, blk, lane).bird_velocity)
+#define BATCH_BIRD_RECT_Y(b, blk, lane) (BATCH_WORLD(b, blk, lane).bird_rect_y)
+#define BATCH_SCORE(b, blk, lane) (BATCH_WORLD(b, blk, lane).score)
+#define BATCH_GAME_OVER(b, blk, lane) (BATCH_WORLD(b, blk, lane).game_over)
+#define BATCH_TICK(b, blk, lane) (BATCH_WORLD(b, blk, lane).tick)
+#define BATCH_LAST_PIPE_TICK(b, blk, lane) (BATCH_WORLD(b, blk, lane).last_pipe_tick)
+#define BATCH_NEXT_PIPE(b, blk, lane) (BATCH_WORLD(b, blk, lane).next_pipe)
+#define BATCH_RNG(b, blk, lane, k) (BATCH_WORLD(b, blk, lane).rng.s[k])
+#define BATCH_PIPE_X(b, blk, lane, p) (BATCH_WORLD(b, blk, lane).pipes[p].x)
+#define BATCH_PIPE_GAP_Y(b, blk, lane, p) (BATCH_WORLD(b, blk, lane).pipes[p].gap_y)
+#define BATCH_PIPE_PASSED(b, blk, lane, p) (BATCH_WORLD(b, blk, lane).pipes[p].passed)
+
+#elif BATCH_LAYOUT == BATCH_LAYOUT_SOA
+
+typedef struct
+{
+    float *bird_y;
+    float *bird_velocity;
+    int *bird_rect_y;
+    int *score;
+    uint8_t *game_over;
+    uint32_t *tick;
+    uint32_t *last_pipe_tick;
+    int *next_pipe;
+    uint32_t *rng[4];
+    int *pipe_x[MAX_PIPES];
+    int *pipe_gap_y[MAX_PIPES];
+    uint8_t *pipe_passed[MAX_PIPES];
+} BatchStorage;
+
+#define BATCH_INDEX(blk, lane) ((blk) * BATCH_BLOCK + (lane))
+#define BATCH_BIRD_Y(b, blk, lane) ((b)->storage.bird_y[BATCH_INDEX(blk, lane)])
+#define BATCH_BIRD_VELOCITY(b, blk, lane) ((b)->storage.bird_velocity[BATCH_INDEX(blk, lane)])
+#define BATCH_BIRD_RECT_Y(b, blk, lane) ((b)->storage.bird_rect_y[BATCH_INDEX(blk, lane)])
+#define BATCH_SCORE(b, blk, lane) ((b)->storage.score[BATCH_INDEX(blk, lane)])
+#define BATCH_GAME_OVER(b, blk, lane) ((b)->storage.game_over[BATCH_INDEX(blk, lane)])
+#define BATCH_TICK(b, blk, lane) ((b)->storage.tick[BATCH_INDEX(blk, lane)])
+#define BATCH_LAST_PIPE_TICK(b, blk, lane) ((b)->storage.last_pipe_tick[BATCH_INDEX(blk, lane)])
+#define BATCH_NEXT_PIPE(b, blk, lane) ((b)->storage.next_pipe[BATCH_INDEX(blk, lane)])
+#define BATCH_RNG(b, blk, lane, k) ((b)->storage.rng[k][BATCH_INDEX(blk, lane)])
+#define BATCH_PIPE_X(b, blk, lane, p) ((b)->storage.pipe_x[p][BATCH_INDEX(blk, lane)])
+#define BATCH_PIPE_GAP_Y(b, blk, lane, p) ((b)->storage.pipe_gap_y[p][BATCH_INDEX(blk, lane)])
+#define BATCH_PIPE_PASSED(b, blk, lane, p) ((b)->storage.pipe_passed[p][BATCH_INDEX(blk, lane)])
+
+#elif BATCH_LAYOUT == BATCH_LAYOUT_AOSOA8 || BATCH_LAYOUT == BATCH_LAYOUT_AOSOA16
+
+typedef struct
+{
+    float bird_y[BATCH_BLOCK];
+    float bird_velocity[BATCH_BLOCK];
+    int bird_rect_y[BATCH_BLOCK];
+    int score[BATCH_BLOCK];
+    uint8_t game_over[BATCH_BLOCK];
+    uint32_t tick[BATCH_BLOCK];
+    uint32_t last_pipe_tick[BATCH_BLOCK];
+    int next_pipe[BATCH_BLOCK];
+    uint32_t rng[4][BATCH_BLOCK];
+    int pipe_x[MAX_PIPES][BATCH_BLOCK];
+    int pipe_gap_y[MAX_PIPES][BATCH_BLOCK];
+    uint8_t pipe_passed[MAX_PIPES][BATCH_BLOCK];
+} BatchBlock;
+
+typedef struct
+{
+    BatchBlock *blocks;
+} BatchStorage;
+
+#define BATCH_BIRD_Y(b, blk, lane) ((b)->storage.blocks[blk].bird_y[lane])
+#define BATCH_BIRD_VELOCITY(b, blk, lane) ((b)->storage.blocks[blk].bird_velocity[lane])
+#define BATCH_BIRD_RECT_Y(b, blk, lane) ((b)->storage.blocks[blk].bird_rect_y[lane])
+#define BATCH_SCORE(b, blk, lane) ((b)->storage.blocks[blk].score[lane])
+#define BATCH_GAME_OVER(b, blk, lane) ((b)->storage.blocks[blk].game_over[lane])
+#define BATCH_TICK(b, blk, lane) ((b)->storage.blocks[blk].tick[lane])
+#define BATCH_LAST_PIPE_TICK(b, blk, lane) ((b)->storage.blocks[blk].last_pipe_tick[lane])
+#define BATCH_NEXT_PIPE(b, blk, lane) ((b)->storage.blocks[blk].next_pipe[lane])
+#define BATCH_RNG(b, blk, lane, k) ((b)->storage.blocks[blk].rng[k][lane])
+#define BATCH_PIPE_X(b, blk, lane, p) ((b)->storage.blocks[blk].pipe_x[p][lane])
+#define BATCH_PIPE_GAP_Y(b, blk, lane, p) ((b)->storage.blocks[blk].pipe_gap_y[p][lane])
+#define BATCH_PIPE_PASSED(b, blk, lane, p) ((b)->storage.blocks[blk].pipe_passed[p][lane])
+
+#else
+#error "Unknown BATCH_LAYOUT"
+#endif
+
+typedef struct
+{
+    int num_worlds;
+    int num_blocks; // storage is padded to whole blocks; padding lanes stay game over
+    uint8_t *jump;  // per-world input for the next step, cleared by the step
+    BatchStorage storage;
+} Batch;
+
+bool batch_init(Batch *batch, int num_worlds);
+void batch_free(Batch *batch);
+const char *batch_layout_name();
+
+void batch_reset_world(Batch *batch, int index, uint64_t seed);
+void batch_get_world(const Batch *batch, int index, World *world);
+void batch_set_world(Batch *batch, int index, const World *world);
+
+// Steps every live world in blocks [first_block, last_block) by one tick;
+// disjoint block ranges can be stepped from different threads
+void batch_step_blocks(Batch *batch, int first_block, int last_block);
+void batch_step(Batch *batch);
+
+#endif
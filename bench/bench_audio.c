@@ -0,0 +1,73 @@
+/**
+ * Benchmark: audio mixing per SIMD level
+ * Keeps every voice busy with a sound and the music playing, and times
+ * mixer_render for buffers of a given size at each SIMD level this CPU
+ * has. Reports time per buffer and how much of the buffer's playback time
+ * that is, the share of the audio thread's deadline mixing uses.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_audio bench/bench_audio.c audio.c cpu_dispatch.c game.c -I. -lm
+ *
+ * Usage: bench_audio [frames per buffer] [buffers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "audio.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 256;
+    int buffers = argc > 2 ? atoi(argv[2]) : 20000;
+    if (frames <= 0 || buffers <= 0)
+    {
+        fprintf(stderr, "Usage: %s [frames per buffer] [buffers]\n", argv[0]);
+        return 1;
+    }
+
+    float *out = malloc(frames * sizeof(float));
+    Mixer mixer;
+    if (out == NULL || !mixer_init(&mixer, 1))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    mixer_set_music(&mixer, 0.5f);
+
+    double buffer_ns = 1e9 * frames / AUDIO_RATE;
+    printf("%d voices + music, %d frames per buffer (%.2f ms)\n", AUDIO_MAX_VOICES, frames, buffer_ns / 1e6);
+    for (int level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (!simd_level_supported((SimdLevel)level))
+            continue;
+
+        double total = 0;
+        for (int b = 0; b < buffers; b++)
+        {
+            // Restart the sounds that ended so every voice stays busy
+            for (int v = 0; v < AUDIO_MAX_VOICES; v++)
+            {
+                if (mixer.voices[v].samples == NULL)
+                    mixer_play(&mixer, (Sound)(v % SOUND_COUNT), 0.2f);
+            }
+            double start = now_ns();
+            mixer_render_with(&mixer, out, frames, (SimdLevel)level);
+            total += now_ns() - start;
+        }
+        printf("%-7s %8.2f us per buffer, %5.2f%% of its playback time\n", simd_level_name((SimdLevel)level),
+               total / buffers / 1000, 100 * total / buffers / buffer_ns);
+    }
+
+    mixer_free(&mixer);
+    free(out);
+    return 0;
+}
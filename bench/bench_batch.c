@@ -0,0 +1,156 @@
+/**
+ * Benchmark: batch stepping throughput for the layout this binary was
+ * built with, across batch sizes and thread counts. Build once per layout
+ * (bench/bench_layouts.sh does that) to get the full matrix.
+ *
+ * Compilation:
+ * gcc -O2 -DBATCH_LAYOUT=BATCH_LAYOUT_SOA -o bench_batch bench/bench_batch.c batch.c game.c rng_wide.c cpu_dispatch.c -I. -lm -lpthread
+ *
+ * Usage: bench_batch [world-ticks per run] [batch sizes...] -- [thread counts...]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+
+#define MAX_THREADS 64
+
+typedef struct
+{
+    Batch *batch;
+    int first_block;
+    int last_block;
+    int ticks;
+} StepJob;
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t mix(uint32_t a, uint32_t b)
+{
+    uint32_t h = a * 0x9E3779B1u ^ b * 0x85EBCA77u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+// Each thread owns a block range for the whole run, feeding its worlds
+// pseudo-random jumps and restarting them as they die, like a training run
+static void *step_job(void *arg)
+{
+    StepJob *job = arg;
+    Batch *batch = job->batch;
+    int first = job->first_block * BATCH_BLOCK;
+    int last = job->last_block * BATCH_BLOCK;
+    if (last > batch->num_worlds)
+        last = batch->num_worlds;
+
+    for (int t = 0; t < job->ticks; t++)
+    {
+        for (int i = first; i < last; i++)
+        {
+            batch->jump[i] = (mix(i, t) & 15) == 0;
+        }
+
+        batch_step_blocks(batch, job->first_block, job->last_block);
+
+        for (int i = first; i < last; i++)
+        {
+            if (BATCH_GAME_OVER(batch, i / BATCH_BLOCK, i % BATCH_BLOCK))
+            {
+                batch_reset_world(batch, i, mix(i, t));
+            }
+        }
+    }
+    return NULL;
+}
+
+static double run(int num_worlds, int num_threads, int ticks)
+{
+    Batch batch;
+    if (!batch_init(&batch, num_worlds))
+    {
+        fprintf(stderr, "Could not allocate %d worlds\n", num_worlds);
+        exit(1);
+    }
+
+    pthread_t threads[MAX_THREADS];
+    StepJob jobs[MAX_THREADS];
+    for (int t = 0; t < num_threads; t++)
+    {
+        jobs[t].batch = &batch;
+        jobs[t].first_block = batch.num_blocks * t / num_threads;
+        jobs[t].last_block = batch.num_blocks * (t + 1) / num_threads;
+        jobs[t].ticks = ticks;
+    }
+
+    double start = now_ns();
+    for (int t = 1; t < num_threads; t++)
+    {
+        pthread_create(&threads[t], NULL, step_job, &jobs[t]);
+    }
+    step_job(&jobs[0]);
+    for (int t = 1; t < num_threads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    double elapsed = now_ns() - start;
+
+    batch_free(&batch);
+    return elapsed / ((double)num_worlds * ticks);
+}
+
+int main(int argc, char *argv[])
+{
+    long work = 20000000;
+    int sizes[32] = {1024, 16384, 131072};
+    int num_sizes = 3;
+    int threads[32] = {1, 2, 4, 8};
+    int num_thread_counts = 4;
+
+    // Optional: work, then batch sizes, then "--" and thread counts
+    int i = 1;
+    if (i < argc)
+        work = atol(argv[i++]);
+    if (i < argc && strcmp(argv[i], "--") != 0)
+    {
+        num_sizes = 0;
+        while (i < argc && strcmp(argv[i], "--") != 0 && num_sizes < 32)
+            sizes[num_sizes++] = atoi(argv[i++]);
+    }
+    if (i < argc && strcmp(argv[i], "--") == 0)
+    {
+        i++;
+        num_thread_counts = 0;
+        while (i < argc && num_thread_counts < 32)
+        {
+            int n = atoi(argv[i++]);
+            threads[num_thread_counts++] = n < 1 ? 1 : n > MAX_THREADS ? MAX_THREADS : n;
+        }
+    }
+
+    printf("%-8s %8s %7s %12s %12s\n", "layout", "worlds", "threads", "ns/world-tick", "Mworld-ticks/s");
+    for (int s = 0; s < num_sizes; s++)
+    {
+        int ticks = (int)(work / sizes[s]);
+        if (ticks < 100)
+            ticks = 100;
+
+        for (int t = 0; t < num_thread_counts; t++)
+        {
+            double ns = run(sizes[s], threads[t], ticks);
+            printf("%-8s %8d %7d %12.2f %12.1f\n", batch_layout_name(), sizes[s], threads[t], ns, 1000.0 / ns);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
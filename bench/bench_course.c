@@ -0,0 +1,138 @@
+/**
+ * Benchmark: many worlds on one seed, full World vs CourseWorld
+ * Records ghosts (autopilot runs with different aims and tap rates) on a
+ * single course, then plays them all in lockstep twice: as full Worlds,
+ * each generating and scrolling its own pipes, and as CourseWorlds reading
+ * gap heights from one shared Course. Reports time per world tick and
+ * memory per world, and checks both end in the same state.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_course bench/bench_course.c course.c autopilot.c game.c replay.c -I. -lm
+ *
+ * Usage: bench_course [ghosts] [max ticks] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "autopilot.h"
+#include "course.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Whether the ghost jumps on tick, moving on through its replay
+static bool ghost_jumps(const Replay *replay, uint32_t *next_jump, uint32_t tick)
+{
+    if (*next_jump < replay->num_jumps && replay->jump_ticks[*next_jump] == tick)
+    {
+        (*next_jump)++;
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    int ghosts = argc > 1 ? atoi(argv[1]) : 4096;
+    uint32_t max_ticks = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 5000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    if (ghosts <= 0)
+    {
+        fprintf(stderr, "Usage: %s [ghosts] [max ticks] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    Replay *replays = calloc(ghosts, sizeof(Replay));
+    uint32_t *next_jump = calloc(ghosts, sizeof(uint32_t));
+    World *worlds = malloc(ghosts * sizeof(World));
+    CourseWorld *course_worlds = malloc(ghosts * sizeof(CourseWorld));
+    if (replays == NULL || next_jump == NULL || worlds == NULL || course_worlds == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint32_t longest = 0;
+    for (int g = 0; g < ghosts; g++)
+    {
+        Autopilot pilot;
+        autopilot_init(&pilot, 1000 + g);
+        autopilot_record(&pilot, &replays[g], seed, max_ticks);
+        if (replays[g].num_ticks > longest)
+            longest = replays[g].num_ticks;
+    }
+
+    // Full worlds
+    uint64_t world_ticks = 0;
+    double start = now_ns();
+    for (int g = 0; g < ghosts; g++)
+        world_reset(&worlds[g], seed);
+    for (uint32_t t = 0; t < longest; t++)
+    {
+        for (int g = 0; g < ghosts; g++)
+        {
+            World *world = &worlds[g];
+            if (world->game_over || world->tick >= replays[g].num_ticks)
+                continue;
+            if (ghost_jumps(&replays[g], &next_jump[g], world->tick))
+                world_jump(world);
+            update_game(world);
+            world_ticks++;
+        }
+    }
+    double world_ns = now_ns() - start;
+
+    // Course worlds sharing one course
+    Course course;
+    memset(next_jump, 0, ghosts * sizeof(uint32_t));
+    start = now_ns();
+    course_init(&course, seed);
+    for (int g = 0; g < ghosts; g++)
+        course_world_reset(&course_worlds[g]);
+    for (uint32_t t = 0; t < longest; t++)
+    {
+        for (int g = 0; g < ghosts; g++)
+        {
+            CourseWorld *world = &course_worlds[g];
+            if (world->game_over || world->tick >= replays[g].num_ticks)
+                continue;
+            if (ghost_jumps(&replays[g], &next_jump[g], world->tick))
+                course_world_jump(world);
+            course_world_step(world, &course);
+        }
+    }
+    double course_ns = now_ns() - start;
+
+    int mismatches = 0;
+    for (int g = 0; g < ghosts; g++)
+    {
+        World rebuilt;
+        course_world_get_world(&course_worlds[g], &course, &rebuilt);
+        if (rebuilt.hash != worlds[g].hash)
+            mismatches++;
+    }
+
+    printf("%d ghosts on seed %llu, %llu world ticks, course of %u pipes\n", ghosts, (unsigned long long)seed,
+           (unsigned long long)world_ticks, course.count);
+    printf("World        %6.1f ns/tick  %4zu bytes/world\n", world_ns / world_ticks, sizeof(World));
+    printf("CourseWorld  %6.1f ns/tick  %4zu bytes/world + %zu bytes shared\n", course_ns / world_ticks,
+           sizeof(CourseWorld), course.capacity * sizeof(uint16_t) + sizeof(Course));
+    if (mismatches > 0)
+        printf("MISMATCH: %d ghosts ended differently\n", mismatches);
+
+    course_free(&course);
+    for (int g = 0; g < ghosts; g++)
+        replay_free(&replays[g]);
+    free(course_worlds);
+    free(worlds);
+    free(next_jump);
+    free(replays);
+    return mismatches > 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * Benchmark: full versus dirty-rect texture uploads
+ * Plays an autopilot run in the software renderer's loop and times what
+ * getting each frame into texture memory costs: copying the whole frame
+ * (SDL_UpdateTexture of everything), or finding the dirty rects and
+ * copying only those, for ARGB frames and for indexed frames expanded
+ * rect by rect. Rasterizing is left out, being the same either way.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_dirty bench/bench_dirty.c dirty.c raster.c render.c autopilot.c replay.c game.c cpu_dispatch.c -I. -lm
+ *
+ * Usage: bench_dirty [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "autopilot.h"
+#include "dirty.h"
+#include "raster.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void copy_rect(uint32_t *texture, const Framebuffer *frame, Rect r)
+{
+    for (int y = r.y; y < r.y + r.h; y++)
+    {
+        memcpy(texture + (size_t)y * SCREEN_WIDTH + r.x, frame->pixels + (size_t)y * frame->pitch + r.x,
+               r.w * sizeof(uint32_t));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+    if (frames <= 0)
+    {
+        fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+
+    Framebuffer argb;
+    IndexedFramebuffer indexed;
+    DirtyTracker tracker, indexed_tracker;
+    uint32_t *texture = malloc((size_t)SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+    if (texture == NULL || !framebuffer_init(&argb, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !indexed_framebuffer_init(&indexed, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !dirty_init(&tracker, SCREEN_WIDTH, SCREEN_HEIGHT, sizeof(uint32_t)) ||
+        !dirty_init(&indexed_tracker, SCREEN_WIDTH, SCREEN_HEIGHT, 1))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    static DrawList list;
+    World world;
+    Autopilot pilot;
+    world_reset(&world, 1);
+    autopilot_init(&pilot, 1);
+    double full_ns = 0, dirty_ns = 0, indexed_full_ns = 0, indexed_dirty_ns = 0;
+    long dirty_pixels = 0, rects = 0;
+    for (int f = 0; f < frames; f++)
+    {
+        if (world.game_over)
+            world_reset(&world, 1 + f);
+        if (autopilot_wants_jump(&pilot, &world))
+            world_jump(&world);
+        update_game(&world);
+        render_world(&list, &world);
+        raster_draw_list(&argb, &list);
+        raster_draw_list_indexed(&indexed, &list);
+
+        double start = now_ns();
+        copy_rect(texture, &argb, (Rect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+        full_ns += now_ns() - start;
+
+        start = now_ns();
+        int count = dirty_update(&tracker, argb.pixels, argb.pitch * sizeof(uint32_t));
+        for (int i = 0; i < count; i++)
+        {
+            copy_rect(texture, &argb, tracker.rects[i]);
+            dirty_pixels += (long)tracker.rects[i].w * tracker.rects[i].h;
+        }
+        dirty_ns += now_ns() - start;
+        rects += count;
+
+        start = now_ns();
+        indexed_expand(&indexed, texture, SCREEN_WIDTH);
+        indexed_full_ns += now_ns() - start;
+
+        start = now_ns();
+        count = dirty_update(&indexed_tracker, indexed.pixels, indexed.pitch);
+        for (int i = 0; i < count; i++)
+            indexed_expand_rect(&indexed, texture, SCREEN_WIDTH, indexed_tracker.rects[i]);
+        indexed_dirty_ns += now_ns() - start;
+    }
+
+    printf("%d frames of %dx%d, %.1f%% of each frame dirty in %.1f rects\n", frames, SCREEN_WIDTH, SCREEN_HEIGHT,
+           100.0 * dirty_pixels / frames / (SCREEN_WIDTH * SCREEN_HEIGHT), (double)rects / frames);
+    printf("argb     full %7.1f us, dirty rects %7.1f us per frame\n", full_ns / frames / 1000,
+           dirty_ns / frames / 1000);
+    printf("indexed  full %7.1f us, dirty rects %7.1f us per frame\n", indexed_full_ns / frames / 1000,
+           indexed_dirty_ns / frames / 1000);
+
+    framebuffer_free(&argb);
+    indexed_framebuffer_free(&indexed);
+    dirty_free(&tracker);
+    dirty_free(&indexed_tracker);
+    free(texture);
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * Benchmark: stepping the bird vs the exact flight closed form
+ * Asks where the bird is some ticks after a launch, as a server sending
+ * snapshots every 2 ticks, a fast-forward of a second and a prediction of
+ * when it hits the ground would: once by stepping update_game's float
+ * operations tick by tick, once with flight_at / flight_ground_tick.
+ * Reports time per query and the largest difference in position.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_flight bench/bench_flight.c flight.c game.c -I. -lm
+ *
+ * Usage: bench_flight [launches]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "flight.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Same float operations as update_game
+static float step_to(float y, float velocity, uint32_t ticks)
+{
+    for (uint32_t t = 0; t < ticks; t++)
+    {
+        velocity += GRAVITY;
+        y += velocity;
+        if ((int)y < 0)
+        {
+            y = 0;
+            velocity = 0;
+        }
+    }
+    return y;
+}
+
+static uint32_t step_to_ground(float y, float velocity)
+{
+    uint32_t tick = 0;
+    do
+    {
+        tick++;
+        velocity += GRAVITY;
+        y += velocity;
+        if ((int)y < 0)
+        {
+            y = 0;
+            velocity = 0;
+        }
+    } while ((int)y + BIRD_HEIGHT <= SCREEN_HEIGHT - GROUND_HEIGHT);
+    return tick;
+}
+
+int main(int argc, char *argv[])
+{
+    int launches = argc > 1 ? atoi(argv[1]) : 1 << 16;
+    if (launches <= 0)
+    {
+        fprintf(stderr, "Usage: %s [launches]\n", argv[0]);
+        return 1;
+    }
+
+    Flight *flights = malloc(launches * sizeof(Flight));
+    if (flights == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    Rng rng;
+    rng_seed(&rng, 1);
+    for (int i = 0; i < launches; i++)
+    {
+        // Jumps, and falls, from anywhere the bird can be
+        float y = (float)rng_range(&rng, 5500000) / 10000;
+        flights[i] = (Flight){y, rng_range(&rng, 2) ? JUMP_FORCE : (float)rng_range(&rng, 80000) / 10000};
+    }
+
+    static const uint32_t horizons[] = {2, TICK_RATE};
+    for (int h = 0; h < 2; h++)
+    {
+        double sum = 0, worst = 0;
+        int differ = 0;
+        double start = now_ns();
+        for (int i = 0; i < launches; i++)
+            sum += step_to((float)flights[i].y, (float)flights[i].velocity, horizons[h]);
+        double stepped_ns = (now_ns() - start) / launches;
+
+        start = now_ns();
+        for (int i = 0; i < launches; i++)
+            sum -= flight_at(flights[i], horizons[h]).y;
+        double closed_ns = (now_ns() - start) / launches;
+
+        for (int i = 0; i < launches; i++)
+        {
+            double error = fabs(step_to((float)flights[i].y, (float)flights[i].velocity, horizons[h]) -
+                                flight_at(flights[i], horizons[h]).y);
+            if (error < 0.01)
+            {
+                if (error > worst)
+                    worst = error;
+            }
+            else
+            {
+                differ++; // stopped by the ceiling a tick apart
+            }
+        }
+        printf("%2u ticks ahead: stepped %6.1f ns, closed form %6.1f ns, worst difference %.5f px, "
+               "%d a ceiling tick apart (%g)\n",
+               horizons[h], stepped_ns, closed_ns, worst, differ, sum);
+    }
+
+    uint64_t sum = 0;
+    int differ = 0;
+    double start = now_ns();
+    for (int i = 0; i < launches; i++)
+        sum += step_to_ground((float)flights[i].y, (float)flights[i].velocity);
+    double stepped_ns = (now_ns() - start) / launches;
+
+    start = now_ns();
+    for (int i = 0; i < launches; i++)
+        sum -= flight_ground_tick(flights[i]);
+    double closed_ns = (now_ns() - start) / launches;
+
+    for (int i = 0; i < launches; i++)
+        differ += step_to_ground((float)flights[i].y, (float)flights[i].velocity) != flight_ground_tick(flights[i]);
+    printf("ground tick:    stepped %6.1f ns, closed form %6.1f ns, %d of %d a tick apart (%lld)\n", stepped_ns,
+           closed_ns, differ, launches, (long long)sum);
+
+    free(flights);
+    return 0;
+}
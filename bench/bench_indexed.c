@@ -0,0 +1,98 @@
+/**
+ * Benchmark: ARGB versus indexed software frames
+ * Renders frames of a real run both ways up to the point of upload: ARGB
+ * is rasterize then copy into a texture-sized buffer (what
+ * SDL_UpdateTexture does), indexed is rasterize into 8 bits then expand
+ * into that buffer (what the game does through a locked texture), at each
+ * SIMD level this CPU has. Reports time per frame and the bytes each
+ * writes and reads.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_indexed bench/bench_indexed.c raster.c render.c game.c cpu_dispatch.c -I. -lm
+ *
+ * Usage: bench_indexed [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "raster.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 500;
+    if (frames <= 0)
+    {
+        fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+
+    // Frames spread over a run with everything on screen
+    static DrawList lists[16];
+    World world;
+    world_reset_features(&world, 1, WORLD_PICKUPS);
+    for (int i = 0; i < 16; i++)
+    {
+        for (int t = 0; t < 20; t++)
+        {
+            if (world.birds.velocity[0] > 3)
+                world_jump(&world);
+            update_game(&world);
+        }
+        render_world(&lists[i], &world);
+    }
+
+    Framebuffer argb;
+    IndexedFramebuffer indexed;
+    uint32_t *texture = malloc((size_t)SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+    if (texture == NULL || !framebuffer_init(&argb, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !indexed_framebuffer_init(&indexed, SCREEN_WIDTH, SCREEN_HEIGHT))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    double pixels = (double)SCREEN_WIDTH * SCREEN_HEIGHT;
+    printf("%dx%d frames, raster and copy to texture memory\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    double start = now_ns();
+    for (int f = 0; f < frames; f++)
+    {
+        raster_draw_list(&argb, &lists[f % 16]);
+        for (int y = 0; y < SCREEN_HEIGHT; y++)
+            memcpy(texture + (size_t)y * SCREEN_WIDTH, argb.pixels + (size_t)y * argb.pitch,
+                   SCREEN_WIDTH * sizeof(uint32_t));
+    }
+    double ns = (now_ns() - start) / frames;
+    printf("argb             %7.3f ms per frame, framebuffer %4.1f MB written + read\n", ns / 1e6,
+           2 * 4 * pixels / 1e6);
+
+    for (int level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (!simd_level_supported((SimdLevel)level))
+            continue;
+        start = now_ns();
+        for (int f = 0; f < frames; f++)
+        {
+            raster_draw_list_indexed(&indexed, &lists[f % 16]);
+            indexed_expand_with(&indexed, texture, SCREEN_WIDTH, (SimdLevel)level);
+        }
+        ns = (now_ns() - start) / frames;
+        printf("indexed %-7s  %7.3f ms per frame, framebuffer %4.1f MB written + read, %d colours\n",
+               simd_level_name((SimdLevel)level), ns / 1e6, 2 * pixels / 1e6, indexed.palette.count);
+    }
+
+    framebuffer_free(&argb);
+    indexed_framebuffer_free(&indexed);
+    free(texture);
+    return 0;
+}
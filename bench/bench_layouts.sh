@@ -0,0 +1,27 @@
+#!/bin/sh
+# Builds bench_batch once per world storage layout and runs the same
+# matrix of batch sizes and thread counts on each.
+#
+# Usage: bench/bench_layouts.sh [bench_batch arguments]
+
+set -e
+cd "$(dirname "$0")/.."
+
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2 -march=native}
+OUT=${TMPDIR:-/tmp}
+
+for layout in AOS SOA AOSOA8 AOSOA16; do
+    $CC $CFLAGS -DBATCH_LAYOUT=BATCH_LAYOUT_$layout -I. -o "$OUT/bench_batch_$layout" \
+        bench/bench_batch.c batch.c game.c rng_wide.c cpu_dispatch.c -lm -lpthread
+done
+
+first=1
+for layout in AOS SOA AOSOA8 AOSOA16; do
+    if [ $first -eq 1 ]; then
+        "$OUT/bench_batch_$layout" "$@"
+        first=0
+    else
+        "$OUT/bench_batch_$layout" "$@" | tail -n +2
+    fi
+done
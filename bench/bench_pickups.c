@@ -0,0 +1,94 @@
+/**
+ * Benchmark: pickup queries through the grid vs scanning every pickup
+ * Flies autopilot runs with pickups on and, each tick, asks which pickups
+ * touch the bird both ways, timing the queries in groups by how many
+ * pickups are live, so the bonus stages' dense blocks show how each cost
+ * grows with the total.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_pickups bench/bench_pickups.c autopilot.c game.c replay.c -I. -lm
+ *
+ * Usage: bench_pickups [runs] [max ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "autopilot.h"
+
+#define QUERY_REPEATS 64 // per tick, so each timing is well above the clock's resolution
+#define GROUPS 4
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int touching_by_scan(const World *world, int *hits)
+{
+    int32_t left = BIRD_X + PIPE_SPEED * (int32_t)world->tick;
+    int top = world->birds.row[0];
+    int n = 0;
+    for (int i = 0; i < world->pickups.count; i++)
+    {
+        if (world->pickups.x[i] < left + BIRD_WIDTH && world->pickups.x[i] + PICKUP_SIZE > left &&
+            world->pickups.y[i] < top + BIRD_HEIGHT && world->pickups.y[i] + PICKUP_SIZE > top)
+            hits[n++] = i;
+    }
+    return n;
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 512;
+    uint32_t max_ticks = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 20000;
+
+    double grid_ns[GROUPS] = {0}, scan_ns[GROUPS] = {0};
+    long queries[GROUPS] = {0};
+    long found = 0;
+    int hits[MAX_PICKUPS];
+
+    for (int r = 0; r < runs; r++)
+    {
+        Autopilot pilot;
+        World world;
+        autopilot_init(&pilot, 1 + r);
+        world_reset_features(&world, 1 + r, WORLD_PICKUPS);
+
+        while (!world.game_over && world.tick < max_ticks)
+        {
+            if (autopilot_wants_jump(&pilot, &world))
+                world_jump(&world);
+            update_game(&world);
+
+            int group = world.pickups.count * GROUPS / (MAX_PICKUPS + 1);
+            double t0 = now_ns();
+            for (int q = 0; q < QUERY_REPEATS; q++)
+                found += world_pickups_touching(&world, 0, hits);
+            double t1 = now_ns();
+            for (int q = 0; q < QUERY_REPEATS; q++)
+                found -= touching_by_scan(&world, hits);
+            double t2 = now_ns();
+
+            grid_ns[group] += t1 - t0;
+            scan_ns[group] += t2 - t1;
+            queries[group] += QUERY_REPEATS;
+        }
+    }
+
+    printf("live pickups   queries   grid ns/query   scan ns/query\n");
+    for (int g = 0; g < GROUPS; g++)
+    {
+        if (queries[g] == 0)
+            continue;
+        printf("%4d - %-4d  %10ld   %13.1f   %13.1f\n", g * (MAX_PICKUPS + 1) / GROUPS,
+               (g + 1) * (MAX_PICKUPS + 1) / GROUPS - 1, queries[g], grid_ns[g] / queries[g],
+               scan_ns[g] / queries[g]);
+    }
+    if (found != 0)
+        printf("MISMATCH: grid and scan found different pickups\n");
+    return found != 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * Benchmark: post-processing per SIMD level and thread count
+ * Renders a game frame, then times postfx_apply with every effect on at
+ * each SIMD level this CPU has, and with the best level across thread
+ * counts. Reports time per frame and the share of a 60 Hz frame's 16.7 ms
+ * that is.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_postfx bench/bench_postfx.c postfx.c raster.c render.c game.c cpu_dispatch.c -I. -lm -lpthread
+ *
+ * Usage: bench_postfx [frames] [thread counts...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "postfx.h"
+
+#define FRAME_NS (1e9 / 60)
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Mean time per frame, shaking a little each frame
+static double time_frames(PostFx *fx, const Framebuffer *src, Framebuffer *dst, int frames, SimdLevel level)
+{
+    double start = now_ns();
+    for (int f = 0; f < frames; f++)
+    {
+        fx->shake_x = f % 7 - 3;
+        fx->shake_y = f % 5 - 2;
+        if (level == SIMD_LEVEL_COUNT)
+            postfx_apply(fx, src, dst);
+        else
+            postfx_apply_rows(fx, src, dst, 0, fx->height, level);
+    }
+    return (now_ns() - start) / frames;
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    if (frames <= 0)
+    {
+        fprintf(stderr, "Usage: %s [frames] [thread counts...]\n", argv[0]);
+        return 1;
+    }
+
+    Framebuffer src, dst;
+    static DrawList list;
+    World world;
+    if (!framebuffer_init(&src, SCREEN_WIDTH, SCREEN_HEIGHT) || !framebuffer_init(&dst, SCREEN_WIDTH, SCREEN_HEIGHT))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    world_reset(&world, 1);
+    for (int t = 0; t < 200; t++)
+        update_game(&world);
+    render_world(&list, &world);
+    raster_draw_list(&src, &list);
+
+    printf("%dx%d, all effects\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    PostFx fx;
+    postfx_init(&fx, SCREEN_WIDTH, SCREEN_HEIGHT, POSTFX_ALL, 1);
+    for (int level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (!simd_level_supported((SimdLevel)level))
+            continue;
+        double ns = time_frames(&fx, &src, &dst, frames, (SimdLevel)level);
+        printf("%-7s  1 thread  %7.3f ms per frame, %5.1f%% of 16.7 ms\n", simd_level_name((SimdLevel)level),
+               ns / 1e6, 100 * ns / FRAME_NS);
+    }
+    postfx_free(&fx);
+
+    int default_threads[] = {1, 2, 4, 8};
+    int num_counts = argc > 2 ? argc - 2 : 4;
+    for (int i = 0; i < num_counts; i++)
+    {
+        int threads = argc > 2 ? atoi(argv[i + 2]) : default_threads[i];
+        postfx_init(&fx, SCREEN_WIDTH, SCREEN_HEIGHT, POSTFX_ALL, threads);
+        double ns = time_frames(&fx, &src, &dst, frames, SIMD_LEVEL_COUNT);
+        printf("%-7s %2d threads %7.3f ms per frame, %5.1f%% of 16.7 ms\n", simd_level_name(fx.level),
+               fx.num_threads, ns / 1e6, 100 * ns / FRAME_NS);
+        postfx_free(&fx);
+    }
+
+    framebuffer_free(&src);
+    framebuffer_free(&dst);
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * Benchmark: search bots sharing one transposition table
+ * For each thread count, every thread plays the same set of courses with
+ * its own search bot, all probing and storing into one shared table, so
+ * threads reuse each other's work. Reports plies searched, table traffic,
+ * hit rate and the bots' scores; a run without a table gives the baseline.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_search bench/bench_search.c search_bot.c transposition.c game.c -I. -lm -lpthread
+ *
+ * Usage: bench_search [depth] [courses] [max ticks] -- [thread counts...]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "search_bot.h"
+
+#define MAX_THREADS 64
+#define TABLE_LOG2_ENTRIES 22
+
+typedef struct
+{
+    TransTable *table;
+    int depth;
+    int courses;
+    uint32_t max_ticks;
+    int first_course; // threads start on different courses and wrap around
+    SearchBot bot;
+    long total_score;
+} SearchJob;
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *play_courses(void *arg)
+{
+    SearchJob *job = arg;
+    search_bot_init(&job->bot, job->table, job->depth);
+    job->total_score = 0;
+
+    for (int c = 0; c < job->courses; c++)
+    {
+        World world;
+        world_reset(&world, 1 + (job->first_course + c) % job->courses);
+        while (!world.game_over && world.tick < job->max_ticks)
+        {
+            if (search_bot_wants_jump(&job->bot, &world))
+                world_jump(&world);
+            update_game(&world);
+        }
+        job->total_score += world.score;
+    }
+    return NULL;
+}
+
+static void run(TransTable *table, int threads, int depth, int courses, uint32_t max_ticks)
+{
+    SearchJob jobs[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+
+    if (table != NULL)
+        trans_clear(table);
+
+    double start = now_ns();
+    for (int t = 0; t < threads; t++)
+    {
+        jobs[t] = (SearchJob){table, depth, courses, max_ticks, t, {0}, 0};
+        pthread_create(&ids[t], NULL, play_courses, &jobs[t]);
+    }
+
+    TransStats stats = {0};
+    uint64_t nodes = 0;
+    long score = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(ids[t], NULL);
+        stats.probes += jobs[t].bot.stats.probes;
+        stats.hits += jobs[t].bot.stats.hits;
+        stats.stores += jobs[t].bot.stats.stores;
+        stats.evictions += jobs[t].bot.stats.evictions;
+        nodes += jobs[t].bot.nodes;
+        score += jobs[t].total_score;
+    }
+    double seconds = (now_ns() - start) / 1e9;
+
+    printf("%-7s %7d %8.2f %12llu %10.2f %10.2f %7.1f%% %7.1f%% %8.1f\n", table ? "shared" : "none", threads,
+           seconds, (unsigned long long)nodes, nodes / seconds / 1e6, (stats.probes + stats.stores) / seconds / 1e6,
+           stats.probes ? 100.0 * stats.hits / stats.probes : 0.0,
+           stats.stores ? 100.0 * stats.evictions / stats.stores : 0.0, (double)score / (threads * courses));
+}
+
+int main(int argc, char *argv[])
+{
+    int depth = 10;
+    int courses = 8;
+    uint32_t max_ticks = 3000;
+    int thread_counts[MAX_THREADS];
+    int num_thread_counts = 0;
+
+    int i = 1;
+    if (i < argc && strcmp(argv[i], "--") != 0)
+        depth = atoi(argv[i++]);
+    if (i < argc && strcmp(argv[i], "--") != 0)
+        courses = atoi(argv[i++]);
+    if (i < argc && strcmp(argv[i], "--") != 0)
+        max_ticks = (uint32_t)atoi(argv[i++]);
+    if (i < argc && strcmp(argv[i], "--") == 0)
+        i++;
+    for (; i < argc && num_thread_counts < MAX_THREADS; i++)
+    {
+        int threads = atoi(argv[i]);
+        if (threads >= 1 && threads <= MAX_THREADS)
+            thread_counts[num_thread_counts++] = threads;
+    }
+    if (num_thread_counts == 0)
+    {
+        thread_counts[0] = 1;
+        thread_counts[1] = 2;
+        thread_counts[2] = 4;
+        num_thread_counts = 3;
+    }
+    if (depth < 1 || depth > 255 || courses < 1)
+    {
+        fprintf(stderr, "Usage: %s [depth] [courses] [max ticks] -- [thread counts...]\n", argv[0]);
+        return 1;
+    }
+
+    TransTable table;
+    if (!trans_init(&table, TABLE_LOG2_ENTRIES))
+    {
+        fprintf(stderr, "Could not allocate the transposition table\n");
+        return 1;
+    }
+
+    printf("depth %d (%d ticks), %d courses of up to %u ticks per thread, 2^%d entries\n", depth,
+           depth * SEARCH_STEP_TICKS, courses, max_ticks, TABLE_LOG2_ENTRIES);
+    printf("table   threads  seconds        plies  Mplies/s  Mtable/s     hits  evicted    score\n");
+    run(NULL, 1, depth, courses, max_ticks);
+    for (int t = 0; t < num_thread_counts; t++)
+        run(&table, thread_counts[t], depth, courses, max_ticks);
+
+    trans_free(&table);
+    return 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * Benchmark: multiplayer server under a swarm of bots
+ * For each player count, runs a server on a localhost port in one thread
+ * and that many bot clients in another. Bots read their snapshots, look up
+ * the next gap on their own copy of the round's course and jump towards
+ * it, like the autopilot. The server ticks at TICK_RATE; reports the time
+ * each tick spends receiving, simulating and sending, the slowest tick,
+ * and the snapshot size with interest management.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_server bench/bench_server.c server.c snapshot.c course.c game.c -I. -lm -lpthread
+ *
+ * Usage: bench_server [ticks] [players...]
+ */
+
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "server.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef struct
+{
+    Server server;
+    uint32_t ticks;
+    double *tick_ns;
+    ServerTickStats stats;
+    atomic_bool done;
+} ServerJob;
+
+typedef struct
+{
+    NetClient client;
+    Course course; // of course_round
+    uint16_t course_round;
+    int aim_offset;
+    uint32_t snapshots;
+} Bot;
+
+static void *run_server(void *arg)
+{
+    ServerJob *job = arg;
+    double next_tick = now_ns();
+    for (uint32_t t = 0; t < job->ticks; t++)
+    {
+        double start = now_ns();
+        server_tick(&job->server, &job->stats);
+        job->tick_ns[t] = now_ns() - start;
+
+        next_tick += 1e9 / TICK_RATE;
+        double wait = next_tick - now_ns();
+        if (wait > 0)
+        {
+            struct timespec ts = {(time_t)(wait / 1e9), (long)((uint64_t)wait % 1000000000)};
+            nanosleep(&ts, NULL);
+        }
+    }
+    atomic_store(&job->done, true);
+    return NULL;
+}
+
+// Reacts to every waiting snapshot with a jump if the gap is above
+static void fly_bot(Bot *bot)
+{
+    Snapshot snap;
+    while (net_client_receive(&bot->client, &snap))
+    {
+        bot->snapshots++;
+        if (!snap.alive)
+            continue;
+
+        if (snap.round != bot->course_round)
+        {
+            course_free(&bot->course);
+            course_init(&bot->course, bot->client.seed + snap.round);
+            bot->course_round = snap.round;
+        }
+        uint32_t next = (uint32_t)snap.self.score;
+        int target = SCREEN_HEIGHT / 2;
+        if (next < course_pipes_at(snap.tick) && course_extend(&bot->course, next + 1))
+            target = course_gap_at(&bot->course, next, snap.tick);
+        if ((int)snap.self.y + BIRD_HEIGHT / 2 > target + bot->aim_offset && snap.self.velocity > 0)
+            net_client_jump(&bot->client, snap.round);
+    }
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static bool bench_players(int players, uint32_t ticks)
+{
+    ServerJob *job = calloc(1, sizeof(ServerJob));
+    Bot *bots = calloc(players, sizeof(Bot));
+    struct pollfd *fds = calloc(players, sizeof(struct pollfd));
+    double *tick_ns = calloc(ticks, sizeof(double));
+    if (job == NULL || bots == NULL || fds == NULL || tick_ns == NULL || !server_open(&job->server, 0, 1))
+    {
+        fprintf(stderr, "Could not start a server\n");
+        return false;
+    }
+    job->ticks = ticks;
+    job->tick_ns = tick_ns;
+    atomic_init(&job->done, false);
+
+    Rng rng;
+    rng_seed(&rng, players);
+    uint16_t port = server_port(&job->server);
+    for (int b = 0; b < players; b++)
+    {
+        if (!net_client_open(&bots[b].client, port))
+        {
+            fprintf(stderr, "Could not open a client\n");
+            return false;
+        }
+        course_init(&bots[b].course, 0);
+        bots[b].aim_offset = (int)rng_range(&rng, 80) - 40;
+        fds[b] = (struct pollfd){bots[b].client.socket, POLLIN, 0};
+    }
+
+    pthread_t server_thread;
+    pthread_create(&server_thread, NULL, run_server, job);
+    while (!atomic_load(&job->done))
+    {
+        if (poll(fds, players, 5) <= 0)
+            continue;
+        for (int b = 0; b < players; b++)
+        {
+            if (fds[b].revents & POLLIN)
+                fly_bot(&bots[b]);
+        }
+    }
+    pthread_join(server_thread, NULL);
+
+    uint32_t received = 0;
+    for (int b = 0; b < players; b++)
+    {
+        received += bots[b].snapshots;
+        net_client_close(&bots[b].client);
+        course_free(&bots[b].course);
+    }
+
+    const ServerTickStats *stats = &job->stats;
+    double total_ns = 0;
+    for (uint32_t t = 0; t < ticks; t++)
+        total_ns += tick_ns[t];
+    qsort(tick_ns, ticks, sizeof(double), compare_doubles);
+    printf("%3d players: %7.1f us per tick (receive %6.1f, simulate %5.1f, send %6.1f), p99 %7.1f us, "
+           "%5.0f bytes per snapshot, %4.1f%% of birds near, %u rounds, %.0f%% snapshots arrived\n",
+           players, total_ns / ticks / 1000, stats->receive_ns / ticks / 1000, stats->simulate_ns / ticks / 1000,
+           stats->send_ns / ticks / 1000, tick_ns[ticks * 99 / 100] / 1000,
+           stats->snapshots ? (double)stats->bytes / stats->snapshots : 0.0,
+           stats->near + stats->far ? 100.0 * stats->near / (stats->near + stats->far) : 0.0, job->server.round,
+           stats->snapshots ? 100.0 * received / stats->snapshots : 0.0);
+
+    server_close(&job->server);
+    free(tick_ns);
+    free(fds);
+    free(bots);
+    free(job);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t ticks = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 3 * TICK_RATE;
+    if (ticks == 0)
+    {
+        fprintf(stderr, "Usage: %s [ticks] [players...]\n", argv[0]);
+        return 1;
+    }
+
+    static const int default_players[] = {1, 10, 25, 50, 100};
+    int num_counts = argc > 2 ? argc - 2 : 5;
+    for (int i = 0; i < num_counts; i++)
+    {
+        int players = argc > 2 ? atoi(argv[2 + i]) : default_players[i];
+        if (players < 1 || players > MAX_PLAYERS)
+        {
+            fprintf(stderr, "Players must be 1 to %d\n", MAX_PLAYERS);
+            return 1;
+        }
+        if (!bench_players(players, ticks))
+            return 1;
+    }
+    return 0;
+}
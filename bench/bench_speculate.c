@@ -0,0 +1,127 @@
+/**
+ * Benchmark: input-to-frame latency with and without speculation
+ * Plays autopilot runs in the software renderer's loop. Without
+ * speculation, turning a tick's input into a finished frame means
+ * simulating the tick, building the draw list and rasterizing it. With
+ * speculation both outcomes were made while waiting, so it is one world
+ * copy. Reports the per-tick latency percentiles of both and what the
+ * speculation costs off the critical path, and checks the committed world
+ * matches the directly simulated one.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_speculate bench/bench_speculate.c speculate.c autopilot.c render.c raster.c game.c replay.c -I. -lm
+ *
+ * Usage: bench_speculate [runs] [max ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "autopilot.h"
+#include "speculate.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *ns, size_t count)
+{
+    qsort(ns, count, sizeof(double), compare_doubles);
+    printf("%-24s median %9.0f ns   p99 %9.0f ns   max %9.0f ns\n", name, ns[count / 2],
+           ns[count * 99 / 100], ns[count - 1]);
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 16;
+    uint32_t max_ticks = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 2000;
+
+    Framebuffer direct_frame;
+    Speculation spec;
+    if (!framebuffer_init(&direct_frame, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !speculation_init(&spec, SCREEN_WIDTH, SCREEN_HEIGHT))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    size_t capacity = (size_t)runs * max_ticks;
+    double *direct_ns = malloc(capacity * sizeof(double));
+    double *commit_ns = malloc(capacity * sizeof(double));
+    double *prepare_ns = malloc(capacity * sizeof(double));
+    if (direct_ns == NULL || commit_ns == NULL || prepare_ns == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    size_t count = 0;
+    int mismatches = 0;
+    DrawList list;
+    for (int r = 0; r < runs; r++)
+    {
+        Autopilot pilot;
+        autopilot_init(&pilot, 1 + r);
+        World direct, speculated;
+        world_reset(&direct, 1 + r);
+        speculated = direct;
+
+        while (!direct.game_over && direct.tick < max_ticks)
+        {
+            // Speculation runs while waiting for the tick, before the input is known
+            double t0 = now_ns();
+            speculation_prepare(&spec, &speculated, update_game);
+            double t1 = now_ns();
+
+            bool jump = autopilot_wants_jump(&pilot, &direct);
+
+            double t2 = now_ns();
+            if (jump)
+                world_jump(&direct);
+            update_game(&direct);
+            render_world(&list, &direct);
+            raster_draw_list(&direct_frame, &list);
+            double t3 = now_ns();
+            const Framebuffer *frame = speculation_commit(&spec, jump, &speculated);
+            double t4 = now_ns();
+
+            prepare_ns[count] = t1 - t0;
+            direct_ns[count] = t3 - t2;
+            commit_ns[count] = t4 - t3;
+            count++;
+
+            if (speculated.hash != direct.hash ||
+                memcmp(frame->pixels, direct_frame.pixels,
+                       (size_t)frame->pitch * frame->height * sizeof(uint32_t)) != 0)
+            {
+                mismatches++;
+                speculated = direct;
+            }
+        }
+    }
+
+    printf("%zu ticks over %d runs\n", count, runs);
+    report("direct (critical path)", direct_ns, count);
+    report("speculated commit", commit_ns, count);
+    report("speculation (idle time)", prepare_ns, count);
+    if (mismatches > 0)
+        printf("MISMATCH: %d ticks differed\n", mismatches);
+
+    free(direct_ns);
+    free(commit_ns);
+    free(prepare_ns);
+    speculation_free(&spec);
+    framebuffer_free(&direct_frame);
+    return mismatches > 0;
+}
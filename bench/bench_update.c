@@ -0,0 +1,145 @@
+/**
+ * Benchmark: reference update_game vs update_game_branchless
+ * Records random replays with the noisy autopilot, then plays every replay
+ * through both kernels, checking they agree and timing ticks in blocks so
+ * the spread (not just the mean) of the per-tick cost is visible.
+ *
+ * Compilation:
+ * gcc -O2 -o bench_update bench/bench_update.c autopilot.c game.c replay.c -I. -lm
+ *
+ * Usage: bench_update [num_replays] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "autopilot.h"
+#include "game.h"
+#include "replay.h"
+
+#define MAX_REPLAY_TICKS 20000
+#define BLOCK_TICKS 64
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Plays every replay through update, timing blocks of ticks; returns total ns
+static double run_kernel(const Replay *replays, int num_replays, UpdateFn update,
+                         World *finals, double *block_ns, int *num_blocks)
+{
+    double total = 0;
+    *num_blocks = 0;
+
+    for (int r = 0; r < num_replays; r++)
+    {
+        const Replay *replay = &replays[r];
+        World *world = &finals[r];
+        uint32_t next_jump = 0;
+
+        world_reset(world, replay->seed);
+        while (!world->game_over && world->tick < replay->num_ticks)
+        {
+            double start = now_ns();
+            for (int i = 0; i < BLOCK_TICKS && !world->game_over && world->tick < replay->num_ticks; i++)
+            {
+                if (next_jump < replay->num_jumps && replay->jump_ticks[next_jump] == world->tick)
+                {
+                    world_jump(world);
+                    next_jump++;
+                }
+                update(world);
+            }
+            double elapsed = now_ns() - start;
+            total += elapsed;
+            block_ns[(*num_blocks)++] = elapsed;
+        }
+    }
+
+    return total;
+}
+
+static void report(const char *name, double total_ns, uint64_t ticks, double *block_ns, int num_blocks)
+{
+    qsort(block_ns, num_blocks, sizeof(double), compare_doubles);
+    printf("%-12s %8.2f ns/tick   block p50 %7.2f  p99 %7.2f  max %8.2f ns/tick\n", name,
+           total_ns / ticks, block_ns[num_blocks / 2] / BLOCK_TICKS,
+           block_ns[num_blocks * 99 / 100] / BLOCK_TICKS, block_ns[num_blocks - 1] / BLOCK_TICKS);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_replays = argc > 1 ? atoi(argv[1]) : 2000;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+    if (num_replays <= 0)
+    {
+        fprintf(stderr, "Usage: %s [num_replays] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    Replay *replays = calloc(num_replays, sizeof(Replay));
+    World *reference = malloc(num_replays * sizeof(World));
+    World *branchless = malloc(num_replays * sizeof(World));
+
+    uint64_t ticks = 0;
+    for (int r = 0; r < num_replays; r++)
+    {
+        Autopilot pilot;
+        autopilot_init(&pilot, seed * 1000003 + r);
+        autopilot_record(&pilot, &replays[r], seed * 1000003 + r, MAX_REPLAY_TICKS);
+        ticks += replays[r].num_ticks;
+    }
+
+    // Generous upper bound: every replay can end with a partial block
+    size_t max_blocks = ticks / BLOCK_TICKS + num_replays;
+    double *block_ns = malloc(max_blocks * sizeof(double));
+    int num_blocks;
+
+    printf("%d random replays, %llu ticks\n", num_replays, (unsigned long long)ticks);
+
+    // Warm up caches and branch predictors before measuring either kernel
+    run_kernel(replays, num_replays, update_game, reference, block_ns, &num_blocks);
+
+    double reference_ns = run_kernel(replays, num_replays, update_game, reference, block_ns, &num_blocks);
+    report("reference", reference_ns, ticks, block_ns, num_blocks);
+
+    double branchless_ns = run_kernel(replays, num_replays, update_game_branchless, branchless, block_ns, &num_blocks);
+    report("branchless", branchless_ns, ticks, block_ns, num_blocks);
+
+    int mismatches = 0;
+    for (int r = 0; r < num_replays; r++)
+    {
+        const World *a = &reference[r], *b = &branchless[r];
+        if (a->tick != b->tick || a->score != b->score || a->game_over != b->game_over ||
+            a->birds.y[0] != b->birds.y[0] || a->birds.velocity[0] != b->birds.velocity[0])
+        {
+            if (mismatches++ == 0)
+            {
+                fprintf(stderr, "replay %d: kernels disagree (tick %u/%u, score %d/%d)\n", r,
+                        a->tick, b->tick, a->score, b->score);
+            }
+        }
+    }
+    printf("speedup      %8.2fx   %d mismatching replays\n", reference_ns / branchless_ns, mismatches);
+
+    for (int r = 0; r < num_replays; r++)
+    {
+        replay_free(&replays[r]);
+    }
+    free(replays);
+    free(reference);
+    free(branchless);
+    free(block_ns);
+    return mismatches != 0;
+}
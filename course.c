@@ -0,0 +1,204 @@
+/**
+ * Shared courses
+ */
+
+#include "course.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COURSE_CHUNK 64 // gaps made per extension
+
+void course_init(Course *course, uint64_t seed)
+{
+    course_init_features(course, seed, 0);
+}
+
+void course_init_features(Course *course, uint64_t seed, uint32_t features)
+{
+    // Seeded like world_reset_features
+    course->seed = seed;
+    rng_seed(&course->rng, seed);
+    course->gap_y = NULL;
+    course->count = 0;
+    course->capacity = 0;
+    course->features = features & WORLD_MOVING_GAPS;
+    rng_seed(&course->motion_rng, seed ^ 0x4D4F54494F4E2121ULL);
+    course->motion = NULL;
+    course->amplitude = NULL;
+    course->period = NULL;
+}
+
+void course_free(Course *course)
+{
+    free(course->gap_y);
+    free(course->motion);
+    free(course->amplitude);
+    free(course->period);
+    course->gap_y = NULL;
+    course->motion = NULL;
+    course->amplitude = NULL;
+    course->period = NULL;
+    course->count = 0;
+    course->capacity = 0;
+}
+
+bool course_extend(Course *course, uint32_t count)
+{
+    if (count <= course->count)
+        return true;
+
+    uint32_t target = (count + COURSE_CHUNK - 1) / COURSE_CHUNK * COURSE_CHUNK;
+    if (target > course->capacity)
+    {
+        uint32_t capacity = course->capacity ? course->capacity * 2 : COURSE_CHUNK;
+        while (capacity < target)
+            capacity *= 2;
+        uint16_t *gap_y = realloc(course->gap_y, capacity * sizeof(uint16_t));
+        if (gap_y == NULL)
+            return false;
+        course->gap_y = gap_y;
+
+        if (course->features & WORLD_MOVING_GAPS)
+        {
+            uint8_t *motion = realloc(course->motion, capacity * sizeof(uint8_t));
+            if (motion == NULL)
+                return false;
+            course->motion = motion;
+            int16_t *amplitude = realloc(course->amplitude, capacity * sizeof(int16_t));
+            if (amplitude == NULL)
+                return false;
+            course->amplitude = amplitude;
+            int16_t *period = realloc(course->period, capacity * sizeof(int16_t));
+            if (period == NULL)
+                return false;
+            course->period = period;
+        }
+        course->capacity = capacity;
+    }
+
+    // Same draws in the same order as create_pipe
+    for (uint32_t k = course->count; k < target; k++)
+    {
+        course->gap_y[k] = (uint16_t)(MIN_GAP_Y + rng_range(&course->rng, MAX_GAP_Y - MIN_GAP_Y));
+        if (course->motion != NULL)
+        {
+            gap_motion_draw(&course->motion_rng, course->gap_y[k], &course->motion[k], &course->amplitude[k],
+                            &course->period[k]);
+        }
+    }
+    course->count = target;
+    return true;
+}
+
+void course_world_reset(CourseWorld *world)
+{
+    world->y = SCREEN_HEIGHT / 2;
+    world->velocity = 0;
+    world->tick = 0;
+    world->score = 0;
+    world->game_over = false;
+}
+
+void course_world_jump(CourseWorld *world)
+{
+    world->velocity = JUMP_FORCE;
+}
+
+void course_world_step(CourseWorld *world, Course *course)
+{
+    world->tick++;
+    uint32_t spawned = course_pipes_at(world->tick);
+    if (spawned > course->count && !course_extend(course, spawned))
+    {
+        // Without the gap there is no way to go on
+        fprintf(stderr, "Out of memory extending course\n");
+        exit(1);
+    }
+
+    // Same float operations as update_game, so the bird matches bit for bit
+    world->velocity += GRAVITY;
+    world->y += world->velocity;
+    int rect_y = (int)world->y;
+    if (rect_y < 0)
+    {
+        rect_y = 0;
+        world->y = 0;
+        world->velocity = 0;
+    }
+
+    if (rect_y + BIRD_HEIGHT > SCREEN_HEIGHT - GROUND_HEIGHT)
+    {
+        world->game_over = true;
+    }
+
+    // Pipes are further apart than the bird is wide, so only the oldest pipe
+    // not yet passed can be level with it; passed pipes are behind it
+    uint32_t k = (uint32_t)world->score;
+    if (k < spawned)
+    {
+        int x = course_pipe_x(k, world->tick);
+        if (x + PIPE_WIDTH < BIRD_X)
+        {
+            world->score++;
+        }
+        else if (x < BIRD_X + BIRD_WIDTH && x + PIPE_WIDTH > BIRD_X)
+        {
+            int gap_y = course_gap_at(course, k, world->tick);
+            if (rect_y < gap_y - PIPE_GAP / 2 || rect_y + BIRD_HEIGHT > gap_y + PIPE_GAP / 2)
+            {
+                world->game_over = true;
+            }
+        }
+    }
+}
+
+void course_world_get_world(const CourseWorld *world, const Course *course, World *out)
+{
+    // Constant fields come from a fresh world
+    world_reset_features(out, course->seed, course->features);
+    out->birds.y[0] = world->y;
+    out->birds.velocity[0] = world->velocity;
+    out->birds.row[0] = (int)world->y;
+    out->score = world->score;
+    out->game_over = world->game_over;
+    out->tick = world->tick;
+
+    uint32_t spawned = course_pipes_at(world->tick);
+    out->last_pipe_tick = spawned * COURSE_PIPE_TICKS;
+
+    // The world's generator has made one gap per pipe so far
+    for (uint32_t k = 0; k < spawned; k++)
+    {
+        rng_range(&out->rng, MAX_GAP_Y - MIN_GAP_Y);
+        if (course->motion != NULL)
+        {
+            uint8_t motion;
+            int16_t amplitude, period;
+            gap_motion_draw(&out->motion_rng, course->gap_y[k], &motion, &amplitude, &period);
+        }
+    }
+
+    // Pipes still on screen (or not yet off its left edge), oldest first
+    Pipes *pipes = &out->pipes;
+    for (uint32_t k = 0; k < spawned; k++)
+    {
+        int x = course_pipe_x(k, world->tick);
+        if (x + PIPE_WIDTH < 0)
+            continue;
+        pipes->x[pipes->count] = x;
+        pipes->gap_y[pipes->count] = course_gap_at(course, k, world->tick);
+        pipes->passed[pipes->count] = k < (uint32_t)world->score;
+        if (course->motion != NULL)
+        {
+            pipes->gap_base[pipes->count] = course->gap_y[k];
+            pipes->motion[pipes->count] = course->motion[k];
+            pipes->amplitude[pipes->count] = course->amplitude[k];
+            pipes->period[pipes->count] = course->period[k];
+            pipes->spawn_tick[pipes->count] = (k + 1) * COURSE_PIPE_TICKS;
+        }
+        pipes->count++;
+    }
+
+    out->hash = world_hash_full(out);
+}
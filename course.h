@@ -0,0 +1,91 @@
+/**
+ * Shared courses
+ * A course is fully determined by its seed: pipe k appears at a fixed tick
+ * with a gap drawn from the seed's generator, and every pipe then scrolls
+ * at the same speed. So worlds playing the same seed (batch worlds, ghosts,
+ * search lines) can share one buffer of gap heights, generated once and
+ * extended on demand, and each keep only the bird, the tick (which fixes
+ * every pipe's scroll offset) and the index of the next pipe to pass.
+ *
+ * CourseWorld steps bit for bit like update_game, and course_world_get_world
+ * rebuilds the equivalent World for rendering or comparison.
+ *
+ * With WORLD_MOVING_GAPS the course also keeps each pipe's motion, and since
+ * that is a closed form in the pipe's age, course_gap_at gives any pipe's
+ * gap on any tick without stepping to it. Pickups are not modelled.
+ */
+
+#ifndef COURSE_H
+#define COURSE_H
+
+#include <stddef.h>
+
+#include "game.h"
+
+// Pipe k spawns on tick (k + 1) * COURSE_PIPE_TICKS
+#define COURSE_PIPE_TICKS (PIPE_SPAWN_TICKS + 1)
+
+typedef struct
+{
+    uint64_t seed;
+    Rng rng;         // generator state after the last gap made so far
+    uint16_t *gap_y; // gap centre of pipe k (the centre of its motion if it moves)
+    uint32_t count, capacity;
+
+    // Only with WORLD_MOVING_GAPS, NULL otherwise
+    uint32_t features;
+    Rng motion_rng;
+    uint8_t *motion; // GapMotion of pipe k
+    int16_t *amplitude, *period;
+} Course;
+
+typedef struct
+{
+    float y, velocity;
+    uint32_t tick;
+    int score; // pipes passed, so also the index of the next pipe to pass
+    bool game_over;
+} CourseWorld;
+
+void course_init(Course *course, uint64_t seed);
+
+// features may only hold WORLD_MOVING_GAPS
+void course_init_features(Course *course, uint64_t seed, uint32_t features);
+void course_free(Course *course);
+
+// Makes sure the first count pipes exist; once a course covers every tick
+// its worlds will reach, it is read-only and can be shared between threads
+bool course_extend(Course *course, uint32_t count);
+
+// Pipes spawned by the end of tick
+static inline uint32_t course_pipes_at(uint32_t tick)
+{
+    return tick / COURSE_PIPE_TICKS;
+}
+
+// Left edge of pipe k on tick, once it has spawned
+static inline int course_pipe_x(uint32_t k, uint32_t tick)
+{
+    return SCREEN_WIDTH - PIPE_SPEED * (int)(tick - (k + 1) * COURSE_PIPE_TICKS + 1);
+}
+
+// Gap centre of pipe k on tick, once it has spawned; pipe k must exist
+static inline int course_gap_at(const Course *course, uint32_t k, uint32_t tick)
+{
+    if (course->motion == NULL || course->motion[k] == GAP_STILL)
+        return course->gap_y[k];
+    return course->gap_y[k] + gap_motion_offset((GapMotion)course->motion[k], course->amplitude[k],
+                                                course->period[k], tick - (k + 1) * COURSE_PIPE_TICKS);
+}
+
+void course_world_reset(CourseWorld *world);
+void course_world_jump(CourseWorld *world);
+
+// One tick of update_game; extends the course when the world spawns a pipe
+// past its end
+void course_world_step(CourseWorld *world, Course *course);
+
+// The World update_game would have reached, hash included
+void course_world_get_world(const CourseWorld *world, const Course *course, World *out);
+
+#endif
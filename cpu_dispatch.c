@@ -0,0 +1,123 @@
+/**
+ * CPU feature dispatch
+ * cpuid/xgetbv detection and the FLAPPY_SIMD override.
+ */
+
+#include "cpu_dispatch.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define CPU_DISPATCH_X86 1
+#endif
+
+#define SIMD_ENV "FLAPPY_SIMD"
+
+static const char *level_names[SIMD_LEVEL_COUNT] = {"scalar", "sse2", "avx2", "avx512"};
+
+#ifdef CPU_DISPATCH_X86
+
+// XCR0: which register files the OS saves on context switch
+static uint64_t read_xcr0()
+{
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static SimdLevel detect()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return SIMD_SCALAR;
+
+    bool sse2 = edx & bit_SSE2;
+    bool osxsave = ecx & bit_OSXSAVE;
+    bool avx = ecx & bit_AVX;
+    if (!sse2)
+        return SIMD_SCALAR;
+    if (!osxsave || !avx)
+        return SIMD_SSE2;
+
+    // The OS must preserve YMM (bits 1-2) and, for AVX-512, opmask/ZMM (bits 5-7)
+    uint64_t xcr0 = read_xcr0();
+    if ((xcr0 & 0x6) != 0x6)
+        return SIMD_SSE2;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return SIMD_SSE2;
+    if (!(ebx & bit_AVX2))
+        return SIMD_SSE2;
+
+    bool avx512 = (ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && (xcr0 & 0xE0) == 0xE0;
+    return avx512 ? SIMD_AVX512 : SIMD_AVX2;
+}
+
+#else
+
+static SimdLevel detect()
+{
+    return SIMD_SCALAR;
+}
+
+#endif
+
+SimdLevel simd_detected_level()
+{
+    static int detected = -1;
+    if (detected < 0)
+    {
+        detected = detect();
+    }
+    return (SimdLevel)detected;
+}
+
+SimdLevel simd_level()
+{
+    static int level = -1;
+    if (level < 0)
+    {
+        SimdLevel detected = simd_detected_level();
+        level = detected;
+
+        const char *forced = getenv(SIMD_ENV);
+        if (forced != NULL && *forced != '\0')
+        {
+            int wanted = -1;
+            for (int i = 0; i < SIMD_LEVEL_COUNT; i++)
+            {
+                if (strcmp(forced, level_names[i]) == 0)
+                    wanted = i;
+            }
+
+            if (wanted < 0)
+            {
+                fprintf(stderr, "%s=%s not recognised, using %s\n", SIMD_ENV, forced, level_names[detected]);
+            }
+            else if (wanted > (int)detected)
+            {
+                fprintf(stderr, "%s=%s not supported by this CPU, using %s\n", SIMD_ENV, forced,
+                        level_names[detected]);
+            }
+            else
+            {
+                level = wanted;
+            }
+        }
+    }
+    return (SimdLevel)level;
+}
+
+bool simd_level_supported(SimdLevel level)
+{
+    return level <= simd_detected_level();
+}
+
+const char *simd_level_name(SimdLevel level)
+{
+    return level < SIMD_LEVEL_COUNT ? level_names[level] : "unknown";
+}
@@ -0,0 +1,35 @@
+/**
+ * CPU feature dispatch
+ * Detects the widest SIMD level this CPU and OS support (cpuid + xgetbv)
+ * once, so every kernel family can pick its variant from one place. The
+ * FLAPPY_SIMD environment variable (scalar, sse2, avx2, avx512) forces a
+ * lower level for testing; asking for more than the CPU has is clamped.
+ *
+ * Kernel families keep a table indexed by SimdLevel and fill levels they
+ * don't implement with the next narrower variant.
+ */
+
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include <stdbool.h>
+
+typedef enum
+{
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_AVX512, // AVX-512F + AVX-512BW
+    SIMD_LEVEL_COUNT,
+} SimdLevel;
+
+// Level kernels should use: detected, then lowered by FLAPPY_SIMD if set
+SimdLevel simd_level();
+
+// Highest level the hardware supports, ignoring any override
+SimdLevel simd_detected_level();
+
+bool simd_level_supported(SimdLevel level);
+const char *simd_level_name(SimdLevel level);
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * Dirty regions
+ */
+
+#include "dirty.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool dirty_init(DirtyTracker *tracker, int width, int height, int depth)
+{
+    if (width > MAX_DIRTY_WIDTH)
+        return false;
+
+    // Rows padded to a cache line
+    tracker->pitch = ((size_t)width * depth + 63) & ~(size_t)63;
+    tracker->shown = aligned_alloc(64, tracker->pitch * height);
+    if (tracker->shown == NULL)
+        return false;
+
+    tracker->width = width;
+    tracker->height = height;
+    tracker->depth = depth;
+    tracker->valid = false;
+    tracker->num_rects = 0;
+    return true;
+}
+
+void dirty_free(DirtyTracker *tracker)
+{
+    free(tracker->shown);
+    tracker->shown = NULL;
+}
+
+void dirty_invalidate(DirtyTracker *tracker)
+{
+    tracker->valid = false;
+}
+
+static Rect bounding_box(Rect a, Rect b)
+{
+    int x0 = a.x < b.x ? a.x : b.x;
+    int y0 = a.y < b.y ? a.y : b.y;
+    int x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    int y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    return (Rect){x0, y0, x1 - x0, y1 - y0};
+}
+
+// Adds a run of changed tiles, growing a rect from the band above if one
+// has the same columns
+static void add_run(DirtyTracker *tracker, Rect run)
+{
+    for (int i = 0; i < tracker->num_rects; i++)
+    {
+        Rect *rect = &tracker->rects[i];
+        if (rect->x == run.x && rect->w == run.w && rect->y + rect->h == run.y)
+        {
+            rect->h += run.h;
+            return;
+        }
+    }
+
+    if (tracker->num_rects < MAX_DIRTY_RECTS)
+    {
+        tracker->rects[tracker->num_rects++] = run;
+        return;
+    }
+
+    // Too scattered to be worth separate uploads; one box takes the rest
+    Rect box = run;
+    for (int i = 0; i < tracker->num_rects; i++)
+        box = bounding_box(box, tracker->rects[i]);
+    tracker->rects[0] = box;
+    tracker->num_rects = 1;
+}
+
+// Marks the tiles of band that differ from shown and brings them up to
+// date. Most rows of most bands are unchanged, so whole rows are compared
+// first and only rows that differ are looked at tile by tile.
+static void update_band(DirtyTracker *tracker, const uint8_t *frame, size_t pitch, int y, int h, bool *dirty,
+                        int num_tiles)
+{
+    size_t row_bytes = (size_t)tracker->width * tracker->depth;
+    size_t tile_bytes = (size_t)DIRTY_TILE_WIDTH * tracker->depth;
+    memset(dirty, 0, num_tiles * sizeof(bool));
+    for (int row = y; row < y + h; row++)
+    {
+        const uint8_t *in = frame + (size_t)row * pitch;
+        uint8_t *copy = tracker->shown + (size_t)row * tracker->pitch;
+        if (memcmp(in, copy, row_bytes) == 0)
+            continue;
+        for (int t = 0; t < num_tiles; t++)
+        {
+            size_t offset = t * tile_bytes;
+            size_t bytes = row_bytes - offset < tile_bytes ? row_bytes - offset : tile_bytes;
+            if (memcmp(in + offset, copy + offset, bytes) != 0)
+            {
+                memcpy(copy + offset, in + offset, bytes);
+                dirty[t] = true;
+            }
+        }
+    }
+}
+
+int dirty_update(DirtyTracker *tracker, const void *pixels, size_t pitch)
+{
+    const uint8_t *frame = pixels;
+    tracker->num_rects = 0;
+
+    if (!tracker->valid)
+    {
+        for (int y = 0; y < tracker->height; y++)
+        {
+            memcpy(tracker->shown + (size_t)y * tracker->pitch, frame + (size_t)y * pitch,
+                   (size_t)tracker->width * tracker->depth);
+        }
+        tracker->rects[0] = (Rect){0, 0, tracker->width, tracker->height};
+        tracker->num_rects = 1;
+        tracker->valid = true;
+        return 1;
+    }
+
+    bool dirty[(MAX_DIRTY_WIDTH + DIRTY_TILE_WIDTH - 1) / DIRTY_TILE_WIDTH];
+    int num_tiles = (tracker->width + DIRTY_TILE_WIDTH - 1) / DIRTY_TILE_WIDTH;
+    for (int y = 0; y < tracker->height; y += DIRTY_BAND_HEIGHT)
+    {
+        int h = tracker->height - y < DIRTY_BAND_HEIGHT ? tracker->height - y : DIRTY_BAND_HEIGHT;
+        update_band(tracker, frame, pitch, y, h, dirty, num_tiles);
+
+        // Runs of dirty tiles
+        for (int t = 0; t < num_tiles;)
+        {
+            if (!dirty[t])
+            {
+                t++;
+                continue;
+            }
+            int first = t;
+            while (t < num_tiles && dirty[t])
+                t++;
+            int x0 = first * DIRTY_TILE_WIDTH;
+            int x1 = t * DIRTY_TILE_WIDTH < tracker->width ? t * DIRTY_TILE_WIDTH : tracker->width;
+            add_run(tracker, (Rect){x0, y, x1 - x0, h});
+        }
+    }
+    return tracker->num_rects;
+}
@@ -0,0 +1,53 @@
+/**
+ * Dirty regions
+ * Finds what changed in a software frame since the last one, so only that
+ * goes to the texture. The frame is compared with a copy of the last one
+ * in tiles of DIRTY_TILE_WIDTH pixels by DIRTY_BAND_HEIGHT rows; changed
+ * tiles in a band merge into runs, and runs with the same columns in
+ * consecutive bands merge into one taller rect. A moving pipe edge becomes
+ * one thin rect however tall the pipe is, where whole changed rows would
+ * cover nearly the entire screen.
+ *
+ * Works on any pixel size, so it can follow an indexed framebuffer at a
+ * quarter of the comparison cost.
+ */
+
+#ifndef DIRTY_H
+#define DIRTY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define DIRTY_TILE_WIDTH 32
+#define DIRTY_BAND_HEIGHT 8
+#define MAX_DIRTY_RECTS 64
+#define MAX_DIRTY_WIDTH 4096 // widest frame a tracker takes
+
+typedef struct
+{
+    int width, height;
+    int depth;      // bytes per pixel
+    size_t pitch;   // bytes per row of shown
+    uint8_t *shown; // the last frame, as it was uploaded
+    bool valid;     // false until a first frame, or after dirty_invalidate
+
+    int num_rects;
+    Rect rects[MAX_DIRTY_RECTS];
+} DirtyTracker;
+
+bool dirty_init(DirtyTracker *tracker, int width, int height, int depth);
+void dirty_free(DirtyTracker *tracker);
+
+// Makes the next frame dirty everywhere, for when the texture no longer
+// holds what the tracker last saw
+void dirty_invalidate(DirtyTracker *tracker);
+
+// Compares pixels (pitch bytes per row) with the last frame, remembers the
+// changed tiles and fills tracker->rects with them; returns the rect
+// count. Past MAX_DIRTY_RECTS the rects merge into their bounding box.
+int dirty_update(DirtyTracker *tracker, const void *pixels, size_t pitch);
+
+#endif
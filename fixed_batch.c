@@ -0,0 +1,451 @@
+/**
+ * Fixed-point batch
+ * Pipe spawning (shared) plus scalar, SSE2, AVX2 and AVX-512BW step
+ * kernels. The SIMD kernels are compiled with target attributes and picked
+ * through cpu_dispatch.
+ */
+
+#include "fixed_batch.h"
+#include "rng_wide.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIXED_X86 1
+#endif
+
+#define FIXED_ALIGN 64
+
+// Horizontal extent of the bird, which never moves sideways
+#define FIXED_BIRD_LEFT (SCREEN_WIDTH / 4)
+#define FIXED_BIRD_RIGHT (FIXED_BIRD_LEFT + BIRD_WIDTH)
+
+// y / 10 for 0 <= y < 16384 as a 16x16 high multiply, the way the SIMD kernels do it
+#define FIXED_ROW_MULTIPLIER 6554
+
+static void *fixed_alloc(size_t size)
+{
+    size = (size + FIXED_ALIGN - 1) / FIXED_ALIGN * FIXED_ALIGN;
+    void *p = aligned_alloc(FIXED_ALIGN, size);
+    if (p != NULL)
+    {
+        memset(p, 0, size);
+    }
+    return p;
+}
+
+bool fixed_batch_init(FixedBatch *batch, int num_worlds)
+{
+    memset(batch, 0, sizeof(*batch));
+    batch->num_worlds = num_worlds;
+    batch->num_lanes = (num_worlds + FIXED_LANES - 1) / FIXED_LANES * FIXED_LANES;
+
+    size_t lanes = batch->num_lanes;
+    bool ok = (batch->jump = fixed_alloc(lanes)) != NULL;
+    ok = ok && (batch->y = fixed_alloc(lanes * sizeof(int16_t))) != NULL;
+    ok = ok && (batch->velocity = fixed_alloc(lanes * sizeof(int16_t))) != NULL;
+    ok = ok && (batch->alive = fixed_alloc(lanes * sizeof(int16_t))) != NULL;
+    ok = ok && (batch->score = fixed_alloc(lanes * sizeof(int16_t))) != NULL;
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        ok = ok && (batch->pipe_x[p] = fixed_alloc(lanes * sizeof(int16_t))) != NULL;
+        ok = ok && (batch->pipe_gap_y[p] = fixed_alloc(lanes * sizeof(int16_t))) != NULL;
+        ok = ok && (batch->pipe_passed[p] = fixed_alloc(lanes * sizeof(int16_t))) != NULL;
+    }
+    ok = ok && (batch->tick = fixed_alloc(lanes * sizeof(uint32_t))) != NULL;
+    ok = ok && (batch->last_pipe_tick = fixed_alloc(lanes * sizeof(uint32_t))) != NULL;
+    ok = ok && (batch->next_pipe = fixed_alloc(lanes)) != NULL;
+    ok = ok && (batch->spawn = fixed_alloc(lanes)) != NULL;
+    ok = ok && (batch->gap = fixed_alloc(lanes * sizeof(uint32_t))) != NULL;
+    for (int k = 0; k < 4; k++)
+    {
+        ok = ok && (batch->rng[k] = fixed_alloc(lanes * sizeof(uint32_t))) != NULL;
+    }
+
+    if (!ok)
+    {
+        fixed_batch_free(batch);
+        return false;
+    }
+
+    // Padding lanes are never alive, so the kernels can run whole vectors
+    for (int i = 0; i < num_worlds; i++)
+    {
+        fixed_batch_reset_world(batch, i, i);
+    }
+    return true;
+}
+
+void fixed_batch_free(FixedBatch *batch)
+{
+    free(batch->jump);
+    free(batch->y);
+    free(batch->velocity);
+    free(batch->alive);
+    free(batch->score);
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        free(batch->pipe_x[p]);
+        free(batch->pipe_gap_y[p]);
+        free(batch->pipe_passed[p]);
+    }
+    free(batch->tick);
+    free(batch->last_pipe_tick);
+    free(batch->next_pipe);
+    free(batch->spawn);
+    free(batch->gap);
+    for (int k = 0; k < 4; k++)
+    {
+        free(batch->rng[k]);
+    }
+    memset(batch, 0, sizeof(*batch));
+}
+
+void fixed_batch_reset_world(FixedBatch *batch, int index, uint64_t seed)
+{
+    Rng rng;
+    rng_seed(&rng, seed);
+
+    batch->jump[index] = 0;
+    batch->y[index] = SCREEN_HEIGHT / 2 * FIXED_SCALE;
+    batch->velocity[index] = 0;
+    batch->alive[index] = -1;
+    batch->score[index] = 0;
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        batch->pipe_x[p][index] = SCREEN_WIDTH * 2; // Position off-screen
+        batch->pipe_gap_y[p][index] = 0;
+        batch->pipe_passed[p][index] = 0;
+    }
+    batch->tick[index] = 0;
+    batch->last_pipe_tick[index] = 0;
+    batch->next_pipe[index] = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        batch->rng[k][index] = rng.s[k];
+    }
+}
+
+int fixed_bird_row(int16_t y)
+{
+    return (int)(((uint32_t)(uint16_t)y * FIXED_ROW_MULTIPLIER) >> 16);
+}
+
+// Advances every live world's clock and spawns its pipes, all lanes that
+// are due drawing their gaps together
+static void fixed_spawn_pipes(FixedBatch *batch)
+{
+    int any_spawn = 0;
+    for (int i = 0; i < batch->num_lanes; i++)
+    {
+        uint32_t alive = batch->alive[i] != 0;
+        batch->tick[i] += alive;
+        batch->spawn[i] = alive & (batch->tick[i] - batch->last_pipe_tick[i] > PIPE_SPAWN_TICKS);
+        any_spawn |= batch->spawn[i];
+    }
+    if (!any_spawn)
+        return;
+
+    rng_range_wide(batch->rng, batch->spawn, MAX_GAP_Y - MIN_GAP_Y, batch->gap, batch->num_lanes);
+
+    for (int i = 0; i < batch->num_lanes; i++)
+    {
+        if (!batch->spawn[i])
+            continue;
+
+        int slot = batch->next_pipe[i];
+        batch->pipe_x[slot][i] = SCREEN_WIDTH;
+        batch->pipe_gap_y[slot][i] = (int16_t)(MIN_GAP_Y + batch->gap[i]);
+        batch->pipe_passed[slot][i] = 0;
+        batch->next_pipe[i] = (uint8_t)((slot + 1) % MAX_PIPES);
+        batch->last_pipe_tick[i] = batch->tick[i];
+    }
+}
+
+// Reference kernel: one lane at a time with the same 16-bit arithmetic
+static void fixed_step_scalar(FixedBatch *batch)
+{
+    for (int i = 0; i < batch->num_lanes; i++)
+    {
+        int16_t alive = batch->alive[i];
+        int16_t jump = batch->jump[i] ? -1 : 0;
+        int16_t velocity = batch->velocity[i];
+        int16_t y = batch->y[i];
+
+        int16_t new_velocity = (int16_t)(((jump & alive) ? FIXED_JUMP : velocity) + FIXED_GRAVITY);
+        int16_t new_y = (int16_t)(y + new_velocity);
+        if (new_y < 0)
+        {
+            new_y = 0;
+            new_velocity = 0;
+        }
+        if (alive)
+        {
+            velocity = new_velocity;
+            y = new_y;
+        }
+        batch->velocity[i] = velocity;
+        batch->y[i] = y;
+
+        int16_t row = (int16_t)fixed_bird_row(y);
+        int16_t dead = (int16_t)(row + BIRD_HEIGHT) > SCREEN_HEIGHT - GROUND_HEIGHT ? -1 : 0;
+        int16_t score = batch->score[i];
+
+        for (int p = 0; p < MAX_PIPES; p++)
+        {
+            int16_t x = batch->pipe_x[p][i];
+            int16_t gap_y = batch->pipe_gap_y[p][i];
+            int16_t passed = batch->pipe_passed[p][i];
+
+            int16_t active = alive & (x <= SCREEN_WIDTH + 100 ? -1 : 0);
+            x = (int16_t)(x - (active & PIPE_SPEED));
+            batch->pipe_x[p][i] = x;
+
+            int16_t right = (int16_t)(x + PIPE_WIDTH);
+            int16_t newly_passed = active & ~passed & (right < FIXED_BIRD_LEFT ? -1 : 0);
+            batch->pipe_passed[p][i] = passed | newly_passed;
+            score = (int16_t)(score - newly_passed);
+
+            int16_t overlap_x = (x < FIXED_BIRD_RIGHT && right > FIXED_BIRD_LEFT) ? -1 : 0;
+            int16_t outside_gap = (row < (int16_t)(gap_y - PIPE_GAP / 2) ||
+                                   (int16_t)(row + BIRD_HEIGHT) > (int16_t)(gap_y + PIPE_GAP / 2))
+                                      ? -1
+                                      : 0;
+            dead |= active & overlap_x & outside_gap;
+        }
+
+        batch->score[i] = score;
+        batch->alive[i] = alive & ~dead;
+    }
+}
+
+#ifdef FIXED_X86
+
+// SSE2 has no blendv; masks are all ones or all zeros per lane
+__attribute__((target("sse2"))) static inline __m128i select_x8(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+__attribute__((target("sse2"))) static void fixed_step_sse2(FixedBatch *batch)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i gravity = _mm_set1_epi16(FIXED_GRAVITY);
+    const __m128i jump_velocity = _mm_set1_epi16(FIXED_JUMP);
+    const __m128i row_multiplier = _mm_set1_epi16(FIXED_ROW_MULTIPLIER);
+    const __m128i bird_height = _mm_set1_epi16(BIRD_HEIGHT);
+    const __m128i ground = _mm_set1_epi16(SCREEN_HEIGHT - GROUND_HEIGHT);
+    const __m128i park_limit = _mm_set1_epi16(SCREEN_WIDTH + 101);
+    const __m128i speed = _mm_set1_epi16(PIPE_SPEED);
+    const __m128i pipe_width = _mm_set1_epi16(PIPE_WIDTH);
+    const __m128i bird_left = _mm_set1_epi16(FIXED_BIRD_LEFT);
+    const __m128i bird_right = _mm_set1_epi16(FIXED_BIRD_RIGHT);
+    const __m128i half_gap = _mm_set1_epi16(PIPE_GAP / 2);
+
+    for (int i = 0; i < batch->num_lanes; i += 8)
+    {
+        __m128i alive = _mm_load_si128((const __m128i *)&batch->alive[i]);
+        __m128i jump = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)&batch->jump[i]), zero);
+        jump = _mm_and_si128(_mm_cmpgt_epi16(jump, zero), alive);
+        __m128i velocity = _mm_load_si128((const __m128i *)&batch->velocity[i]);
+        __m128i y = _mm_load_si128((const __m128i *)&batch->y[i]);
+
+        // Bird: jump, fall, clamp to the ceiling; dead lanes keep their state
+        __m128i new_velocity = _mm_add_epi16(select_x8(jump, jump_velocity, velocity), gravity);
+        __m128i new_y = _mm_add_epi16(y, new_velocity);
+        __m128i above = _mm_cmpgt_epi16(zero, new_y);
+        new_velocity = _mm_andnot_si128(above, new_velocity);
+        new_y = _mm_andnot_si128(above, new_y);
+        velocity = select_x8(alive, new_velocity, velocity);
+        y = select_x8(alive, new_y, y);
+        _mm_store_si128((__m128i *)&batch->velocity[i], velocity);
+        _mm_store_si128((__m128i *)&batch->y[i], y);
+
+        __m128i row = _mm_mulhi_epu16(y, row_multiplier);
+        __m128i row_bottom = _mm_add_epi16(row, bird_height);
+        __m128i dead = _mm_cmpgt_epi16(row_bottom, ground);
+        __m128i score = _mm_load_si128((const __m128i *)&batch->score[i]);
+
+        for (int p = 0; p < MAX_PIPES; p++)
+        {
+            __m128i x = _mm_load_si128((const __m128i *)&batch->pipe_x[p][i]);
+            __m128i gap_y = _mm_load_si128((const __m128i *)&batch->pipe_gap_y[p][i]);
+            __m128i passed = _mm_load_si128((const __m128i *)&batch->pipe_passed[p][i]);
+
+            __m128i active = _mm_and_si128(alive, _mm_cmpgt_epi16(park_limit, x));
+            x = _mm_sub_epi16(x, _mm_and_si128(active, speed));
+            _mm_store_si128((__m128i *)&batch->pipe_x[p][i], x);
+
+            __m128i right = _mm_add_epi16(x, pipe_width);
+            __m128i newly_passed = _mm_andnot_si128(passed, _mm_and_si128(active, _mm_cmpgt_epi16(bird_left, right)));
+            _mm_store_si128((__m128i *)&batch->pipe_passed[p][i], _mm_or_si128(passed, newly_passed));
+            score = _mm_sub_epi16(score, newly_passed);
+
+            __m128i overlap_x = _mm_and_si128(_mm_cmpgt_epi16(bird_right, x), _mm_cmpgt_epi16(right, bird_left));
+            __m128i outside_gap = _mm_or_si128(_mm_cmpgt_epi16(_mm_sub_epi16(gap_y, half_gap), row),
+                                               _mm_cmpgt_epi16(row_bottom, _mm_add_epi16(gap_y, half_gap)));
+            dead = _mm_or_si128(dead, _mm_and_si128(active, _mm_and_si128(overlap_x, outside_gap)));
+        }
+
+        _mm_store_si128((__m128i *)&batch->score[i], score);
+        _mm_store_si128((__m128i *)&batch->alive[i], _mm_andnot_si128(dead, alive));
+    }
+}
+
+__attribute__((target("avx2"))) static void fixed_step_avx2(FixedBatch *batch)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i gravity = _mm256_set1_epi16(FIXED_GRAVITY);
+    const __m256i jump_velocity = _mm256_set1_epi16(FIXED_JUMP);
+    const __m256i row_multiplier = _mm256_set1_epi16(FIXED_ROW_MULTIPLIER);
+    const __m256i bird_height = _mm256_set1_epi16(BIRD_HEIGHT);
+    const __m256i ground = _mm256_set1_epi16(SCREEN_HEIGHT - GROUND_HEIGHT);
+    const __m256i park_limit = _mm256_set1_epi16(SCREEN_WIDTH + 101);
+    const __m256i speed = _mm256_set1_epi16(PIPE_SPEED);
+    const __m256i pipe_width = _mm256_set1_epi16(PIPE_WIDTH);
+    const __m256i bird_left = _mm256_set1_epi16(FIXED_BIRD_LEFT);
+    const __m256i bird_right = _mm256_set1_epi16(FIXED_BIRD_RIGHT);
+    const __m256i half_gap = _mm256_set1_epi16(PIPE_GAP / 2);
+
+    for (int i = 0; i < batch->num_lanes; i += 16)
+    {
+        __m256i alive = _mm256_load_si256((const __m256i *)&batch->alive[i]);
+        __m256i jump = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)&batch->jump[i]));
+        jump = _mm256_and_si256(_mm256_cmpgt_epi16(jump, zero), alive);
+        __m256i velocity = _mm256_load_si256((const __m256i *)&batch->velocity[i]);
+        __m256i y = _mm256_load_si256((const __m256i *)&batch->y[i]);
+
+        // Bird: jump, fall, clamp to the ceiling; dead lanes keep their state
+        __m256i new_velocity = _mm256_add_epi16(_mm256_blendv_epi8(velocity, jump_velocity, jump), gravity);
+        __m256i new_y = _mm256_add_epi16(y, new_velocity);
+        __m256i above = _mm256_cmpgt_epi16(zero, new_y);
+        new_velocity = _mm256_andnot_si256(above, new_velocity);
+        new_y = _mm256_andnot_si256(above, new_y);
+        velocity = _mm256_blendv_epi8(velocity, new_velocity, alive);
+        y = _mm256_blendv_epi8(y, new_y, alive);
+        _mm256_store_si256((__m256i *)&batch->velocity[i], velocity);
+        _mm256_store_si256((__m256i *)&batch->y[i], y);
+
+        __m256i row = _mm256_mulhi_epu16(y, row_multiplier);
+        __m256i row_bottom = _mm256_add_epi16(row, bird_height);
+        __m256i dead = _mm256_cmpgt_epi16(row_bottom, ground);
+        __m256i score = _mm256_load_si256((const __m256i *)&batch->score[i]);
+
+        for (int p = 0; p < MAX_PIPES; p++)
+        {
+            __m256i x = _mm256_load_si256((const __m256i *)&batch->pipe_x[p][i]);
+            __m256i gap_y = _mm256_load_si256((const __m256i *)&batch->pipe_gap_y[p][i]);
+            __m256i passed = _mm256_load_si256((const __m256i *)&batch->pipe_passed[p][i]);
+
+            __m256i active = _mm256_and_si256(alive, _mm256_cmpgt_epi16(park_limit, x));
+            x = _mm256_sub_epi16(x, _mm256_and_si256(active, speed));
+            _mm256_store_si256((__m256i *)&batch->pipe_x[p][i], x);
+
+            __m256i right = _mm256_add_epi16(x, pipe_width);
+            __m256i newly_passed = _mm256_andnot_si256(passed, _mm256_and_si256(active, _mm256_cmpgt_epi16(bird_left, right)));
+            _mm256_store_si256((__m256i *)&batch->pipe_passed[p][i], _mm256_or_si256(passed, newly_passed));
+            score = _mm256_sub_epi16(score, newly_passed);
+
+            __m256i overlap_x = _mm256_and_si256(_mm256_cmpgt_epi16(bird_right, x), _mm256_cmpgt_epi16(right, bird_left));
+            __m256i outside_gap = _mm256_or_si256(_mm256_cmpgt_epi16(_mm256_sub_epi16(gap_y, half_gap), row),
+                                                  _mm256_cmpgt_epi16(row_bottom, _mm256_add_epi16(gap_y, half_gap)));
+            dead = _mm256_or_si256(dead, _mm256_and_si256(active, _mm256_and_si256(overlap_x, outside_gap)));
+        }
+
+        _mm256_store_si256((__m256i *)&batch->score[i], score);
+        _mm256_store_si256((__m256i *)&batch->alive[i], _mm256_andnot_si256(dead, alive));
+    }
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void fixed_step_avx512(FixedBatch *batch)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i gravity = _mm512_set1_epi16(FIXED_GRAVITY);
+    const __m512i jump_velocity = _mm512_set1_epi16(FIXED_JUMP);
+    const __m512i row_multiplier = _mm512_set1_epi16(FIXED_ROW_MULTIPLIER);
+    const __m512i bird_height = _mm512_set1_epi16(BIRD_HEIGHT);
+    const __m512i ground = _mm512_set1_epi16(SCREEN_HEIGHT - GROUND_HEIGHT);
+    const __m512i park_limit = _mm512_set1_epi16(SCREEN_WIDTH + 100);
+    const __m512i speed = _mm512_set1_epi16(PIPE_SPEED);
+    const __m512i pipe_width = _mm512_set1_epi16(PIPE_WIDTH);
+    const __m512i bird_left = _mm512_set1_epi16(FIXED_BIRD_LEFT);
+    const __m512i bird_right = _mm512_set1_epi16(FIXED_BIRD_RIGHT);
+    const __m512i half_gap = _mm512_set1_epi16(PIPE_GAP / 2);
+
+    for (int i = 0; i < batch->num_lanes; i += 32)
+    {
+        __m512i alive_lanes = _mm512_load_si512(&batch->alive[i]);
+        __mmask32 alive = _mm512_test_epi16_mask(alive_lanes, alive_lanes);
+        __m512i jump_lanes = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)&batch->jump[i]));
+        __mmask32 jump = _mm512_test_epi16_mask(jump_lanes, jump_lanes) & alive;
+        __m512i velocity = _mm512_load_si512(&batch->velocity[i]);
+        __m512i y = _mm512_load_si512(&batch->y[i]);
+
+        // Bird: jump, fall, clamp to the ceiling; dead lanes keep their state
+        __m512i new_velocity = _mm512_add_epi16(_mm512_mask_mov_epi16(velocity, jump, jump_velocity), gravity);
+        __m512i new_y = _mm512_add_epi16(y, new_velocity);
+        __mmask32 clamp = _mm512_cmplt_epi16_mask(new_y, zero);
+        new_velocity = _mm512_mask_mov_epi16(new_velocity, clamp, zero);
+        new_y = _mm512_mask_mov_epi16(new_y, clamp, zero);
+        velocity = _mm512_mask_mov_epi16(velocity, alive, new_velocity);
+        y = _mm512_mask_mov_epi16(y, alive, new_y);
+        _mm512_store_si512(&batch->velocity[i], velocity);
+        _mm512_store_si512(&batch->y[i], y);
+
+        __m512i row = _mm512_mulhi_epu16(y, row_multiplier);
+        __m512i row_bottom = _mm512_add_epi16(row, bird_height);
+        __mmask32 dead = _mm512_cmpgt_epi16_mask(row_bottom, ground);
+        __m512i score = _mm512_load_si512(&batch->score[i]);
+
+        for (int p = 0; p < MAX_PIPES; p++)
+        {
+            __m512i x = _mm512_load_si512(&batch->pipe_x[p][i]);
+            __m512i gap_y = _mm512_load_si512(&batch->pipe_gap_y[p][i]);
+            __m512i passed_lanes = _mm512_load_si512(&batch->pipe_passed[p][i]);
+            __mmask32 passed = _mm512_test_epi16_mask(passed_lanes, passed_lanes);
+
+            __mmask32 active = _mm512_mask_cmple_epi16_mask(alive, x, park_limit);
+            x = _mm512_mask_sub_epi16(x, active, x, speed);
+            _mm512_store_si512(&batch->pipe_x[p][i], x);
+
+            __m512i right = _mm512_add_epi16(x, pipe_width);
+            __mmask32 newly_passed = _mm512_mask_cmplt_epi16_mask(active & ~passed, right, bird_left);
+            _mm512_store_si512(&batch->pipe_passed[p][i], _mm512_movm_epi16(passed | newly_passed));
+            score = _mm512_mask_add_epi16(score, newly_passed, score, _mm512_set1_epi16(1));
+
+            __mmask32 overlap_x = _mm512_mask_cmplt_epi16_mask(active, x, bird_right) &
+                                  _mm512_cmpgt_epi16_mask(right, bird_left);
+            __mmask32 outside_gap = _mm512_cmplt_epi16_mask(row, _mm512_sub_epi16(gap_y, half_gap)) |
+                                    _mm512_cmpgt_epi16_mask(row_bottom, _mm512_add_epi16(gap_y, half_gap));
+            dead |= overlap_x & outside_gap;
+        }
+
+        _mm512_store_si512(&batch->score[i], score);
+        _mm512_store_si512(&batch->alive[i], _mm512_movm_epi16(alive & ~dead));
+    }
+}
+
+#endif
+
+typedef void (*FixedKernel)(FixedBatch *batch);
+
+// Indexed by SimdLevel
+#ifdef FIXED_X86
+static const FixedKernel kernels[SIMD_LEVEL_COUNT] = {fixed_step_scalar, fixed_step_sse2, fixed_step_avx2, fixed_step_avx512};
+#else
+static const FixedKernel kernels[SIMD_LEVEL_COUNT] = {fixed_step_scalar, fixed_step_scalar, fixed_step_scalar, fixed_step_scalar};
+#endif
+
+void fixed_batch_step_with(FixedBatch *batch, SimdLevel level)
+{
+    fixed_spawn_pipes(batch);
+    kernels[level](batch);
+    memset(batch->jump, 0, batch->num_lanes);
+}
+
+void fixed_batch_step(FixedBatch *batch)
+{
+    fixed_batch_step_with(batch, simd_level());
+}
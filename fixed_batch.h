@@ -0,0 +1,61 @@
+/**
+ * Fixed-point batch
+ * Worlds stepped 8 (SSE2), 16 (AVX2) or 32 (AVX-512BW) at a time in
+ * int16 lanes.
+ * Bird height and speed are kept in tenths of a pixel so gravity (0.4) and
+ * the jump (-8) are exact integers; everything else is whole pixels, and
+ * all of it fits in 16 bits on an 800x600 screen.
+ *
+ * This is its own numeric model, not a bit-for-bit copy of the float
+ * update_game(): the bird is clamped as soon as it goes above the ceiling
+ * and its pixel row is y / 10 rounded down. What is guaranteed is that the
+ * scalar and every SIMD kernel produce identical state.
+ */
+
+#ifndef FIXED_BATCH_H
+#define FIXED_BATCH_H
+
+#include "cpu_dispatch.h"
+#include "game.h"
+
+#define FIXED_SCALE 10
+#define FIXED_GRAVITY 4   // GRAVITY * FIXED_SCALE
+#define FIXED_JUMP (-80)  // JUMP_FORCE * FIXED_SCALE
+#define FIXED_LANES 32    // storage is padded to the widest kernel
+
+typedef struct
+{
+    int num_worlds;
+    int num_lanes;    // num_worlds rounded up to FIXED_LANES
+    uint8_t *jump;    // per-world input for the next step, cleared by the step
+
+    int16_t *y;        // bird top in tenths of a pixel
+    int16_t *velocity; // tenths of a pixel per tick
+    int16_t *alive;    // -1 while running, 0 once game over
+    int16_t *score;
+    int16_t *pipe_x[MAX_PIPES];
+    int16_t *pipe_gap_y[MAX_PIPES];
+    int16_t *pipe_passed[MAX_PIPES]; // -1 once passed
+
+    // Pipe spawning runs per world outside the SIMD kernel
+    uint32_t *tick;
+    uint32_t *last_pipe_tick;
+    uint8_t *next_pipe;
+    uint8_t *spawn;
+    uint32_t *gap;
+    uint32_t *rng[4];
+} FixedBatch;
+
+bool fixed_batch_init(FixedBatch *batch, int num_worlds);
+void fixed_batch_free(FixedBatch *batch);
+void fixed_batch_reset_world(FixedBatch *batch, int index, uint64_t seed);
+
+// Bird row in whole pixels, as the kernels compute it
+int fixed_bird_row(int16_t y);
+
+// Steps every live world by one tick with the kernel for simd_level(), or
+// for a given (supported) level
+void fixed_batch_step(FixedBatch *batch);
+void fixed_batch_step_with(FixedBatch *batch, SimdLevel level);
+
+#endif
@@ -3,69 +3,255 @@
  * Built incrementally from the minimal working version
  *
  * Compilation (EndeavourOS/Arch):
- * gcc -o flappy_bird flappy_bird.c -I/usr/include/SDL2 -lSDL2 -lm
+ * gcc -o flappy_bird flappy_bird.c game.c replay.c render.c raster.c speculate.c audio.c postfx.c dirty.c cpu_dispatch.c -I/usr/include/SDL2 -lSDL2 -lm -lpthread
+ * (or `make game`)
+ *
+ * Controls:
+ *   Space / left click  jump (restart after game over)
+ *   P                   pause / resume
+ *   + / -               speed up / slow down (0.25x to 16x)
+ *   0                   back to normal speed
+ *   Esc                 quit
+ *
+ * Options:
+ *   --seed N            play every run on course N
+ *   --record FILE       save the last finished run as a replay
+ *   --replay FILE       play back a replay instead of taking input
+ *   --turbo N           with --replay: simulate flat out, rendering every
+ *                       Nth tick (0 = at display rate)
+ *   --software          draw frames with the built-in rasterizer and show
+ *                       them through a texture instead of SDL draw calls
+ *   --full-upload       with --software: upload whole frames rather than
+ *                       only the rects that changed
+ *   --indexed           with --software: draw into an 8-bit palette
+ *                       framebuffer and expand it only on upload
+ *   --pickups           scatter coins and shields between the pipes
+ *   --moving-gaps       let some gaps slide up and down
+ *   --speculate         with --software: render both outcomes of the next
+ *                       tick ahead of time and show a jump the moment it
+ *                       is pressed instead of at the next frame
+ *   --audio-buffer N    audio device buffer in frames (default 256, about
+ *                       5 ms); smaller is lower latency
+ *   --mute              no sound
+ *   --postfx LIST       with --software: full-screen effects, any of
+ *                       scanlines, grade, vignette, shake (or all), comma
+ *                       separated
+ *   --postfx-threads N  threads applying the effects (default: one per CPU)
  */
 
 #include <SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
 
-// Window dimensions
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 600
-
-// Game constants
-#define BIRD_WIDTH 40
-#define BIRD_HEIGHT 30
-#define GRAVITY 0.4
-#define JUMP_FORCE -8.0
-#define PIPE_WIDTH 60
-#define PIPE_GAP 170
-#define PIPE_SPEED 3
-#define MAX_PIPES 10
-#define PIPE_SPAWN_TIME 1500 // milliseconds
-
-// Game structures
-typedef struct
-{
-    float x, y;
-    float velocity;
-    SDL_Rect rect;
-} Bird;
+#include "audio.h"
+#include "dirty.h"
+#include "game.h"
+#include "postfx.h"
+#include "raster.h"
+#include "render.h"
+#include "replay.h"
+#include "speculate.h"
 
-typedef struct
-{
-    int x;
-    int gap_y;
-    bool passed;
-    SDL_Rect top_rect;
-    SDL_Rect bottom_rect;
-} Pipe;
+// Front-end timing
+#define FRAME_MS 16            // ~60 FPS render cap
+#define MAX_TICKS_PER_FRAME 64 // avoid spiralling after a long stall
+
+// Audio
+#define DEFAULT_AUDIO_BUFFER 256 // frames
+#define MUSIC_GAIN 0.35f
+
+// Screen shake after a crash; it plays out after the ticks have stopped,
+// so it runs by frames
+#define SHAKE_FRAMES 20
+#define SHAKE_PIXELS 12 // at the start, easing to 0
 
 // Function prototypes
-void create_pipe();
-bool check_collision(SDL_Rect a, SDL_Rect b);
-void update_game();
+bool open_audio();
 void render_game(SDL_Renderer *renderer);
 void reset_game();
+void handle_event(SDL_Event *e, bool *quit);
+void change_time_scale(int delta);
+void update_window_title();
+void run_tick();
 
 // Global variables
-Bird bird;
-Pipe pipes[MAX_PIPES];
-int next_pipe = 0;
-bool game_over = false;
-int score = 0;
-Uint32 last_pipe_time = 0;
+World world;
+uint64_t game_seed = 0;
+bool fixed_seed = false;
+uint32_t game_features = 0; // WORLD_* flags for new runs
+
+// Replay recording and playback
+Replay recording = {0};
+Replay playback = {0};
+const char *record_path = NULL;
+bool replay_mode = false;
+uint32_t playback_jump = 0; // next entry of playback.jump_ticks
+int turbo_every = -1;       // render every Nth tick in turbo mode, -1 = off
+
+// Time control
+static const double time_scales[] = {0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0};
+#define NUM_TIME_SCALES ((int)(sizeof(time_scales) / sizeof(time_scales[0])))
+#define DEFAULT_TIME_SCALE 2 // index of 1.0x
+int time_scale_index = DEFAULT_TIME_SCALE;
+bool paused = false;
+bool jump_requested = false;
+bool needs_redraw = false;
+SDL_Window *window = NULL;
+
+// Rendering
+DrawList draw_list;
+bool software_render = false;
+Framebuffer framebuffer = {0};
+SDL_Texture *framebuffer_texture = NULL; // set when software_render is on
+bool indexed_render = false;
+IndexedFramebuffer indexed_framebuffer = {0}; // drawn into instead when set
+bool full_upload = false;
+bool dirty_on = false;      // upload only what changed, tracked per frame kind
+DirtyTracker dirty_argb;    // frames uploaded as they are
+DirtyTracker dirty_indexed; // indexed frames expanded rect by rect
+
+// Speculation: both outcomes of the next tick, rendered while waiting
+bool speculate = false;
+Speculation speculation = {0};
+const Framebuffer *ready_frame = NULL; // prerendered frame of the current world, until rendered
+
+// Sound: the mixer runs on SDL's audio thread, fed through its command ring
+bool mute = false;
+int audio_buffer_frames = DEFAULT_AUDIO_BUFFER;
+Mixer mixer;
+SDL_AudioDeviceID audio_device = 0; // 0 when there is no sound
+
+// Post-processing: effects applied to each software frame on its way to
+// the texture
+uint32_t postfx_effects = 0;
+int postfx_threads = 0; // 0 = one per CPU
+PostFx postfx;
+Framebuffer postfx_frame = {0};
+bool postfx_on = false;
+int shake_frames = 0; // left of the current shake
+Rng shake_rng;
 
 int main(int argc, char *args[])
 {
     printf("Starting Flappy Bird...\n");
 
-    // Seed random number generator
-    srand(time(NULL));
+    const char *replay_path = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(args[i], "--seed") == 0 && i + 1 < argc)
+        {
+            game_seed = strtoull(args[++i], NULL, 10);
+            fixed_seed = true;
+        }
+        else if (strcmp(args[i], "--record") == 0 && i + 1 < argc)
+        {
+            record_path = args[++i];
+        }
+        else if (strcmp(args[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replay_path = args[++i];
+        }
+        else if (strcmp(args[i], "--turbo") == 0 && i + 1 < argc)
+        {
+            turbo_every = atoi(args[++i]);
+            if (turbo_every < 0)
+                turbo_every = 0;
+        }
+        else if (strcmp(args[i], "--software") == 0)
+        {
+            software_render = true;
+        }
+        else if (strcmp(args[i], "--full-upload") == 0)
+        {
+            software_render = true;
+            full_upload = true;
+        }
+        else if (strcmp(args[i], "--indexed") == 0)
+        {
+            software_render = true;
+            indexed_render = true;
+        }
+        else if (strcmp(args[i], "--pickups") == 0)
+        {
+            game_features |= WORLD_PICKUPS;
+        }
+        else if (strcmp(args[i], "--moving-gaps") == 0)
+        {
+            game_features |= WORLD_MOVING_GAPS;
+        }
+        else if (strcmp(args[i], "--speculate") == 0)
+        {
+            software_render = true;
+            speculate = true;
+        }
+        else if (strcmp(args[i], "--audio-buffer") == 0 && i + 1 < argc)
+        {
+            audio_buffer_frames = atoi(args[++i]);
+            if (audio_buffer_frames < 16)
+            {
+                audio_buffer_frames = 16;
+            }
+            if (audio_buffer_frames > 8192)
+            {
+                audio_buffer_frames = 8192;
+            }
+        }
+        else if (strcmp(args[i], "--mute") == 0)
+        {
+            mute = true;
+        }
+        else if (strcmp(args[i], "--postfx") == 0 && i + 1 < argc)
+        {
+            if (!postfx_parse(args[++i], &postfx_effects))
+            {
+                fprintf(stderr, "Unknown effect in %s\n", args[i]);
+                return 1;
+            }
+            software_render = true;
+        }
+        else if (strcmp(args[i], "--postfx-threads") == 0 && i + 1 < argc)
+        {
+            postfx_threads = atoi(args[++i]);
+        }
+        else
+        {
+            fprintf(stderr,
+                    "Usage: %s [--seed N] [--record FILE] [--replay FILE [--turbo N]] [--pickups]\n"
+                    "       [--moving-gaps] [--software [--speculate] [--indexed] [--full-upload]]\n"
+                    "       [--audio-buffer N] [--mute] [--postfx LIST] [--postfx-threads N]\n",
+                    args[0]);
+            return 1;
+        }
+    }
+
+    if (replay_path != NULL)
+    {
+        if (!replay_load(&playback, replay_path))
+        {
+            fprintf(stderr, "Could not load replay %s\n", replay_path);
+            return 1;
+        }
+        replay_mode = true;
+        game_seed = playback.seed;
+        game_features = playback.features;
+        fixed_seed = true;
+        printf("Replaying %s: seed %llu, %u ticks, score %d\n", replay_path,
+               (unsigned long long)playback.seed, playback.num_ticks, playback.score);
+    }
+    else if (turbo_every >= 0)
+    {
+        fprintf(stderr, "--turbo needs --replay\n");
+        return 1;
+    }
+    else if (!fixed_seed)
+    {
+        game_seed = (uint64_t)time(NULL);
+    }
 
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) < 0)
@@ -75,7 +261,7 @@ int main(int argc, char *args[])
     }
 
     // Create window
-    SDL_Window *window = SDL_CreateWindow(
+    window = SDL_CreateWindow(
         "Flappy Bird",
         SDL_WINDOWPOS_CENTERED,
         SDL_WINDOWPOS_CENTERED,
@@ -107,6 +293,59 @@ int main(int argc, char *args[])
         }
     }
 
+    if (software_render)
+    {
+        framebuffer_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                                SCREEN_WIDTH, SCREEN_HEIGHT);
+        if (framebuffer_texture == NULL || !framebuffer_init(&framebuffer, SCREEN_WIDTH, SCREEN_HEIGHT))
+        {
+            fprintf(stderr, "Software rendering unavailable, using SDL draw calls: %s\n", SDL_GetError());
+            if (framebuffer_texture != NULL)
+                SDL_DestroyTexture(framebuffer_texture);
+            framebuffer_texture = NULL;
+        }
+    }
+    if (indexed_render &&
+        (framebuffer_texture == NULL || !indexed_framebuffer_init(&indexed_framebuffer, SCREEN_WIDTH, SCREEN_HEIGHT)))
+    {
+        indexed_render = false;
+    }
+    if (framebuffer_texture != NULL && !full_upload)
+    {
+        // Falls back to whole-frame uploads if the trackers don't fit
+        dirty_on = dirty_init(&dirty_argb, SCREEN_WIDTH, SCREEN_HEIGHT, sizeof(uint32_t));
+        if (dirty_on && !dirty_init(&dirty_indexed, SCREEN_WIDTH, SCREEN_HEIGHT, 1))
+        {
+            dirty_free(&dirty_argb);
+            dirty_on = false;
+        }
+    }
+    if (speculate && (framebuffer_texture == NULL || replay_mode ||
+                      !speculation_init(&speculation, SCREEN_WIDTH, SCREEN_HEIGHT)))
+    {
+        // Replays have no input latency to hide
+        speculate = false;
+    }
+    if (postfx_effects != 0 && framebuffer_texture != NULL)
+    {
+        int threads = postfx_threads > 0 ? postfx_threads : SDL_GetCPUCount();
+        postfx_on = framebuffer_init(&postfx_frame, SCREEN_WIDTH, SCREEN_HEIGHT);
+        if (postfx_on && !postfx_init(&postfx, SCREEN_WIDTH, SCREEN_HEIGHT, postfx_effects, threads))
+        {
+            framebuffer_free(&postfx_frame);
+            postfx_on = false;
+        }
+        if (!postfx_on)
+            fprintf(stderr, "Post-processing unavailable\n");
+        rng_seed(&shake_rng, (uint64_t)time(NULL));
+    }
+
+    // Turbo playback would only make noise
+    if (!mute && turbo_every < 0)
+    {
+        open_audio();
+    }
+
     // Initialize game state
     reset_game();
 
@@ -117,306 +356,572 @@ int main(int argc, char *args[])
     // First render to show initial state
     render_game(renderer);
 
-    Uint32 last_time = SDL_GetTicks();
+    Uint64 counter_freq = SDL_GetPerformanceFrequency();
+    Uint64 last_counter = SDL_GetPerformanceCounter();
+    double tick_accumulator = 0.0;
 
-    while (!quit)
+    if (turbo_every >= 0)
     {
-        // Handle events
-        while (SDL_PollEvent(&e) != 0)
+        // Turbo playback: step the replay flat out and only present now and
+        // then, so SDL_RenderPresent stays off the simulation's hot path
+        Uint64 start = SDL_GetPerformanceCounter();
+        Uint64 display_interval = counter_freq * FRAME_MS / 1000;
+        Uint64 last_present = start;
+        uint32_t ticks_since_render = 0;
+
+        while (!quit && !world.game_over && world.tick < playback.num_ticks)
         {
-            if (e.type == SDL_QUIT)
+            run_tick();
+            ticks_since_render++;
+
+            bool render_due;
+            if (turbo_every > 0)
             {
-                quit = true;
+                render_due = ticks_since_render >= (uint32_t)turbo_every;
             }
-            else if (e.type == SDL_KEYDOWN)
+            else
             {
-                switch (e.key.keysym.sym)
-                {
-                case SDLK_SPACE:
-                    if (game_over)
-                    {
-                        reset_game();
-                    }
-                    else
-                    {
-                        bird.velocity = JUMP_FORCE;
-                    }
-                    break;
-                case SDLK_ESCAPE:
-                    quit = true;
-                    break;
-                }
+                // Checking the clock every tick would cost more than the tick
+                render_due = (world.tick & 255) == 0 &&
+                             SDL_GetPerformanceCounter() - last_present >= display_interval;
             }
-            else if (e.type == SDL_MOUSEBUTTONDOWN)
+
+            if (render_due)
             {
-                if (e.button.button == SDL_BUTTON_LEFT)
+                render_game(renderer);
+                last_present = SDL_GetPerformanceCounter();
+                ticks_since_render = 0;
+
+                while (SDL_PollEvent(&e) != 0)
                 {
-                    if (game_over)
-                    {
-                        reset_game();
-                    }
-                    else
-                    {
-                        bird.velocity = JUMP_FORCE;
-                    }
+                    handle_event(&e, &quit);
                 }
             }
         }
 
-        // Update game state
-        if (!game_over)
+        double elapsed_ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / counter_freq;
+        double played_ms = world.tick * TICK_MS;
+        printf("Turbo: %u ticks in %.1f ms (%.0fx real time)\n", world.tick, elapsed_ms,
+               elapsed_ms > 0 ? played_ms / elapsed_ms : 0.0);
+
+        // Show the final frame and wait around like a normal finished replay
+        turbo_every = -1;
+        paused = true;
+        render_game(renderer);
+        update_window_title();
+    }
+
+    while (!quit)
+    {
+        if (paused)
         {
-            update_game();
+            // Idle until something happens instead of re-rendering a still frame
+            if (SDL_WaitEvent(&e))
+            {
+                handle_event(&e, &quit);
+            }
+            while (!quit && SDL_PollEvent(&e) != 0)
+            {
+                handle_event(&e, &quit);
+            }
+
+            if (needs_redraw)
+            {
+                render_game(renderer);
+                needs_redraw = false;
+            }
+
+            // Don't count the paused time towards the simulation
+            last_counter = SDL_GetPerformanceCounter();
+            tick_accumulator = 0.0;
+            continue;
+        }
+
+        // Handle events
+        while (SDL_PollEvent(&e) != 0)
+        {
+            handle_event(&e, &quit);
+        }
+
+        // Work out how many fixed ticks the elapsed (scaled) time covers
+        Uint64 now = SDL_GetPerformanceCounter();
+        double elapsed_ms = (double)(now - last_counter) * 1000.0 / counter_freq;
+        last_counter = now;
+
+        tick_accumulator += elapsed_ms * time_scales[time_scale_index] / TICK_MS;
+        int ticks = (int)tick_accumulator;
+        if (ticks > MAX_TICKS_PER_FRAME)
+        {
+            ticks = MAX_TICKS_PER_FRAME;
+            tick_accumulator = 0.0;
+        }
+        else
+        {
+            tick_accumulator -= ticks;
+        }
+
+        // Update game state, rendering only the last of the ticks
+        for (int i = 0; i < ticks && !world.game_over; i++)
+        {
+            if (replay_mode && world.tick >= playback.num_ticks)
+                break;
+            run_tick();
+            needs_redraw = true;
+        }
+        if (shake_frames > 0 && !paused)
+        {
+            shake_frames--;
+            needs_redraw = true;
         }
 
         // Render
-        render_game(renderer);
+        if (needs_redraw)
+        {
+            render_game(renderer);
+            needs_redraw = false;
+        }
+
+        // Get both outcomes of the next tick ready while there is time
+        if (speculate && !speculation.ready && !world.game_over)
+        {
+            speculation_prepare(&speculation, &world, update_game);
+        }
 
         // Cap frame rate
-        SDL_Delay(16); // ~60 FPS
+        Uint64 frame_ms = (SDL_GetPerformanceCounter() - now) * 1000 / counter_freq;
+        if (frame_ms < FRAME_MS)
+        {
+            if (speculate)
+            {
+                // Wait on the event queue rather than sleeping, so a jump can
+                // be shown as soon as it arrives from the frame made for it
+                if (SDL_WaitEventTimeout(&e, FRAME_MS - (int)frame_ms))
+                {
+                    handle_event(&e, &quit);
+                }
+                if (jump_requested && speculation.ready && !paused)
+                {
+                    run_tick();
+                    render_game(renderer);
+                    // The tick came early, so take it out of the time owed
+                    tick_accumulator -= 1.0;
+                }
+            }
+            else
+            {
+                SDL_Delay(FRAME_MS - (Uint32)frame_ms);
+            }
+        }
     }
 
     // Clean up
+    if (audio_device != 0)
+    {
+        SDL_CloseAudioDevice(audio_device);
+        mixer_free(&mixer);
+    }
+    if (framebuffer_texture != NULL)
+    {
+        SDL_DestroyTexture(framebuffer_texture);
+        framebuffer_free(&framebuffer);
+    }
+    if (indexed_render)
+    {
+        indexed_framebuffer_free(&indexed_framebuffer);
+    }
+    if (dirty_on)
+    {
+        dirty_free(&dirty_argb);
+        dirty_free(&dirty_indexed);
+    }
+    if (speculate)
+    {
+        speculation_free(&speculation);
+    }
+    if (postfx_on)
+    {
+        postfx_free(&postfx);
+        framebuffer_free(&postfx_frame);
+    }
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 
+    replay_free(&recording);
+    replay_free(&playback);
+
     printf("Game exited cleanly.\n");
     return 0;
 }
 
-void create_pipe()
+void handle_event(SDL_Event *e, bool *quit)
 {
-    Pipe new_pipe;
-    new_pipe.x = SCREEN_WIDTH;
+    if (e->type == SDL_QUIT)
+    {
+        *quit = true;
+    }
+    else if (e->type == SDL_WINDOWEVENT)
+    {
+        if (e->window.event == SDL_WINDOWEVENT_EXPOSED)
+        {
+            needs_redraw = true;
+        }
+    }
+    else if (e->type == SDL_RENDER_TARGETS_RESET || e->type == SDL_RENDER_DEVICE_RESET)
+    {
+        // The texture may have lost what was uploaded before
+        if (dirty_on)
+        {
+            dirty_invalidate(&dirty_argb);
+            dirty_invalidate(&dirty_indexed);
+        }
+        needs_redraw = true;
+    }
+    else if (e->type == SDL_KEYDOWN)
+    {
+        switch (e->key.keysym.sym)
+        {
+        case SDLK_SPACE:
+            if (paused || replay_mode)
+            {
+                break;
+            }
+            if (world.game_over)
+            {
+                reset_game();
+                needs_redraw = true;
+            }
+            else
+            {
+                // Applied at the start of the next tick so input stays tick-aligned
+                jump_requested = true;
+            }
+            break;
+        case SDLK_p:
+            paused = !paused;
+            if (audio_device != 0)
+            {
+                SDL_PauseAudioDevice(audio_device, paused);
+            }
+            update_window_title();
+            break;
+        case SDLK_EQUALS:
+        case SDLK_PLUS:
+        case SDLK_KP_PLUS:
+            change_time_scale(1);
+            break;
+        case SDLK_MINUS:
+        case SDLK_KP_MINUS:
+            change_time_scale(-1);
+            break;
+        case SDLK_0:
+            change_time_scale(DEFAULT_TIME_SCALE - time_scale_index);
+            break;
+        case SDLK_ESCAPE:
+            *quit = true;
+            break;
+        }
+    }
+    else if (e->type == SDL_MOUSEBUTTONDOWN)
+    {
+        if (e->button.button == SDL_BUTTON_LEFT && !paused && !replay_mode)
+        {
+            if (world.game_over)
+            {
+                reset_game();
+                needs_redraw = true;
+            }
+            else
+            {
+                jump_requested = true;
+            }
+        }
+    }
+}
 
-    // Ensure gap is within screen bounds
-    int min_gap_y = PIPE_GAP / 2 + 50;
-    int max_gap_y = SCREEN_HEIGHT - PIPE_GAP / 2 - 50;
-    new_pipe.gap_y = min_gap_y + rand() % (max_gap_y - min_gap_y);
+void change_time_scale(int delta)
+{
+    int index = time_scale_index + delta;
+    if (index < 0)
+        index = 0;
+    if (index >= NUM_TIME_SCALES)
+        index = NUM_TIME_SCALES - 1;
+
+    time_scale_index = index;
+    printf("Time scale: %gx\n", time_scales[time_scale_index]);
+    update_window_title();
+}
 
-    new_pipe.passed = false;
+void update_window_title()
+{
+    char title[64];
 
-    new_pipe.top_rect.x = new_pipe.x;
-    new_pipe.top_rect.y = 0;
-    new_pipe.top_rect.w = PIPE_WIDTH;
-    new_pipe.top_rect.h = new_pipe.gap_y - PIPE_GAP / 2;
+    if (paused)
+    {
+        snprintf(title, sizeof(title), "Flappy Bird [paused]");
+    }
+    else if (time_scale_index != DEFAULT_TIME_SCALE)
+    {
+        snprintf(title, sizeof(title), "Flappy Bird [%gx]", time_scales[time_scale_index]);
+    }
+    else
+    {
+        snprintf(title, sizeof(title), "Flappy Bird");
+    }
 
-    new_pipe.bottom_rect.x = new_pipe.x;
-    new_pipe.bottom_rect.y = new_pipe.gap_y + PIPE_GAP / 2;
-    new_pipe.bottom_rect.w = PIPE_WIDTH;
-    new_pipe.bottom_rect.h = SCREEN_HEIGHT - new_pipe.bottom_rect.y;
+    SDL_SetWindowTitle(window, title);
+}
 
-    pipes[next_pipe] = new_pipe;
-    next_pipe = (next_pipe + 1) % MAX_PIPES;
+// SDL's audio thread
+static void audio_callback(void *userdata, Uint8 *stream, int len)
+{
+    mixer_render(userdata, (float *)stream, len / (int)sizeof(float));
 }
 
-bool check_collision(SDL_Rect a, SDL_Rect b)
+bool open_audio()
 {
-    // Check if two rectangles are colliding
-    int left_a = a.x;
-    int right_a = a.x + a.w;
-    int top_a = a.y;
-    int bottom_a = a.y + a.h;
-
-    int left_b = b.x;
-    int right_b = b.x + b.w;
-    int top_b = b.y;
-    int bottom_b = b.y + b.h;
-
-    if (bottom_a <= top_b)
-        return false;
-    if (top_a >= bottom_b)
-        return false;
-    if (right_a <= left_b)
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0 || !mixer_init(&mixer, game_seed))
+    {
+        fprintf(stderr, "No sound: %s\n", SDL_GetError());
         return false;
-    if (left_a >= right_b)
+    }
+
+    // SDL converts to whatever the device wants, so the mixer can keep
+    // one format
+    SDL_AudioSpec want = {0};
+    want.freq = AUDIO_RATE;
+    want.format = AUDIO_F32SYS;
+    want.channels = 1;
+    want.samples = (Uint16)audio_buffer_frames;
+    want.callback = audio_callback;
+    want.userdata = &mixer;
+    audio_device = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+    if (audio_device == 0)
+    {
+        fprintf(stderr, "No sound: %s\n", SDL_GetError());
+        mixer_free(&mixer);
         return false;
+    }
 
+    mixer_set_music(&mixer, MUSIC_GAIN);
+    SDL_PauseAudioDevice(audio_device, 0);
     return true;
 }
 
-void update_game()
+void run_tick()
 {
-    // Check if it's time to spawn a new pipe
-    Uint32 current_time = SDL_GetTicks();
-    if (current_time - last_pipe_time > PIPE_SPAWN_TIME)
+    // Apply this tick's input, either from the player or from the replay
+    bool jump = false;
+    if (replay_mode)
     {
-        create_pipe();
-        last_pipe_time = current_time;
+        if (playback_jump < playback.num_jumps && playback.jump_ticks[playback_jump] == world.tick)
+        {
+            jump = true;
+            playback_jump++;
+        }
     }
-
-    // Update bird position
-    bird.velocity += GRAVITY;
-    bird.y += bird.velocity;
-    bird.rect.y = (int)bird.y;
-
-    // Check for collision with ceiling
-    if (bird.rect.y < 0)
+    else
     {
-        bird.rect.y = 0;
-        bird.y = 0;
-        bird.velocity = 0;
+        jump = jump_requested;
+        jump_requested = false;
     }
 
-    // Check for collision with ground
-    if (bird.rect.y + bird.rect.h > SCREEN_HEIGHT - 20)
+    if (jump && record_path != NULL)
     {
-        game_over = true;
+        replay_add_jump(&recording, world.tick);
     }
 
-    // Update pipes and check for collisions
-    for (int i = 0; i < MAX_PIPES; i++)
+    int old_score = world.score, old_coins = world.coins;
+    bool was_over = world.game_over;
+    if (speculate && speculation.ready)
     {
-        // Skip pipes that are way off-screen
-        if (pipes[i].x > SCREEN_WIDTH + 100)
-            continue;
+        // Both outcomes were simulated and rendered ahead of time
+        ready_frame = speculation_commit(&speculation, jump, &world);
+    }
+    else
+    {
+        if (jump)
+        {
+            world_jump(&world);
+        }
+        update_game(&world);
+        ready_frame = NULL;
+    }
 
-        // Update pipe position
-        pipes[i].x -= PIPE_SPEED;
-        pipes[i].top_rect.x = pipes[i].x;
-        pipes[i].bottom_rect.x = pipes[i].x;
+    if (world.game_over && !was_over && postfx_on)
+    {
+        shake_frames = SHAKE_FRAMES;
+    }
 
-        // Check if bird passed the pipe
-        if (!pipes[i].passed && pipes[i].x + PIPE_WIDTH < bird.rect.x)
+    if (audio_device != 0)
+    {
+        if (jump && !was_over)
         {
-            pipes[i].passed = true;
-            score++;
+            mixer_play(&mixer, SOUND_JUMP, 0.6f);
         }
-
-        // Check for collision with pipes
-        if (check_collision(bird.rect, pipes[i].top_rect) ||
-            check_collision(bird.rect, pipes[i].bottom_rect))
+        if (world.score > old_score)
         {
-            game_over = true;
+            mixer_play(&mixer, SOUND_SCORE, 0.7f);
+        }
+        if (world.coins > old_coins)
+        {
+            mixer_play(&mixer, SOUND_SCORE, 0.35f);
+        }
+        if (world.game_over && !was_over)
+        {
+            mixer_play(&mixer, SOUND_HIT, 0.9f);
         }
     }
-}
 
-void render_game(SDL_Renderer *renderer)
-{
-    // Clear screen with sky blue
-    SDL_SetRenderDrawColor(renderer, 135, 206, 250, 255);
-    SDL_RenderClear(renderer);
-
-    // Draw pipes (green)
-    SDL_SetRenderDrawColor(renderer, 0, 128, 0, 255);
-    for (int i = 0; i < MAX_PIPES; i++)
+    if (world.game_over)
     {
-        if (pipes[i].x + PIPE_WIDTH > 0 && pipes[i].x < SCREEN_WIDTH)
+        if (replay_mode)
         {
-            SDL_RenderFillRect(renderer, &pipes[i].top_rect);
-            SDL_RenderFillRect(renderer, &pipes[i].bottom_rect);
+            printf("Replay finished at tick %u with score %d%s\n", world.tick, world.score,
+                   world.score == playback.score && world.tick == playback.num_ticks ? "" : " (MISMATCH)");
+        }
+        else if (record_path != NULL)
+        {
+            recording.seed = game_seed;
+            recording.features = game_features;
+            recording.num_ticks = world.tick;
+            recording.score = world.score;
+            if (replay_save(&recording, record_path))
+            {
+                printf("Saved replay to %s\n", record_path);
+            }
         }
     }
+}
 
-    // Draw ground (brown)
-    SDL_SetRenderDrawColor(renderer, 139, 69, 19, 255);
-    SDL_Rect ground = {0, SCREEN_HEIGHT - 20, SCREEN_WIDTH, 20};
-    SDL_RenderFillRect(renderer, &ground);
-
-    // Draw bird (yellow)
-    SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
-    SDL_RenderFillRect(renderer, &bird.rect);
-
-    // Draw game over indicator (red rectangle in center)
-    if (game_over)
+// Sends the tracker's dirty rects of frame to the texture, leaving the
+// rest as it was
+static void upload_rects(const Framebuffer *frame, const DirtyTracker *tracker)
+{
+    for (int i = 0; i < tracker->num_rects; i++)
     {
-        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-        SDL_Rect message_rect = {SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 30, 200, 60};
-        SDL_RenderFillRect(renderer, &message_rect);
+        Rect rect = tracker->rects[i];
+        SDL_Rect area = {rect.x, rect.y, rect.w, rect.h};
+        SDL_UpdateTexture(framebuffer_texture, &area, frame->pixels + (size_t)rect.y * frame->pitch + rect.x,
+                          frame->pitch * sizeof(uint32_t));
     }
+}
 
-    // Display score as a number in the corner of the screen
-    // Since we don't have SDL_ttf, we'll draw a simple digit display using rectangles
-
-    // Draw score in top-left corner
-    int score_display = score;
-    int digit_width = 20;
-    int digit_spacing = 5;
-    int x_position = 20;
-
-    // Handle score of 0 specially
-    if (score_display == 0)
+void render_game(SDL_Renderer *renderer)
+{
+    if (framebuffer_texture != NULL)
     {
-        // Draw 0 using rectangles (simple 7-segment style)
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-
-        // Top horizontal
-        SDL_Rect top = {x_position, 20, digit_width, 4};
-        SDL_RenderFillRect(renderer, &top);
-
-        // Bottom horizontal
-        SDL_Rect bottom = {x_position, 20 + digit_width, digit_width, 4};
-        SDL_RenderFillRect(renderer, &bottom);
-
-        // Left vertical
-        SDL_Rect left = {x_position, 20, 4, digit_width + 4};
-        SDL_RenderFillRect(renderer, &left);
-
-        // Right vertical
-        SDL_Rect right = {x_position + digit_width - 4, 20, 4, digit_width + 4};
-        SDL_RenderFillRect(renderer, &right);
+        // Software path: rasterize on the CPU (unless speculation already
+        // did) and upload the parts of the frame that changed
+        const Framebuffer *frame = ready_frame;
+        // Shown once only: the next speculation_prepare overwrites it with
+        // a tick that hasn't happened, so redraws must rasterize the world
+        ready_frame = NULL;
+        bool uploaded = false;
+        if (frame == NULL && indexed_render)
+        {
+            render_world(&draw_list, &world);
+            raster_draw_list_indexed(&indexed_framebuffer, &draw_list);
+            void *pixels;
+            int pitch;
+            if (postfx_on)
+            {
+                // The effects work on ARGB
+                indexed_expand(&indexed_framebuffer, framebuffer.pixels, framebuffer.pitch);
+                frame = &framebuffer;
+            }
+            else if (dirty_on)
+            {
+                // Expand only what changed, through the ARGB frame
+                int count = dirty_update(&dirty_indexed, indexed_framebuffer.pixels, indexed_framebuffer.pitch);
+                for (int i = 0; i < count; i++)
+                {
+                    indexed_expand_rect(&indexed_framebuffer, framebuffer.pixels, framebuffer.pitch,
+                                        dirty_indexed.rects[i]);
+                }
+                upload_rects(&framebuffer, &dirty_indexed);
+                dirty_invalidate(&dirty_argb);
+                uploaded = true;
+            }
+            else if (SDL_LockTexture(framebuffer_texture, NULL, &pixels, &pitch) == 0)
+            {
+                // Expand straight into the texture, with no ARGB frame between
+                indexed_expand(&indexed_framebuffer, pixels, pitch / (int)sizeof(uint32_t));
+                SDL_UnlockTexture(framebuffer_texture);
+                uploaded = true;
+            }
+            else
+            {
+                indexed_expand(&indexed_framebuffer, framebuffer.pixels, framebuffer.pitch);
+                frame = &framebuffer;
+            }
+        }
+        else if (frame == NULL)
+        {
+            render_world(&draw_list, &world);
+            raster_draw_list(&framebuffer, &draw_list);
+            frame = &framebuffer;
+        }
+        if (postfx_on && !uploaded)
+        {
+            // Shakes start hard and ease out
+            int amplitude = SHAKE_PIXELS * shake_frames / SHAKE_FRAMES;
+            postfx.shake_x = amplitude ? (int)rng_range(&shake_rng, 2 * amplitude + 1) - amplitude : 0;
+            postfx.shake_y = amplitude ? (int)rng_range(&shake_rng, 2 * amplitude + 1) - amplitude : 0;
+            postfx_apply(&postfx, frame, &postfx_frame);
+            frame = &postfx_frame;
+        }
+        if (!uploaded && dirty_on)
+        {
+            dirty_update(&dirty_argb, frame->pixels, frame->pitch * sizeof(uint32_t));
+            upload_rects(frame, &dirty_argb);
+            dirty_invalidate(&dirty_indexed);
+        }
+        else if (!uploaded)
+        {
+            SDL_UpdateTexture(framebuffer_texture, NULL, frame->pixels, frame->pitch * sizeof(uint32_t));
+        }
+        SDL_RenderCopy(renderer, framebuffer_texture, NULL, NULL);
     }
-
-    // Draw each digit of the score
-    while (score_display > 0)
+    else
     {
-        int digit = score_display % 10;
-        score_display /= 10;
-
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-
-        // Draw the digit based on its value
-        switch (digit)
+        render_world(&draw_list, &world);
+        for (int i = 0; i < draw_list.count; i++)
         {
-        case 0:
-            // Top horizontal
-            SDL_RenderDrawLine(renderer, x_position, 20, x_position + digit_width, 20);
-            // Bottom horizontal
-            SDL_RenderDrawLine(renderer, x_position, 20 + digit_width, x_position + digit_width, 20 + digit_width);
-            // Left vertical
-            SDL_RenderDrawLine(renderer, x_position, 20, x_position, 20 + digit_width);
-            // Right vertical
-            SDL_RenderDrawLine(renderer, x_position + digit_width, 20, x_position + digit_width, 20 + digit_width);
-            break;
-
-        case 1:
-            // Right vertical
-            SDL_RenderDrawLine(renderer, x_position + digit_width, 20, x_position + digit_width, 20 + digit_width);
-            break;
-
-        case 2:
-            // Top horizontal
-            SDL_RenderDrawLine(renderer, x_position, 20, x_position + digit_width, 20);
-            // Middle horizontal
-            SDL_RenderDrawLine(renderer, x_position, 20 + digit_width / 2, x_position + digit_width, 20 + digit_width / 2);
-            // Bottom horizontal
-            SDL_RenderDrawLine(renderer, x_position, 20 + digit_width, x_position + digit_width, 20 + digit_width);
-            // Top-right vertical
-            SDL_RenderDrawLine(renderer, x_position + digit_width, 20, x_position + digit_width, 20 + digit_width / 2);
-            // Bottom-left vertical
-            SDL_RenderDrawLine(renderer, x_position, 20 + digit_width / 2, x_position, 20 + digit_width);
-            break;
-
-        // Add cases 3-9 if needed
-        default:
-            // For simplicity, just draw a rectangle for other digits
-            SDL_Rect digit_rect = {x_position, 20, digit_width, digit_width};
-            SDL_RenderFillRect(renderer, &digit_rect);
-            break;
+            const DrawCmd *cmd = &draw_list.cmds[i];
+            SDL_SetRenderDrawColor(renderer, (cmd->color >> 16) & 0xFF, (cmd->color >> 8) & 0xFF,
+                                   cmd->color & 0xFF, cmd->color >> 24);
+            switch (cmd->op)
+            {
+            case DRAW_CLEAR:
+                SDL_RenderClear(renderer);
+                break;
+            case DRAW_RECT:
+            {
+                SDL_Rect rect = {cmd->x0, cmd->y0, cmd->x1 - cmd->x0, cmd->y1 - cmd->y0};
+                SDL_RenderFillRect(renderer, &rect);
+                break;
+            }
+            case DRAW_LINE:
+                SDL_RenderDrawLine(renderer, cmd->x0, cmd->y0, cmd->x1, cmd->y1);
+                break;
+            }
         }
-
-        // Move position for next digit (to the left)
-        x_position += digit_width + digit_spacing;
     }
 
     // Also output score to console when it changes
     static int last_score = 0;
-    if (score != last_score)
+    if (world.score != last_score)
+    {
+        printf("Score: %d\n", world.score);
+        last_score = world.score;
+    }
+    static int last_coins = 0;
+    if (world.coins != last_coins)
     {
-        printf("Score: %d\n", score);
-        last_score = score;
+        if (world.coins > 0)
+            printf("Coins: %d\n", world.coins);
+        last_coins = world.coins;
     }
 
     // Update screen
@@ -425,25 +930,18 @@ void render_game(SDL_Renderer *renderer)
 
 void reset_game()
 {
-    // Initialize bird
-    bird.x = SCREEN_WIDTH / 4;
-    bird.y = SCREEN_HEIGHT / 2;
-    bird.velocity = 0;
-    bird.rect.x = (int)bird.x;
-    bird.rect.y = (int)bird.y;
-    bird.rect.w = BIRD_WIDTH;
-    bird.rect.h = BIRD_HEIGHT;
-
-    // Initialize pipes
-    for (int i = 0; i < MAX_PIPES; i++)
+    // Each run gets its own course unless the seed was pinned
+    if (!fixed_seed)
     {
-        pipes[i].x = SCREEN_WIDTH * 2; // Position off-screen
+        game_seed = game_seed * 6364136223846793005ULL + 1442695040888963407ULL;
     }
-
-    // Reset game state
-    game_over = false;
-    score = 0;
-    last_pipe_time = SDL_GetTicks();
+    world_reset_features(&world, game_seed, game_features);
+    speculation.ready = false;
+    ready_frame = NULL;
+    shake_frames = 0;
+    recording.num_jumps = 0;
+    playback_jump = 0;
+    jump_requested = false;
 
     printf("Game reset. Score: 0\n");
-}
\ No newline at end of file
+}
@@ -0,0 +1,80 @@
+/**
+ * Exact flight
+ */
+
+#include "flight.h"
+
+#include <math.h>
+
+#define NEVER UINT32_MAX
+
+// Height ticks after launch, ignoring the ceiling
+static inline double height_at(Flight launch, double ticks)
+{
+    return launch.y + launch.velocity * ticks + GRAVITY * ticks * (ticks + 1) / 2;
+}
+
+// Smallest whole n >= 1 at or after root with height_at(n) on the wanted
+// side of limit; the root only comes from sqrt, so one step either way
+// covers its rounding
+static uint32_t first_tick_from(Flight launch, double root, double limit, bool below)
+{
+    double n = ceil(root);
+    if (n < 1)
+        n = 1;
+    if (n > 1 && (below ? height_at(launch, n - 1) <= limit : height_at(launch, n - 1) >= limit))
+        n--;
+    if (!(below ? height_at(launch, n) <= limit : height_at(launch, n) >= limit))
+        n++;
+    return (uint32_t)n;
+}
+
+// First tick on which the bird is stopped by the ceiling, or NEVER
+static uint32_t ceiling_tick(Flight launch)
+{
+    // update_game stops the bird once its row, (int)y, goes negative, so
+    // once y <= -1; solve g/2 n^2 + (v0 + g/2) n + (y0 + 1) <= 0
+    double a = GRAVITY / 2, b = launch.velocity + GRAVITY / 2, c = launch.y + 1;
+    double discriminant = b * b - 4 * a * c;
+    if (discriminant < 0)
+        return NEVER;
+    double low = (-b - sqrt(discriminant)) / (2 * a);
+    double high = (-b + sqrt(discriminant)) / (2 * a);
+    if (high < 1)
+        return NEVER;
+
+    uint32_t n = first_tick_from(launch, low, -1, true);
+    return height_at(launch, n) <= -1 ? n : NEVER;
+}
+
+Flight flight_at(Flight launch, double ticks)
+{
+    uint32_t stop = ceiling_tick(launch);
+    if (stop != NEVER && stop <= ticks)
+    {
+        // Stopped dead at the top, then falling from rest
+        launch = (Flight){0, 0};
+        ticks -= stop;
+    }
+    return (Flight){height_at(launch, ticks), launch.velocity + GRAVITY * ticks};
+}
+
+uint32_t flight_tick_reaching(Flight launch, int row)
+{
+    uint32_t stop = ceiling_tick(launch);
+    uint32_t offset = 0;
+    if (height_at(launch, 1) < row && stop != NEVER)
+    {
+        // Rising into the ceiling first, so the row is only reached falling
+        // from rest there
+        launch = (Flight){0, 0};
+        offset = stop;
+    }
+
+    // The height is convex in n, so past the first tick the row is reached
+    // at the larger root of height_at(n) = row
+    double a = GRAVITY / 2, b = launch.velocity + GRAVITY / 2, c = launch.y - row;
+    double discriminant = b * b - 4 * a * c;
+    double high = discriminant > 0 ? (-b + sqrt(discriminant)) / (2 * a) : 1;
+    return offset + first_tick_from(launch, high, row, false);
+}
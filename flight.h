@@ -0,0 +1,43 @@
+/**
+ * Exact flight
+ * Between jumps the bird only falls, so its height after n ticks is a
+ * closed form of the launch state: y0 + v0 n + g n (n + 1) / 2, with the
+ * ceiling (which stops it dead) as the one break in the curve. Anything
+ * that samples the bird at its own rate (a 30 Hz server, a 240 Hz display,
+ * fast-forward) can evaluate that from the last launch in O(1) instead of
+ * stepping tick by tick, and two samplers asking for the same time get the
+ * same answer however they got there.
+ *
+ * The closed form is exact in real arithmetic, so at whole ticks it lands
+ * on the positions update_game's float steps round towards, within a few
+ * thousandths of a pixel over any flight that stays on screen. Rows, and
+ * the ceiling and ground checks made on them, can only come out a tick
+ * apart when the bird passes that close to a row boundary; replays and
+ * hashes keep stepping update_game.
+ */
+
+#ifndef FLIGHT_H
+#define FLIGHT_H
+
+#include "game.h"
+
+typedef struct
+{
+    double y, velocity;
+} Flight;
+
+// Where the bird is ticks after leaving launch without jumping; ticks may
+// be fractional, giving the curve through the whole-tick positions
+Flight flight_at(Flight launch, double ticks);
+
+// First whole tick after launch on which the bird's row is row or more
+// (lower on screen); row must not be negative
+uint32_t flight_tick_reaching(Flight launch, int row);
+
+// First tick after launch on which the bird hits the ground
+static inline uint32_t flight_ground_tick(Flight launch)
+{
+    return flight_tick_reaching(launch, SCREEN_HEIGHT - GROUND_HEIGHT - BIRD_HEIGHT + 1);
+}
+
+#endif
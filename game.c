@@ -0,0 +1,752 @@
+/**
+ * Headless game simulation
+ * World reset, pipe and pickup spawning and the per-tick systems:
+ * movement, scoring, pickups and collision.
+ */
+
+#include "game.h"
+
+#include <string.h>
+
+static inline uint32_t float_bits(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// What the world hash changes by when a mixed field changes value; a
+// linear field's change is just world_hash_linear(field, difference)
+static inline uint64_t mixed_change(uint32_t field, uint32_t old_value, uint32_t new_value)
+{
+    return world_hash_mixed(field, new_value) - world_hash_mixed(field, old_value);
+}
+
+// Hash terms of the pipe in slot i
+static inline uint64_t pipe_hash(const Pipes *pipes, int i)
+{
+    uint32_t motion = (uint32_t)pipes->gap_base[i] | (uint32_t)pipes->motion[i] << 10 |
+                      (uint32_t)(uint8_t)pipes->amplitude[i] << 12 | (uint32_t)(uint16_t)pipes->period[i] << 20;
+    return world_hash_linear(HASH_PIPE_X + i, pipes->x[i]) + world_hash_mixed(HASH_PIPE_GAP_Y + i, pipes->gap_y[i]) +
+           world_hash_linear(HASH_PIPE_PASSED + i, pipes->passed[i]) + world_hash_mixed(HASH_PIPE_MOTION + i, motion);
+}
+
+// Hash terms of the pickup in slot i
+static inline uint64_t pickup_hash(const Pickups *pickups, int i)
+{
+    return world_hash_mixed(HASH_PICKUP_X + i, (uint32_t)pickups->x[i]) +
+           world_hash_mixed(HASH_PICKUP_Y + i, (uint16_t)pickups->y[i] | (uint32_t)pickups->kind[i] << 16);
+}
+
+// Every pickup term; sorting moves pickups between slots, so changes to
+// the table are hashed as the difference of this before and after
+static uint64_t pickups_hash(const World *world)
+{
+    const Pickups *pickups = &world->pickups;
+    uint64_t hash = world_hash_linear(HASH_PICKUP_COUNT, pickups->count);
+    for (int k = 0; k < 4; k++)
+    {
+        hash += world_hash_mixed(HASH_PICKUP_RNG + k, world->pickup_rng.s[k]);
+    }
+    for (int i = 0; i < pickups->count; i++)
+    {
+        hash += pickup_hash(pickups, i);
+    }
+    return hash;
+}
+
+uint64_t world_hash_full(const World *world)
+{
+    uint64_t hash = world_hash_linear(HASH_GAME_OVER, world->game_over) +
+                    world_hash_linear(HASH_SCORE, world->score) +
+                    world_hash_linear(HASH_TICK, world->tick) +
+                    world_hash_linear(HASH_LAST_PIPE_TICK, world->last_pipe_tick) +
+                    world_hash_linear(HASH_PIPE_COUNT, world->pipes.count);
+
+    for (int b = 0; b < world->birds.count; b++)
+    {
+        hash += world_hash_mixed(HASH_BIRD_Y + b, float_bits(world->birds.y[b])) +
+                world_hash_mixed(HASH_BIRD_VELOCITY + b, float_bits(world->birds.velocity[b]));
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        hash += world_hash_mixed(HASH_RNG + k, world->rng.s[k]) +
+                world_hash_mixed(HASH_MOTION_RNG + k, world->motion_rng.s[k]);
+    }
+    for (int i = 0; i < world->pipes.count; i++)
+    {
+        hash += pipe_hash(&world->pipes, i);
+    }
+
+    hash += world_hash_linear(HASH_FEATURES, world->features) + world_hash_linear(HASH_COINS, world->coins) +
+            world_hash_linear(HASH_SHIELD_TICKS, world->shield_ticks) + pickups_hash(world);
+    return hash;
+}
+
+void world_reset(World *world, uint64_t seed)
+{
+    world_reset_features(world, seed, 0);
+}
+
+void world_reset_features(World *world, uint64_t seed, uint32_t features)
+{
+    memset(world, 0, sizeof(*world));
+    world->features = features;
+
+    // Initialize the player; pipes start empty
+    Birds *birds = &world->birds;
+    birds->count = 1;
+    birds->y[0] = SCREEN_HEIGHT / 2;
+    birds->velocity[0] = 0;
+    birds->row[0] = (int)birds->y[0];
+
+    rng_seed(&world->rng, seed);
+    if (features & WORLD_PICKUPS)
+    {
+        rng_seed(&world->pickup_rng, seed ^ 0x5049434B55505321ULL);
+    }
+    if (features & WORLD_MOVING_GAPS)
+    {
+        rng_seed(&world->motion_rng, seed ^ 0x4D4F54494F4E2121ULL);
+    }
+    world->hash = world_hash_full(world);
+}
+
+void world_jump(World *world)
+{
+    Birds *birds = &world->birds;
+    world->hash += mixed_change(HASH_BIRD_VELOCITY, float_bits(birds->velocity[0]), float_bits(JUMP_FORCE));
+    birds->velocity[0] = JUMP_FORCE;
+}
+
+// A quarter sine wave in 1/16384ths, 64 steps
+static const int16_t quarter_sine[65] = {
+    0,     402,   804,   1205,  1606,  2006,  2404,  2801,  3196,  3590,  3981,  4370,  4756,
+    5139,  5520,  5897,  6270,  6639,  7005,  7366,  7723,  8076,  8423,  8765,  9102,  9434,
+    9760,  10080, 10394, 10702, 11003, 11297, 11585, 11866, 12140, 12406, 12665, 12916, 13160,
+    13395, 13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978, 15137, 15286, 15426, 15557,
+    15679, 15791, 15893, 15986, 16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379, 16384};
+
+int gap_motion_offset(GapMotion motion, int amplitude, int period, uint32_t age)
+{
+    // Integer maths only, so every kernel and machine agrees
+    switch (motion)
+    {
+    case GAP_SINE:
+    {
+        int phase = (int)((uint64_t)(age % (uint32_t)period) * 256 / (uint32_t)period);
+        int quarter = phase & 63;
+        int sine;
+        switch (phase >> 6)
+        {
+        case 0:
+            sine = quarter_sine[quarter];
+            break;
+        case 1:
+            sine = quarter_sine[64 - quarter];
+            break;
+        case 2:
+            sine = -quarter_sine[quarter];
+            break;
+        default:
+            sine = -quarter_sine[64 - quarter];
+            break;
+        }
+        return amplitude * sine / 16384;
+    }
+    case GAP_PING_PONG:
+    {
+        // Triangle wave, shifted a quarter period so it starts at the centre
+        int half = period / 2;
+        int t = (int)((age + (uint32_t)period / 4) % (uint32_t)period);
+        int rise = t < half ? t : period - t;
+        if (rise > half)
+            rise = half; // odd periods peak for a tick
+        return amplitude * (2 * rise - half) / half;
+    }
+    default:
+        return 0;
+    }
+}
+
+void gap_motion_draw(Rng *rng, int base, uint8_t *motion, int16_t *amplitude, int16_t *period)
+{
+    // Half the gaps stay still; the rest swing by up to 80 pixels, less
+    // near the edges, over one to three seconds
+    uint32_t kind = rng_range(rng, 4);
+    *motion = kind < 2 ? GAP_STILL : kind == 2 ? GAP_SINE : GAP_PING_PONG;
+    *amplitude = 0;
+    *period = 0;
+    if (*motion == GAP_STILL)
+        return;
+
+    int reach = 20 + (int)rng_range(rng, 61);
+    if (reach > base - MIN_GAP_Y)
+        reach = base - MIN_GAP_Y;
+    if (reach > MAX_GAP_Y - base)
+        reach = MAX_GAP_Y - base;
+    *amplitude = (int16_t)reach;
+    *period = (int16_t)(TICK_RATE + rng_range(rng, 2 * TICK_RATE + 1));
+}
+
+void create_pipe(World *world)
+{
+    Pipes *pipes = &world->pipes;
+    Rng old_rng = world->rng;
+    Rng old_motion_rng = world->motion_rng;
+
+    // The table never fills: pipes leave the screen long before MAX_PIPES
+    // of them have spawned
+    int i = pipes->count++;
+    pipes->x[i] = SCREEN_WIDTH;
+
+    // Ensure gap is within screen bounds
+    pipes->gap_y[i] = MIN_GAP_Y + (int)rng_range(&world->rng, MAX_GAP_Y - MIN_GAP_Y);
+    pipes->passed[i] = false;
+
+    if (world->features & WORLD_MOVING_GAPS)
+    {
+        pipes->gap_base[i] = pipes->gap_y[i];
+        pipes->spawn_tick[i] = world->tick;
+        gap_motion_draw(&world->motion_rng, pipes->gap_base[i], &pipes->motion[i], &pipes->amplitude[i],
+                        &pipes->period[i]);
+    }
+
+    world->hash += pipe_hash(pipes, i) + world_hash_linear(HASH_PIPE_COUNT, 1);
+    for (int k = 0; k < 4; k++)
+    {
+        world->hash += mixed_change(HASH_RNG + k, old_rng.s[k], world->rng.s[k]) +
+                       mixed_change(HASH_MOTION_RNG + k, old_motion_rng.s[k], world->motion_rng.s[k]);
+    }
+}
+
+bool check_collision(Rect a, Rect b)
+{
+    // Check if two rectangles are colliding
+    int left_a = a.x;
+    int right_a = a.x + a.w;
+    int top_a = a.y;
+    int bottom_a = a.y + a.h;
+
+    int left_b = b.x;
+    int right_b = b.x + b.w;
+    int top_b = b.y;
+    int bottom_b = b.y + b.h;
+
+    if (bottom_a <= top_b)
+        return false;
+    if (top_a >= bottom_b)
+        return false;
+    if (right_a <= left_b)
+        return false;
+    if (left_a >= right_b)
+        return false;
+
+    return true;
+}
+
+static inline int pickup_cell(int32_t x, int y)
+{
+    return y / PICKUP_CELL * PICKUP_GRID_COLS + x / PICKUP_CELL % PICKUP_GRID_COLS;
+}
+
+// Counting sort by grid cell, dropping PICKUP_NONE, and rebuilds the
+// cell index; only runs when pickups come or go
+static void pickups_sort(Pickups *pickups)
+{
+    int counts[PICKUP_GRID_CELLS + 1] = {0};
+    int cells[MAX_PICKUPS];
+    for (int i = 0; i < pickups->count; i++)
+    {
+        cells[i] = pickups->kind[i] == PICKUP_NONE ? -1 : pickup_cell(pickups->x[i], pickups->y[i]);
+        if (cells[i] >= 0)
+            counts[cells[i] + 1]++;
+    }
+    for (int c = 0; c < PICKUP_GRID_CELLS; c++)
+    {
+        counts[c + 1] += counts[c];
+    }
+    for (int c = 0; c <= PICKUP_GRID_CELLS; c++)
+    {
+        pickups->cell_start[c] = (uint8_t)counts[c];
+    }
+
+    Pickups sorted;
+    for (int i = 0; i < pickups->count; i++)
+    {
+        if (cells[i] < 0)
+            continue;
+        int slot = counts[cells[i]]++;
+        sorted.x[slot] = pickups->x[i];
+        sorted.y[slot] = pickups->y[i];
+        sorted.kind[slot] = pickups->kind[i];
+    }
+
+    // Keep dead slots zero so equal worlds are equal bytes
+    int count = pickups->cell_start[PICKUP_GRID_CELLS];
+    memset(pickups->x, 0, sizeof(pickups->x));
+    memset(pickups->y, 0, sizeof(pickups->y));
+    memset(pickups->kind, 0, sizeof(pickups->kind));
+    memcpy(pickups->x, sorted.x, count * sizeof(sorted.x[0]));
+    memcpy(pickups->y, sorted.y, count * sizeof(sorted.y[0]));
+    memcpy(pickups->kind, sorted.kind, count * sizeof(sorted.kind[0]));
+    pickups->count = count;
+}
+
+static void pickup_add(Pickups *pickups, int32_t x, int y, PickupKind kind)
+{
+    if (pickups->count < MAX_PICKUPS)
+    {
+        int i = pickups->count++;
+        pickups->x[i] = x;
+        pickups->y[i] = (int16_t)y;
+        pickups->kind[i] = (uint8_t)kind;
+    }
+}
+
+// Fills the gap behind the pipe that just spawned: now and then a coin or
+// a shield near its opening, or a block of coins in a bonus stage. Also
+// drops pickups that have left the screen.
+static void pickup_spawn_system(World *world)
+{
+    Pickups *pickups = &world->pickups;
+    int32_t scroll = PIPE_SPEED * (int32_t)world->tick;
+
+    for (int i = 0; i < pickups->count; i++)
+    {
+        if (pickups->x[i] + PICKUP_SIZE < scroll)
+            pickups->kind[i] = PICKUP_NONE;
+    }
+
+    // The new pipe moves once more this tick, to SCREEN_WIDTH - PIPE_SPEED
+    const int spacing = PIPE_SPEED * (PIPE_SPAWN_TICKS + 1);
+    int32_t centre = scroll + SCREEN_WIDTH - PIPE_SPEED + PIPE_WIDTH + (spacing - PIPE_WIDTH) / 2;
+    int gap_y = world->pipes.gap_y[world->pipes.count - 1];
+    uint32_t section = world->tick / (PIPE_SPAWN_TICKS + 1);
+
+    if (section % BONUS_EVERY == 0)
+    {
+        const int columns = 5, step = PICKUP_SIZE * 3 / 2;
+        for (int y = 2 * PICKUP_SIZE; y + PICKUP_SIZE <= SCREEN_HEIGHT - GROUND_HEIGHT - PICKUP_SIZE; y += step)
+        {
+            for (int c = 0; c < columns; c++)
+            {
+                pickup_add(pickups, centre + (c - columns / 2) * step - PICKUP_SIZE / 2, y, PICKUP_COIN);
+            }
+        }
+    }
+    else if (rng_range(&world->pickup_rng, 2) == 0)
+    {
+        PickupKind kind = rng_range(&world->pickup_rng, 6) == 0 ? PICKUP_SHIELD : PICKUP_COIN;
+        int y = gap_y - PICKUP_SIZE / 2 + (int)rng_range(&world->pickup_rng, PIPE_GAP) - PIPE_GAP / 2;
+        pickup_add(pickups, centre - PICKUP_SIZE / 2, y, kind);
+    }
+
+    pickups_sort(pickups);
+}
+
+// Spawns a pipe every PIPE_SPAWN_TICKS; returns the change to the hash
+// beyond what create_pipe adds
+static uint64_t spawn_system(World *world)
+{
+    if (world->tick - world->last_pipe_tick <= PIPE_SPAWN_TICKS)
+        return 0;
+
+    create_pipe(world);
+    uint64_t hash_change = world_hash_linear(HASH_LAST_PIPE_TICK, (int64_t)world->tick - world->last_pipe_tick);
+    world->last_pipe_tick = world->tick;
+
+    if (world->features & WORLD_PICKUPS)
+    {
+        uint64_t before = pickups_hash(world);
+        pickup_spawn_system(world);
+        hash_change += pickups_hash(world) - before;
+    }
+    return hash_change;
+}
+
+int world_pickups_touching(const World *world, int b, int *hits)
+{
+    const Pickups *pickups = &world->pickups;
+    int32_t left = BIRD_X + PIPE_SPEED * (int32_t)world->tick;
+    int top = world->birds.row[b];
+
+    // Pickups are filed under their top-left corner, so the cells to search
+    // start a pickup's size up and to the left of the bird
+    int first_col = (left - PICKUP_SIZE + 1) / PICKUP_CELL;
+    int last_col = (left + BIRD_WIDTH - 1) / PICKUP_CELL;
+    int first_row = top - PICKUP_SIZE + 1 > 0 ? (top - PICKUP_SIZE + 1) / PICKUP_CELL : 0;
+    int last_row = (top + BIRD_HEIGHT - 1) / PICKUP_CELL;
+    if (last_row >= PICKUP_GRID_ROWS)
+        last_row = PICKUP_GRID_ROWS - 1;
+
+    int n = 0;
+    for (int row = first_row; row <= last_row; row++)
+    {
+        for (int col = first_col; col <= last_col; col++)
+        {
+            int cell = row * PICKUP_GRID_COLS + col % PICKUP_GRID_COLS;
+            for (int i = pickups->cell_start[cell]; i < pickups->cell_start[cell + 1]; i++)
+            {
+                if (pickups->x[i] < left + BIRD_WIDTH && pickups->x[i] + PICKUP_SIZE > left &&
+                    pickups->y[i] < top + BIRD_HEIGHT && pickups->y[i] + PICKUP_SIZE > top)
+                    hits[n++] = i;
+            }
+        }
+    }
+    return n;
+}
+
+// Wears the shield down and collects what the birds touch
+static uint64_t pickup_system(World *world)
+{
+    uint64_t hash_change = 0;
+    if (world->shield_ticks > 0)
+    {
+        world->shield_ticks--;
+        hash_change += world_hash_linear(HASH_SHIELD_TICKS, -1);
+    }
+
+    int hits[MAX_PICKUPS];
+    int collected = 0;
+    uint64_t before = 0;
+    for (int b = 0; b < world->birds.count; b++)
+    {
+        int n = world_pickups_touching(world, b, hits);
+        if (n > 0 && collected == 0)
+            before = pickups_hash(world);
+        for (int h = 0; h < n; h++)
+        {
+            uint8_t *kind = &world->pickups.kind[hits[h]];
+            if (*kind == PICKUP_COIN)
+            {
+                world->coins++;
+                hash_change += world_hash_linear(HASH_COINS, 1);
+            }
+            else if (*kind == PICKUP_SHIELD)
+            {
+                hash_change += world_hash_linear(HASH_SHIELD_TICKS, SHIELD_TICKS - world->shield_ticks);
+                world->shield_ticks = SHIELD_TICKS;
+            }
+            *kind = PICKUP_NONE;
+            collected++;
+        }
+    }
+
+    if (collected > 0)
+    {
+        pickups_sort(&world->pickups);
+        hash_change += pickups_hash(world) - before;
+    }
+    return hash_change;
+}
+
+// Gravity and the ceiling
+static uint64_t bird_movement_system(Birds *birds)
+{
+    uint64_t hash_change = 0;
+    for (int b = 0; b < birds->count; b++)
+    {
+        uint32_t old_y = float_bits(birds->y[b]);
+        uint32_t old_velocity = float_bits(birds->velocity[b]);
+
+        // Update bird position
+        birds->velocity[b] += GRAVITY;
+        birds->y[b] += birds->velocity[b];
+        birds->row[b] = (int)birds->y[b];
+
+        // Check for collision with ceiling
+        if (birds->row[b] < 0)
+        {
+            birds->row[b] = 0;
+            birds->y[b] = 0;
+            birds->velocity[b] = 0;
+        }
+        hash_change += mixed_change(HASH_BIRD_Y + b, old_y, float_bits(birds->y[b]));
+        hash_change += mixed_change(HASH_BIRD_VELOCITY + b, old_velocity, float_bits(birds->velocity[b]));
+    }
+    return hash_change;
+}
+
+// Scrolls the pipes and drops the oldest once it is off screen
+static uint64_t pipe_movement_system(Pipes *pipes)
+{
+    uint64_t hash_change = 0;
+    for (int i = 0; i < pipes->count; i++)
+    {
+        pipes->x[i] -= PIPE_SPEED;
+        hash_change += world_hash_linear(HASH_PIPE_X + i, -PIPE_SPEED);
+    }
+
+    // All pipes scroll together, so only the oldest can have left
+    if (pipes->count > 0 && pipes->x[0] + PIPE_WIDTH < 0)
+    {
+        int n = pipes->count;
+        for (int i = 0; i < n; i++)
+            hash_change -= pipe_hash(pipes, i);
+
+        memmove(pipes->x, pipes->x + 1, (n - 1) * sizeof(pipes->x[0]));
+        memmove(pipes->gap_y, pipes->gap_y + 1, (n - 1) * sizeof(pipes->gap_y[0]));
+        memmove(pipes->passed, pipes->passed + 1, (n - 1) * sizeof(pipes->passed[0]));
+        memmove(pipes->gap_base, pipes->gap_base + 1, (n - 1) * sizeof(pipes->gap_base[0]));
+        memmove(pipes->motion, pipes->motion + 1, (n - 1) * sizeof(pipes->motion[0]));
+        memmove(pipes->amplitude, pipes->amplitude + 1, (n - 1) * sizeof(pipes->amplitude[0]));
+        memmove(pipes->period, pipes->period + 1, (n - 1) * sizeof(pipes->period[0]));
+        memmove(pipes->spawn_tick, pipes->spawn_tick + 1, (n - 1) * sizeof(pipes->spawn_tick[0]));
+        pipes->count = --n;
+
+        // Keep dead slots zero so equal worlds are equal bytes
+        pipes->x[n] = 0;
+        pipes->gap_y[n] = 0;
+        pipes->passed[n] = false;
+        pipes->gap_base[n] = 0;
+        pipes->motion[n] = GAP_STILL;
+        pipes->amplitude[n] = 0;
+        pipes->period[n] = 0;
+        pipes->spawn_tick[n] = 0;
+
+        for (int i = 0; i < n; i++)
+            hash_change += pipe_hash(pipes, i);
+        hash_change -= world_hash_linear(HASH_PIPE_COUNT, 1);
+    }
+    return hash_change;
+}
+
+// Sets every moving gap to where its closed form puts it on this tick
+static uint64_t gap_motion_system(World *world)
+{
+    Pipes *pipes = &world->pipes;
+    uint64_t hash_change = 0;
+    for (int i = 0; i < pipes->count; i++)
+    {
+        if (pipes->motion[i] == GAP_STILL)
+            continue;
+        int gap_y = pipes->gap_base[i] + gap_motion_offset(pipes->motion[i], pipes->amplitude[i], pipes->period[i],
+                                                           world->tick - pipes->spawn_tick[i]);
+        hash_change += mixed_change(HASH_PIPE_GAP_Y + i, pipes->gap_y[i], gap_y);
+        pipes->gap_y[i] = gap_y;
+    }
+    return hash_change;
+}
+
+// A point for every pipe that has moved past the birds' column
+static uint64_t scoring_system(World *world)
+{
+    Pipes *pipes = &world->pipes;
+    uint64_t hash_change = 0;
+    for (int i = 0; i < pipes->count; i++)
+    {
+        if (!pipes->passed[i] && pipes->x[i] + PIPE_WIDTH < BIRD_X)
+        {
+            pipes->passed[i] = true;
+            world->score++;
+            hash_change += world_hash_linear(HASH_PIPE_PASSED + i, 1);
+            hash_change += world_hash_linear(HASH_SCORE, 1);
+        }
+    }
+    return hash_change;
+}
+
+// Whether any bird has hit the ground or a pipe (unless shielded)
+static bool collision_system(const World *world)
+{
+    const Birds *birds = &world->birds;
+    const Pipes *pipes = &world->pipes;
+    int num_pipes = world->shield_ticks > 0 ? 0 : pipes->count;
+    bool hit = false;
+    for (int b = 0; b < birds->count; b++)
+    {
+        Rect bird = bird_rect(birds, b);
+
+        // Check for collision with ground
+        if (bird.y + bird.h > SCREEN_HEIGHT - GROUND_HEIGHT)
+            hit = true;
+
+        for (int i = 0; i < num_pipes; i++)
+        {
+            if (check_collision(bird, pipe_top_rect(pipes, i)) || check_collision(bird, pipe_bottom_rect(pipes, i)))
+                hit = true;
+        }
+    }
+    return hit;
+}
+
+void update_game(World *world)
+{
+    uint64_t hash_change = 0; // summed in a register, stored once
+    bool old_game_over = world->game_over;
+
+    world->tick++;
+    hash_change += world_hash_linear(HASH_TICK, 1);
+    hash_change += spawn_system(world);
+
+    // Birds and pipes move independently, then scoring (writes pipes'
+    // passed and the score), pickups (the pickup table, coins and shield)
+    // and collision (only reads) look at the result
+    hash_change += bird_movement_system(&world->birds);
+    hash_change += pipe_movement_system(&world->pipes);
+    if (world->features & WORLD_MOVING_GAPS)
+    {
+        hash_change += gap_motion_system(world);
+    }
+    hash_change += scoring_system(world);
+    if (world->features & WORLD_PICKUPS)
+    {
+        hash_change += pickup_system(world);
+    }
+    world->game_over |= collision_system(world);
+
+    // Ground and pipes can both end the game on the same tick
+    hash_change += world_hash_linear(HASH_GAME_OVER, world->game_over - old_game_over);
+    world->hash += hash_change;
+}
+
+// Bitwise select helpers for the branchless kernel: mask is all ones or zero
+static inline int select_int(int mask, int a, int b)
+{
+    return (a & mask) | (b & ~mask);
+}
+
+static inline float select_float(int mask, float a, float b)
+{
+    union
+    {
+        float f;
+        int i;
+    } x = {a}, y = {b}, r;
+    r.i = select_int(mask, x.i, y.i);
+    return r.f;
+}
+
+static inline int max_int(int a, int b)
+{
+    return select_int(-(a > b), a, b);
+}
+
+void update_game_branchless(World *world)
+{
+    Birds *birds = &world->birds;
+    Pipes *pipes = &world->pipes;
+    uint64_t hash_change = 0; // summed in a register, stored once
+
+    // Spawning and despawning are periodic, so their branches are perfectly
+    // predicted and stay
+    world->tick++;
+    hash_change += world_hash_linear(HASH_TICK, 1);
+    hash_change += spawn_system(world);
+    hash_change += pipe_movement_system(pipes);
+    if (world->features & WORLD_MOVING_GAPS)
+    {
+        hash_change += gap_motion_system(world);
+    }
+
+    int dead = 0, hit_pipe = 0;
+    int score = world->score;
+    for (int b = 0; b < birds->count; b++)
+    {
+        // Integrate, then clamp to the ceiling by selecting instead of branching
+        float velocity = birds->velocity[b] + GRAVITY;
+        float y = birds->y[b] + velocity;
+        int row = (int)y;
+        int below_ceiling = -(row >= 0);
+
+        velocity = select_float(below_ceiling, velocity, 0.0f);
+        y = select_float(below_ceiling, y, 0.0f);
+        hash_change += mixed_change(HASH_BIRD_VELOCITY + b, float_bits(birds->velocity[b]), float_bits(velocity));
+        hash_change += mixed_change(HASH_BIRD_Y + b, float_bits(birds->y[b]), float_bits(y));
+        birds->velocity[b] = velocity;
+        birds->y[b] = y;
+        birds->row[b] = max_int(row, 0);
+
+        int bird_top = birds->row[b];
+        int bird_bottom = bird_top + BIRD_HEIGHT;
+        dead |= bird_bottom > SCREEN_HEIGHT - GROUND_HEIGHT;
+
+        // Both rects share the horizontal span, so test it once; the bird is
+        // always below the top of the screen and above its bottom while alive,
+        // so only the edges facing the gap need comparing
+        for (int i = 0; i < pipes->count; i++)
+        {
+            int x = pipes->x[i];
+            int overlap_x = (BIRD_X + BIRD_WIDTH > x) & (BIRD_X < x + PIPE_WIDTH);
+            int outside_gap = (bird_top < pipes->gap_y[i] - PIPE_GAP / 2) |
+                              (bird_bottom > pipes->gap_y[i] + PIPE_GAP / 2);
+            hit_pipe |= overlap_x & outside_gap;
+        }
+    }
+
+    // Pickups come and go rarely, so they keep their branches
+    if (world->features & WORLD_PICKUPS)
+    {
+        hash_change += pickup_system(world);
+    }
+    dead |= hit_pipe & (world->shield_ticks == 0);
+
+    // Every live pipe is scored by mask
+    for (int i = 0; i < pipes->count; i++)
+    {
+        int newly_passed = !pipes->passed[i] & (pipes->x[i] + PIPE_WIDTH < BIRD_X);
+        hash_change += world_hash_linear(HASH_PIPE_PASSED + i, newly_passed);
+        pipes->passed[i] |= newly_passed;
+        score += newly_passed;
+    }
+
+    hash_change += world_hash_linear(HASH_SCORE, score - world->score);
+    hash_change += world_hash_linear(HASH_GAME_OVER, (world->game_over | dead) - world->game_over);
+    world->score = score;
+    world->game_over |= dead;
+    world->hash += hash_change;
+}
+
+static uint32_t rotl32(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+void rng_seed(Rng *rng, uint64_t seed)
+{
+    // Expand the seed with splitmix64 so nearby seeds give unrelated courses
+    for (int i = 0; i < 4; i += 2)
+    {
+        seed += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        rng->s[i] = (uint32_t)z;
+        rng->s[i + 1] = (uint32_t)(z >> 32);
+    }
+}
+
+uint32_t rng_next(Rng *rng)
+{
+    uint32_t *s = rng->s;
+    uint32_t result = rotl32(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl32(s[3], 11);
+
+    return result;
+}
+
+uint32_t rng_range(Rng *rng, uint32_t n)
+{
+    // Lemire's multiply-shift with rejection: uniform in [0, n) without modulo bias
+    uint64_t m = (uint64_t)rng_next(rng) * n;
+    uint32_t low = (uint32_t)m;
+    if (low < n)
+    {
+        uint32_t threshold = -n % n;
+        while (low < threshold)
+        {
+            m = (uint64_t)rng_next(rng) * n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
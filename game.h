@@ -0,0 +1,250 @@
+/**
+ * Headless game simulation
+ * Everything needed to step a world without SDL, shared by the game,
+ * replays, benchmarks and tools.
+ */
+
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Window dimensions
+#define SCREEN_WIDTH 800
+#define SCREEN_HEIGHT 600
+
+// Game constants
+#define BIRD_WIDTH 40
+#define BIRD_HEIGHT 30
+#define GRAVITY 0.4
+#define JUMP_FORCE -8.0
+#define PIPE_WIDTH 60
+#define PIPE_GAP 170
+#define PIPE_SPEED 3
+#define MAX_PIPES 10
+#define MAX_BIRDS 1 // the player
+#define PIPE_SPAWN_TIME 1500 // milliseconds
+#define GROUND_HEIGHT 20
+
+// Simulation timing
+#define TICK_RATE 60 // fixed simulation ticks per second
+#define TICK_MS (1000.0 / TICK_RATE)
+#define PIPE_SPAWN_TICKS (PIPE_SPAWN_TIME * TICK_RATE / 1000)
+
+// Pipe gap range used when spawning pipes
+#define MIN_GAP_Y (PIPE_GAP / 2 + 50)
+#define MAX_GAP_Y (SCREEN_HEIGHT - PIPE_GAP / 2 - 50)
+
+// Birds fly in a fixed column; the pipes scroll past them
+#define BIRD_X (SCREEN_WIDTH / 4)
+
+// Optional features, picked at reset (and recorded in replays)
+#define WORLD_PICKUPS 1u     // coins and shields between the pipes
+#define WORLD_MOVING_GAPS 2u // gaps that slide up and down
+
+// Pickups
+#define MAX_PICKUPS 128
+#define PICKUP_SIZE 16
+#define SHIELD_TICKS 120 // how long a shield lets the bird through pipes
+#define BONUS_EVERY 8    // every 8th gap between pipes is packed with coins
+
+// Pickups are filed in a uniform grid over scroll space (screen x plus
+// PIPE_SPEED * tick, where they stand still). Columns wrap around, and the
+// ring is wider than the span of live pickups, so no two live columns share
+// a slot.
+#define PICKUP_CELL 64
+#define PICKUP_GRID_COLS 32
+#define PICKUP_GRID_ROWS ((SCREEN_HEIGHT + PICKUP_CELL - 1) / PICKUP_CELL)
+#define PICKUP_GRID_CELLS (PICKUP_GRID_COLS * PICKUP_GRID_ROWS)
+
+// Same layout as SDL_Rect so the renderer can hand it straight to SDL
+typedef struct
+{
+    int x, y, w, h;
+} Rect;
+
+// Entities are grouped by archetype, the set of components they have.
+// Each archetype is a table with one array per component and its live
+// entities packed at the front, so systems walk contiguous arrays and a
+// new kind of entity is a new table plus the systems that read it.
+typedef struct
+{
+    int count;
+    float y[MAX_BIRDS];
+    float velocity[MAX_BIRDS];
+    int row[MAX_BIRDS]; // top of the collision box in whole pixels
+} Birds;
+
+typedef enum
+{
+    GAP_STILL,
+    GAP_SINE,
+    GAP_PING_PONG
+} GapMotion;
+
+typedef struct
+{
+    int count; // oldest first; a pipe leaves once it is off the left edge
+    int x[MAX_PIPES];
+    int gap_y[MAX_PIPES];
+    bool passed[MAX_PIPES];
+
+    // Gap motion, only with WORLD_MOVING_GAPS (all zero otherwise): gap_y
+    // is worked out from these and the pipe's age every tick, never stepped
+    int gap_base[MAX_PIPES]; // centre of the motion
+    uint8_t motion[MAX_PIPES]; // GapMotion
+    int16_t amplitude[MAX_PIPES];
+    int16_t period[MAX_PIPES]; // ticks
+    uint32_t spawn_tick[MAX_PIPES];
+} Pipes;
+
+typedef enum
+{
+    PICKUP_COIN,
+    PICKUP_SHIELD,
+    PICKUP_NONE // collected or gone, dropped at the next sort
+} PickupKind;
+
+typedef struct
+{
+    int count;                 // sorted by grid cell
+    int32_t x[MAX_PICKUPS];    // left edge in scroll space
+    int16_t y[MAX_PICKUPS];
+    uint8_t kind[MAX_PICKUPS]; // PickupKind
+    uint8_t cell_start[PICKUP_GRID_CELLS + 1]; // cell c holds [cell_start[c], cell_start[c + 1])
+} Pickups;
+
+// xoshiro128** state; gives every course its own reproducible pipe sequence
+typedef struct
+{
+    uint32_t s[4];
+} Rng;
+
+// Complete state of one game; plain data, so copying it takes a snapshot
+typedef struct
+{
+    Birds birds;
+    Pipes pipes;
+    bool game_over;
+    int score;
+    uint32_t tick;
+    uint32_t last_pipe_tick;
+    Rng rng;
+    uint32_t features; // WORLD_* flags
+
+    // Only used with WORLD_PICKUPS; pickups draw from their own generator
+    // so the pipes are the same either way
+    Pickups pickups;
+    Rng pickup_rng;
+    int coins;
+    int shield_ticks;
+
+    // Only used with WORLD_MOVING_GAPS, likewise separate from the pipes'
+    Rng motion_rng;
+
+    uint64_t hash; // world_hash_full(world), kept up to date as fields change
+} World;
+
+// The world hash is a sum of one term per hashed field (rects are left
+// out since they follow from the rest), so changing a field means
+// subtracting its old term and adding the new one. Table slots are keyed
+// by position, so dropping the oldest pipe rehashes the ones that move
+// down, a handful once every PIPE_SPAWN_TICKS. Counters and positions that
+// move by small steps every tick get linear terms, value * key, which turn
+// the usual per-tick changes into one add each; floats, RNG words and gap
+// heights get mixed terms.
+enum
+{
+    HASH_BIRD_Y,                       // + bird
+    HASH_BIRD_VELOCITY = HASH_BIRD_Y + MAX_BIRDS,
+    HASH_GAME_OVER = HASH_BIRD_VELOCITY + MAX_BIRDS,
+    HASH_SCORE,
+    HASH_TICK,
+    HASH_LAST_PIPE_TICK,
+    HASH_PIPE_COUNT,
+    HASH_RNG,                          // + word, 4 words
+    HASH_PIPE_X = HASH_RNG + 4,        // + slot
+    HASH_PIPE_GAP_Y = HASH_PIPE_X + MAX_PIPES,
+    HASH_PIPE_PASSED = HASH_PIPE_GAP_Y + MAX_PIPES,
+    HASH_FEATURES = HASH_PIPE_PASSED + MAX_PIPES,
+    HASH_COINS,
+    HASH_SHIELD_TICKS,
+    HASH_PICKUP_COUNT,
+    HASH_PICKUP_RNG,                   // + word, 4 words
+    HASH_PICKUP_X = HASH_PICKUP_RNG + 4, // + slot
+    HASH_PICKUP_Y = HASH_PICKUP_X + MAX_PICKUPS, // + slot; y and kind
+    HASH_MOTION_RNG = HASH_PICKUP_Y + MAX_PICKUPS, // + word, 4 words
+    HASH_PIPE_MOTION = HASH_MOTION_RNG + 4,      // + slot; all but spawn_tick, which x implies
+    HASH_FIELDS = HASH_PIPE_MOTION + MAX_PIPES
+};
+
+// Odd, so every nonzero change to a linear field changes the hash
+static inline uint64_t world_hash_key(uint32_t field)
+{
+    return ((field + 1) * 0x9E3779B97F4A7C15ULL) | 1;
+}
+
+static inline uint64_t world_hash_mixed(uint32_t field, uint32_t value)
+{
+    uint64_t x = (value ^ world_hash_key(field)) * 0xFF51AFD7ED558CCDULL;
+    return x ^ (x >> 32);
+}
+
+static inline uint64_t world_hash_linear(uint32_t field, int64_t value)
+{
+    return (uint64_t)value * world_hash_key(field);
+}
+
+// Collision boxes, derived from the components
+static inline Rect bird_rect(const Birds *birds, int b)
+{
+    return (Rect){BIRD_X, birds->row[b], BIRD_WIDTH, BIRD_HEIGHT};
+}
+
+static inline Rect pipe_top_rect(const Pipes *pipes, int i)
+{
+    return (Rect){pipes->x[i], 0, PIPE_WIDTH, pipes->gap_y[i] - PIPE_GAP / 2};
+}
+
+static inline Rect pipe_bottom_rect(const Pipes *pipes, int i)
+{
+    int top = pipes->gap_y[i] + PIPE_GAP / 2;
+    return (Rect){pipes->x[i], top, PIPE_WIDTH, SCREEN_HEIGHT - top};
+}
+
+typedef void (*UpdateFn)(World *world);
+
+void world_reset(World *world, uint64_t seed);
+void world_reset_features(World *world, uint64_t seed, uint32_t features);
+void world_jump(World *world);
+void create_pipe(World *world);
+bool check_collision(Rect a, Rect b);
+void update_game(World *world);
+void update_game_branchless(World *world);
+
+// Offset of a moving gap from its centre, age ticks after its pipe
+// spawned; a closed form, so any tick costs the same
+int gap_motion_offset(GapMotion motion, int amplitude, int period, uint32_t age);
+
+// Draws the motion of a new pipe's gap around base, keeping it on screen
+void gap_motion_draw(Rng *rng, int base, uint8_t *motion, int16_t *amplitude, int16_t *period);
+
+// Screen x of a pickup's left edge on the world's current tick
+static inline int pickup_screen_x(const World *world, int i)
+{
+    return world->pickups.x[i] - PIPE_SPEED * (int32_t)world->tick;
+}
+
+// Indices of the pickups touching bird b, found through the grid; returns
+// how many
+int world_pickups_touching(const World *world, int b, int *hits);
+
+// Hash of the world computed from scratch
+uint64_t world_hash_full(const World *world);
+
+void rng_seed(Rng *rng, uint64_t seed);
+uint32_t rng_next(Rng *rng);
+uint32_t rng_range(Rng *rng, uint32_t n);
+
+#endif
@@ -0,0 +1,418 @@
+/**
+ * Post-processing
+ * Row kernels for scalar, SSE2 (no gather, so grading is looked up one
+ * pixel at a time), AVX2 and AVX-512, compiled with target attributes and
+ * picked through cpu_dispatch, and the worker pool that runs them on
+ * bands of rows.
+ *
+ * A channel c under weight w becomes (2c * w) >> 16, which is what
+ * _mm_mulhi_epu16 gives on channels widened to 16 bits, and w is the
+ * column weight times the row weight the same way. Alpha passes through.
+ */
+
+#include "postfx.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define POSTFX_X86 1
+#endif
+
+#define SCANLINE_WEIGHT 0.7 // brightness of the odd rows
+#define VIGNETTE_POWER 0.2  // higher darkens the edges more
+#define BLACK 0xFF000000u
+#define ALPHA 0xFF000000u
+
+static uint16_t to_weight(double w)
+{
+    return (uint16_t)lround(w * POSTFX_ONE);
+}
+
+// Brightness at u across the screen (0 to 1): 1 in the middle, falling
+// toward the edges; the product of one across and one down gives the
+// classic rounded-rectangle vignette
+static double vignette(double u)
+{
+    return pow(4 * u * (1 - u), VIGNETTE_POWER);
+}
+
+// Arcade look: more contrast, warm highlights and slightly lifted blue
+// shadows
+static void build_grade(PostFx *fx)
+{
+    // Red, green, blue: the order of fx->grade
+    static const double gains[3] = {1.06, 1.0, 0.92};
+    static const double lifts[3] = {0.0, 0.0, 0.03};
+    static const int shifts[3] = {16, 8, 0};
+    for (int c = 0; c < 3; c++)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            double v = i / 255.0;
+            double curved = v * v * (3 - 2 * v);
+            v = lifts[c] + (1 - lifts[c]) * (0.5 * v + 0.5 * curved) * gains[c];
+            long level = lround(255 * (v < 0 ? 0 : v > 1 ? 1 : v));
+            fx->grade[c][i] = (uint32_t)level << shifts[c];
+        }
+    }
+}
+
+static inline uint32_t grade_pixel(const uint32_t (*grade)[256], uint32_t p)
+{
+    return grade[0][(p >> 16) & 0xFF] | grade[1][(p >> 8) & 0xFF] | grade[2][p & 0xFF];
+}
+
+// Kernels: n pixels from src to dst, graded if grade isn't NULL, then
+// weighed if weigh is set
+
+static void row_scalar(uint32_t *dst, const uint32_t *src, int n, const uint16_t *column_weights,
+                       uint16_t row_weight, const uint32_t (*grade)[256], bool weigh)
+{
+    for (int x = 0; x < n; x++)
+    {
+        uint32_t p = src[x];
+        uint32_t out = grade != NULL ? grade_pixel(grade, p) : p;
+        if (weigh)
+        {
+            uint32_t weighed = 0;
+            for (int c = 0; c < 3; c++)
+            {
+                uint32_t w = ((uint32_t)column_weights[4 * x + c] * row_weight >> 16) << 1;
+                uint32_t level = (out >> (8 * c)) & 0xFF;
+                weighed |= ((level << 1) * w >> 16) << (8 * c);
+            }
+            out = weighed;
+        }
+        dst[x] = (out & ~ALPHA) | (p & ALPHA);
+    }
+}
+
+#ifdef POSTFX_X86
+
+// Rows of a shaken frame start anywhere, so every kernel loads and stores
+// unaligned and finishes the tail with the scalar kernel
+
+__attribute__((target("sse2"))) static __m128i weights_sse2(const uint16_t *column_weights, __m128i row)
+{
+    return _mm_slli_epi16(_mm_mulhi_epu16(_mm_loadu_si128((const __m128i *)column_weights), row), 1);
+}
+
+__attribute__((target("sse2"))) static void row_sse2(uint32_t *dst, const uint32_t *src, int n,
+                                                     const uint16_t *column_weights, uint16_t row_weight,
+                                                     const uint32_t (*grade)[256], bool weigh)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i row = _mm_set1_epi16((short)row_weight);
+    __m128i alpha = _mm_set1_epi32((int)ALPHA);
+    int x = 0;
+    for (; x + 4 <= n; x += 4)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i out = p;
+        if (grade != NULL)
+        {
+            out = _mm_setr_epi32((int)grade_pixel(grade, src[x]), (int)grade_pixel(grade, src[x + 1]),
+                                 (int)grade_pixel(grade, src[x + 2]), (int)grade_pixel(grade, src[x + 3]));
+        }
+        if (weigh)
+        {
+            __m128i lo = _mm_unpacklo_epi8(out, zero), hi = _mm_unpackhi_epi8(out, zero);
+            lo = _mm_mulhi_epu16(_mm_slli_epi16(lo, 1), weights_sse2(column_weights + 4 * x, row));
+            hi = _mm_mulhi_epu16(_mm_slli_epi16(hi, 1), weights_sse2(column_weights + 4 * x + 8, row));
+            out = _mm_packus_epi16(lo, hi);
+        }
+        out = _mm_or_si128(_mm_andnot_si128(alpha, out), _mm_and_si128(alpha, p));
+        _mm_storeu_si128((__m128i *)(dst + x), out);
+    }
+    row_scalar(dst + x, src + x, n - x, column_weights + 4 * x, row_weight, grade, weigh);
+}
+
+__attribute__((target("avx2"))) static __m256i weights_avx2(const uint16_t *column_weights, __m256i row)
+{
+    return _mm256_slli_epi16(_mm256_mulhi_epu16(_mm256_loadu_si256((const __m256i *)column_weights), row), 1);
+}
+
+__attribute__((target("avx2"))) static void row_avx2(uint32_t *dst, const uint32_t *src, int n,
+                                                     const uint16_t *column_weights, uint16_t row_weight,
+                                                     const uint32_t (*grade)[256], bool weigh)
+{
+    __m256i row = _mm256_set1_epi16((short)row_weight);
+    __m256i alpha = _mm256_set1_epi32((int)ALPHA);
+    __m256i byte = _mm256_set1_epi32(0xFF);
+    int x = 0;
+    for (; x + 8 <= n; x += 8)
+    {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(src + x));
+        __m256i out = p;
+        if (grade != NULL)
+        {
+            __m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 16), byte);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 8), byte);
+            __m256i b = _mm256_and_si256(p, byte);
+            out = _mm256_or_si256(_mm256_i32gather_epi32((const int *)grade[0], r, 4),
+                                  _mm256_or_si256(_mm256_i32gather_epi32((const int *)grade[1], g, 4),
+                                                  _mm256_i32gather_epi32((const int *)grade[2], b, 4)));
+        }
+        if (weigh)
+        {
+            // Widening each half keeps the channels in memory order, and
+            // so in step with the column weights
+            __m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(out));
+            __m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(out, 1));
+            lo = _mm256_mulhi_epu16(_mm256_slli_epi16(lo, 1), weights_avx2(column_weights + 4 * x, row));
+            hi = _mm256_mulhi_epu16(_mm256_slli_epi16(hi, 1), weights_avx2(column_weights + 4 * x + 16, row));
+            // Packing works within 128-bit lanes; put the quarters back
+            out = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+        }
+        out = _mm256_or_si256(_mm256_andnot_si256(alpha, out), _mm256_and_si256(alpha, p));
+        _mm256_storeu_si256((__m256i *)(dst + x), out);
+    }
+    row_scalar(dst + x, src + x, n - x, column_weights + 4 * x, row_weight, grade, weigh);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static __m512i weights_avx512(const uint16_t *column_weights, __m512i row)
+{
+    return _mm512_slli_epi16(_mm512_mulhi_epu16(_mm512_loadu_si512(column_weights), row), 1);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void row_avx512(uint32_t *dst, const uint32_t *src, int n,
+                                                                   const uint16_t *column_weights,
+                                                                   uint16_t row_weight,
+                                                                   const uint32_t (*grade)[256], bool weigh)
+{
+    __m512i row = _mm512_set1_epi16((short)row_weight);
+    __m512i alpha = _mm512_set1_epi32((int)ALPHA);
+    __m512i byte = _mm512_set1_epi32(0xFF);
+    int x = 0;
+    for (; x + 16 <= n; x += 16)
+    {
+        __m512i p = _mm512_loadu_si512(src + x);
+        __m512i out = p;
+        if (grade != NULL)
+        {
+            __m512i r = _mm512_and_si512(_mm512_srli_epi32(p, 16), byte);
+            __m512i g = _mm512_and_si512(_mm512_srli_epi32(p, 8), byte);
+            __m512i b = _mm512_and_si512(p, byte);
+            out = _mm512_or_si512(_mm512_i32gather_epi32(r, grade[0], 4),
+                                  _mm512_or_si512(_mm512_i32gather_epi32(g, grade[1], 4),
+                                                  _mm512_i32gather_epi32(b, grade[2], 4)));
+        }
+        if (weigh)
+        {
+            __m512i lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(out));
+            __m512i hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(out, 1));
+            lo = _mm512_mulhi_epu16(_mm512_slli_epi16(lo, 1), weights_avx512(column_weights + 4 * x, row));
+            hi = _mm512_mulhi_epu16(_mm512_slli_epi16(hi, 1), weights_avx512(column_weights + 4 * x + 32, row));
+            out = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi16_epi8(lo)), _mm512_cvtepi16_epi8(hi), 1);
+        }
+        out = _mm512_or_si512(_mm512_andnot_si512(alpha, out), _mm512_and_si512(alpha, p));
+        _mm512_storeu_si512(dst + x, out);
+    }
+    row_scalar(dst + x, src + x, n - x, column_weights + 4 * x, row_weight, grade, weigh);
+}
+
+#endif
+
+typedef void (*RowKernel)(uint32_t *dst, const uint32_t *src, int n, const uint16_t *column_weights,
+                          uint16_t row_weight, const uint32_t (*grade)[256], bool weigh);
+
+// Indexed by SimdLevel
+#ifdef POSTFX_X86
+static const RowKernel row_kernels[SIMD_LEVEL_COUNT] = {row_scalar, row_sse2, row_avx2, row_avx512};
+#else
+static const RowKernel row_kernels[SIMD_LEVEL_COUNT] = {row_scalar, row_scalar, row_scalar, row_scalar};
+#endif
+
+static void fill_black(uint32_t *row, int n)
+{
+    for (int x = 0; x < n; x++)
+        row[x] = BLACK;
+}
+
+void postfx_apply_rows(const PostFx *fx, const Framebuffer *src, Framebuffer *dst, int y0, int y1, SimdLevel level)
+{
+    RowKernel kernel = row_kernels[level];
+    const uint32_t (*grade)[256] = fx->effects & POSTFX_GRADE ? fx->grade : NULL;
+    bool weigh = (fx->effects & (POSTFX_SCANLINES | POSTFX_VIGNETTE)) != 0;
+    int dx = fx->effects & POSTFX_SHAKE ? fx->shake_x : 0;
+    int dy = fx->effects & POSTFX_SHAKE ? fx->shake_y : 0;
+
+    // Output x0 to x1 has source pixels; the rest is uncovered edge
+    int x0 = dx > 0 ? dx : 0;
+    int x1 = dx < 0 ? fx->width + dx : fx->width;
+    for (int y = y0; y < y1; y++)
+    {
+        uint32_t *out = dst->pixels + (size_t)y * dst->pitch;
+        int source_y = y - dy;
+        if (source_y < 0 || source_y >= fx->height || x0 >= x1)
+        {
+            fill_black(out, fx->width);
+            continue;
+        }
+        const uint32_t *in = src->pixels + (size_t)source_y * src->pitch;
+        fill_black(out, x0);
+        kernel(out + x0, in + x0 - dx, x1 - x0, fx->column_weights + 4 * x0, fx->row_weights[y], grade, weigh);
+        fill_black(out + x1, fx->width - x1);
+    }
+}
+
+// Band b of the frame's rows
+static void apply_band(const PostFx *fx, const Framebuffer *src, Framebuffer *dst, int band)
+{
+    int y0 = (int)((int64_t)fx->height * band / fx->num_threads);
+    int y1 = (int)((int64_t)fx->height * (band + 1) / fx->num_threads);
+    postfx_apply_rows(fx, src, dst, y0, y1, fx->level);
+}
+
+static void *worker_main(void *arg)
+{
+    PostFxWorker *worker = arg;
+    PostFx *fx = worker->fx;
+    uint64_t seen = 0;
+    pthread_mutex_lock(&fx->lock);
+    for (;;)
+    {
+        while (fx->generation == seen && !fx->quit)
+            pthread_cond_wait(&fx->start, &fx->lock);
+        if (fx->quit)
+            break;
+        seen = fx->generation;
+        const Framebuffer *src = fx->src;
+        Framebuffer *dst = fx->dst;
+        pthread_mutex_unlock(&fx->lock);
+
+        apply_band(fx, src, dst, worker->band);
+
+        pthread_mutex_lock(&fx->lock);
+        if (--fx->pending == 0)
+            pthread_cond_signal(&fx->done);
+    }
+    pthread_mutex_unlock(&fx->lock);
+    return NULL;
+}
+
+bool postfx_init(PostFx *fx, int width, int height, uint32_t effects, int threads)
+{
+    memset(fx, 0, sizeof(*fx));
+    fx->effects = effects;
+    fx->width = width;
+    fx->height = height;
+    fx->level = simd_level();
+    fx->column_weights = malloc((size_t)width * 4 * sizeof(uint16_t));
+    fx->row_weights = malloc((size_t)height * sizeof(uint16_t));
+    if (fx->column_weights == NULL || fx->row_weights == NULL)
+    {
+        free(fx->column_weights);
+        free(fx->row_weights);
+        return false;
+    }
+
+    build_grade(fx);
+    for (int x = 0; x < width; x++)
+    {
+        double w = effects & POSTFX_VIGNETTE ? vignette((x + 0.5) / width) : 1;
+        for (int c = 0; c < 4; c++)
+            fx->column_weights[4 * x + c] = to_weight(w);
+    }
+    for (int y = 0; y < height; y++)
+    {
+        double w = effects & POSTFX_VIGNETTE ? vignette((y + 0.5) / height) : 1;
+        if ((effects & POSTFX_SCANLINES) && (y & 1))
+            w *= SCANLINE_WEIGHT;
+        fx->row_weights[y] = to_weight(w);
+    }
+
+    threads = threads < 1 ? 1 : threads > POSTFX_MAX_THREADS ? POSTFX_MAX_THREADS : threads;
+    pthread_mutex_init(&fx->lock, NULL);
+    pthread_cond_init(&fx->start, NULL);
+    pthread_cond_init(&fx->done, NULL);
+    fx->num_threads = 1;
+    for (int t = 1; t < threads; t++)
+    {
+        PostFxWorker *worker = &fx->workers[t];
+        worker->fx = fx;
+        worker->band = t;
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0)
+            break; // run with the threads we got
+        fx->num_threads++;
+    }
+    return true;
+}
+
+void postfx_free(PostFx *fx)
+{
+    pthread_mutex_lock(&fx->lock);
+    fx->quit = true;
+    pthread_cond_broadcast(&fx->start);
+    pthread_mutex_unlock(&fx->lock);
+    for (int t = 1; t < fx->num_threads; t++)
+        pthread_join(fx->workers[t].thread, NULL);
+
+    pthread_cond_destroy(&fx->done);
+    pthread_cond_destroy(&fx->start);
+    pthread_mutex_destroy(&fx->lock);
+    free(fx->column_weights);
+    free(fx->row_weights);
+    fx->column_weights = NULL;
+    fx->row_weights = NULL;
+}
+
+void postfx_apply(PostFx *fx, const Framebuffer *src, Framebuffer *dst)
+{
+    if (fx->num_threads == 1)
+    {
+        postfx_apply_rows(fx, src, dst, 0, fx->height, fx->level);
+        return;
+    }
+
+    pthread_mutex_lock(&fx->lock);
+    fx->src = src;
+    fx->dst = dst;
+    fx->generation++;
+    fx->pending = fx->num_threads - 1;
+    pthread_cond_broadcast(&fx->start);
+    pthread_mutex_unlock(&fx->lock);
+
+    apply_band(fx, src, dst, 0);
+
+    pthread_mutex_lock(&fx->lock);
+    while (fx->pending > 0)
+        pthread_cond_wait(&fx->done, &fx->lock);
+    pthread_mutex_unlock(&fx->lock);
+}
+
+bool postfx_parse(const char *list, uint32_t *effects)
+{
+    static const struct
+    {
+        const char *name;
+        uint32_t effect;
+    } names[] = {
+        {"scanlines", POSTFX_SCANLINES}, {"grade", POSTFX_GRADE}, {"vignette", POSTFX_VIGNETTE},
+        {"shake", POSTFX_SHAKE},         {"all", POSTFX_ALL},
+    };
+
+    *effects = 0;
+    while (*list != '\0')
+    {
+        size_t length = strcspn(list, ",");
+        bool known = false;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+            if (strlen(names[i].name) == length && strncmp(list, names[i].name, length) == 0)
+            {
+                *effects |= names[i].effect;
+                known = true;
+            }
+        }
+        if (!known)
+            return false;
+        list += length;
+        if (*list == ',')
+            list++;
+    }
+    return true;
+}
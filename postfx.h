@@ -0,0 +1,90 @@
+/**
+ * Post-processing
+ * Full-screen effects for the software framebuffer: CRT scanlines, a
+ * color-grading lookup table, a vignette and screen shake. postfx_apply
+ * reads one framebuffer and writes another in a single pass, each row
+ * going through a SIMD kernel picked through cpu_dispatch. The rows are
+ * split into bands across a small pool of worker threads, with the
+ * calling thread taking the first band.
+ *
+ * Every kernel does the same fixed-point arithmetic, so all SIMD levels
+ * and thread counts give bit-identical frames.
+ */
+
+#ifndef POSTFX_H
+#define POSTFX_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu_dispatch.h"
+#include "raster.h"
+
+#define POSTFX_SCANLINES 1u // darken every other row
+#define POSTFX_GRADE 2u     // per-channel color curves
+#define POSTFX_VIGNETTE 4u  // darken toward the edges
+#define POSTFX_SHAKE 8u     // offset the frame by shake_x, shake_y
+#define POSTFX_ALL (POSTFX_SCANLINES | POSTFX_GRADE | POSTFX_VIGNETTE | POSTFX_SHAKE)
+
+#define POSTFX_MAX_THREADS 16
+#define POSTFX_ONE 32768 // weight of 1.0; weights are 1.15 fixed point
+
+typedef struct PostFx PostFx;
+
+typedef struct
+{
+    PostFx *fx;
+    int band;
+    pthread_t thread;
+} PostFxWorker;
+
+struct PostFx
+{
+    uint32_t effects;
+    int width, height;
+    SimdLevel level; // picked by postfx_init
+
+    // Graded value of each channel level, already shifted into place, so a
+    // pixel grades to grade[0][r] | grade[1][g] | grade[2][b]
+    uint32_t grade[3][256];
+
+    // Brightness is column_weights[x] times row_weights[y]; the column
+    // weights repeat once per channel so kernels can load them as bytes
+    // are widened
+    uint16_t *column_weights;
+    uint16_t *row_weights;
+
+    // Offset of the next frame in pixels, with POSTFX_SHAKE; uncovered
+    // edges are black
+    int shake_x, shake_y;
+
+    // Worker pool; the job fields are written under lock
+    int num_threads; // including the thread calling postfx_apply
+    PostFxWorker workers[POSTFX_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    uint64_t generation; // bumped for each frame
+    int pending;         // workers still on the current frame
+    bool quit;
+    const Framebuffer *src;
+    Framebuffer *dst;
+};
+
+// Sets up effects for width x height frames, processed by threads threads
+// (clamped to 1..POSTFX_MAX_THREADS)
+bool postfx_init(PostFx *fx, int width, int height, uint32_t effects, int threads);
+void postfx_free(PostFx *fx);
+
+// Applies the effects to src, writing dst; both must be the size given to
+// postfx_init and must not overlap
+void postfx_apply(PostFx *fx, const Framebuffer *src, Framebuffer *dst);
+
+// Rows y0 to y1 only, on the calling thread, at a given level
+void postfx_apply_rows(const PostFx *fx, const Framebuffer *src, Framebuffer *dst, int y0, int y1, SimdLevel level);
+
+// Parses a comma-separated list of effect names (scanlines, grade,
+// vignette, shake or all); false on an unknown name
+bool postfx_parse(const char *list, uint32_t *effects);
+
+#endif
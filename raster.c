@@ -0,0 +1,301 @@
+/**
+ * Software rasterizer
+ * Follows SDL's software renderer: rects are clipped half-open boxes and
+ * lines include both end points. Both framebuffer kinds draw through one
+ * set of routines that only differ in how wide a pixel is; expanding an
+ * indexed frame has AVX2 and AVX-512 kernels picked through cpu_dispatch.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "raster.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RASTER_X86 1
+#endif
+
+// Either kind of framebuffer, as drawing sees it
+typedef struct
+{
+    uint8_t *bytes;
+    int width, height;
+    size_t pitch; // bytes per row
+    int depth;    // bytes per pixel, 1 or 4
+} Canvas;
+
+bool framebuffer_init(Framebuffer *fb, int width, int height)
+{
+    // Rows padded to 16 pixels so each starts on a 64-byte boundary
+    int pitch = (width + 15) & ~15;
+    fb->pixels = aligned_alloc(64, (size_t)pitch * height * sizeof(uint32_t));
+    if (fb->pixels == NULL)
+        return false;
+
+    fb->width = width;
+    fb->height = height;
+    fb->pitch = pitch;
+    memset(fb->pixels, 0, (size_t)pitch * height * sizeof(uint32_t));
+    return true;
+}
+
+void framebuffer_free(Framebuffer *fb)
+{
+    free(fb->pixels);
+    fb->pixels = NULL;
+}
+
+bool indexed_framebuffer_init(IndexedFramebuffer *fb, int width, int height)
+{
+    // Rows padded to 64 pixels, one cache line
+    int pitch = (width + 63) & ~63;
+    fb->pixels = aligned_alloc(64, (size_t)pitch * height);
+    if (fb->pixels == NULL)
+        return false;
+
+    fb->width = width;
+    fb->height = height;
+    fb->pitch = pitch;
+    memset(fb->pixels, 0, (size_t)pitch * height);
+    memset(&fb->palette, 0, sizeof(fb->palette));
+    return true;
+}
+
+void indexed_framebuffer_free(IndexedFramebuffer *fb)
+{
+    free(fb->pixels);
+    fb->pixels = NULL;
+}
+
+uint8_t palette_index(Palette *palette, uint32_t color)
+{
+    for (int i = 0; i < palette->count; i++)
+    {
+        if (palette->colors[i] == color)
+            return (uint8_t)i;
+    }
+    if (palette->count == PALETTE_SIZE)
+        return PALETTE_SIZE - 1;
+    palette->colors[palette->count] = color;
+    return (uint8_t)palette->count++;
+}
+
+// color is the pixel value: ARGB, or a palette index
+static void fill_rect(Canvas *canvas, uint32_t color, int x0, int y0, int x1, int y1)
+{
+    if (x0 < 0)
+        x0 = 0;
+    if (y0 < 0)
+        y0 = 0;
+    if (x1 > canvas->width)
+        x1 = canvas->width;
+    if (y1 > canvas->height)
+        y1 = canvas->height;
+    if (x0 >= x1)
+        return;
+
+    for (int y = y0; y < y1; y++)
+    {
+        uint8_t *row = canvas->bytes + (size_t)y * canvas->pitch;
+        if (canvas->depth == 1)
+        {
+            memset(row + x0, (int)color, (size_t)(x1 - x0));
+            continue;
+        }
+        uint32_t *pixels = (uint32_t *)row;
+        for (int x = x0; x < x1; x++)
+        {
+            pixels[x] = color;
+        }
+    }
+}
+
+static void plot(Canvas *canvas, uint32_t color, int x, int y)
+{
+    if (x >= 0 && x < canvas->width && y >= 0 && y < canvas->height)
+    {
+        uint8_t *row = canvas->bytes + (size_t)y * canvas->pitch;
+        if (canvas->depth == 1)
+            row[x] = (uint8_t)color;
+        else
+            ((uint32_t *)row)[x] = color;
+    }
+}
+
+static void draw_line(Canvas *canvas, uint32_t color, int x0, int y0, int x1, int y1)
+{
+    // Axis-aligned lines (all the score digits use) are just thin rects
+    if (x0 == x1 || y0 == y1)
+    {
+        int left = x0 < x1 ? x0 : x1;
+        int top = y0 < y1 ? y0 : y1;
+        int right = x0 < x1 ? x1 : x0;
+        int bottom = y0 < y1 ? y1 : y0;
+        fill_rect(canvas, color, left, top, right + 1, bottom + 1);
+        return;
+    }
+
+    // Bresenham for everything else
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for (;;)
+    {
+        plot(canvas, color, x0, y0);
+        if (x0 == x1 && y0 == y1)
+            break;
+        int e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// palette is NULL for ARGB canvases
+static void draw_commands(Canvas *canvas, Palette *palette, const DrawList *list)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        const DrawCmd *cmd = &list->cmds[i];
+        uint32_t color = palette != NULL ? palette_index(palette, cmd->color) : cmd->color;
+        switch (cmd->op)
+        {
+        case DRAW_CLEAR:
+            fill_rect(canvas, color, 0, 0, canvas->width, canvas->height);
+            break;
+        case DRAW_RECT:
+            fill_rect(canvas, color, cmd->x0, cmd->y0, cmd->x1, cmd->y1);
+            break;
+        case DRAW_LINE:
+            draw_line(canvas, color, cmd->x0, cmd->y0, cmd->x1, cmd->y1);
+            break;
+        }
+    }
+}
+
+void raster_draw_list(Framebuffer *fb, const DrawList *list)
+{
+    Canvas canvas = {(uint8_t *)fb->pixels, fb->width, fb->height, (size_t)fb->pitch * sizeof(uint32_t), 4};
+    draw_commands(&canvas, NULL, list);
+}
+
+void raster_draw_list_indexed(IndexedFramebuffer *fb, const DrawList *list)
+{
+    Canvas canvas = {fb->pixels, fb->width, fb->height, (size_t)fb->pitch, 1};
+    draw_commands(&canvas, &fb->palette, list);
+}
+
+// Expansion kernels: n palette indices to ARGB pixels
+
+static void expand_scalar(uint32_t *out, const uint8_t *in, int n, const Palette *palette)
+{
+    for (int x = 0; x < n; x++)
+        out[x] = palette->colors[in[x]];
+}
+
+#ifdef RASTER_X86
+
+// A palette of up to 16 colours fits in registers, so lookups are
+// permutes; bigger ones need gathers. Texture rows have no alignment
+// promise, so stores are unaligned.
+
+__attribute__((target("avx2"))) static void expand_avx2(uint32_t *out, const uint8_t *in, int n,
+                                                        const Palette *palette)
+{
+    int x = 0;
+    if (palette->count <= 16)
+    {
+        __m256i low = _mm256_loadu_si256((const __m256i *)palette->colors);
+        __m256i high = _mm256_loadu_si256((const __m256i *)(palette->colors + 8));
+        __m256i seven = _mm256_set1_epi32(7);
+        for (; x + 8 <= n; x += 8)
+        {
+            __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(in + x)));
+            // Permutes use the index's low 3 bits; bit 3 picks the half
+            __m256i color = _mm256_blendv_epi8(_mm256_permutevar8x32_epi32(low, index),
+                                               _mm256_permutevar8x32_epi32(high, index),
+                                               _mm256_cmpgt_epi32(index, seven));
+            _mm256_storeu_si256((__m256i *)(out + x), color);
+        }
+    }
+    else
+    {
+        for (; x + 8 <= n; x += 8)
+        {
+            __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(in + x)));
+            _mm256_storeu_si256((__m256i *)(out + x),
+                                _mm256_i32gather_epi32((const int *)palette->colors, index, 4));
+        }
+    }
+    expand_scalar(out + x, in + x, n - x, palette);
+}
+
+__attribute__((target("avx512f"))) static void expand_avx512(uint32_t *out, const uint8_t *in, int n,
+                                                             const Palette *palette)
+{
+    int x = 0;
+    if (palette->count <= 16)
+    {
+        __m512i colors = _mm512_loadu_si512(palette->colors);
+        for (; x + 16 <= n; x += 16)
+        {
+            __m512i index = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(in + x)));
+            _mm512_storeu_si512(out + x, _mm512_permutexvar_epi32(index, colors));
+        }
+    }
+    else
+    {
+        for (; x + 16 <= n; x += 16)
+        {
+            __m512i index = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(in + x)));
+            _mm512_storeu_si512(out + x, _mm512_i32gather_epi32(index, palette->colors, 4));
+        }
+    }
+    expand_scalar(out + x, in + x, n - x, palette);
+}
+
+#endif
+
+typedef void (*ExpandKernel)(uint32_t *out, const uint8_t *in, int n, const Palette *palette);
+
+// Indexed by SimdLevel; SSE2 has no variable 32-bit shuffle, so it stays
+// scalar
+#ifdef RASTER_X86
+static const ExpandKernel expand_kernels[SIMD_LEVEL_COUNT] = {expand_scalar, expand_scalar, expand_avx2,
+                                                              expand_avx512};
+#else
+static const ExpandKernel expand_kernels[SIMD_LEVEL_COUNT] = {expand_scalar, expand_scalar, expand_scalar,
+                                                              expand_scalar};
+#endif
+
+static void expand_rect(const IndexedFramebuffer *fb, uint32_t *out, int pitch, Rect rect, SimdLevel level)
+{
+    ExpandKernel kernel = expand_kernels[level];
+    for (int y = rect.y; y < rect.y + rect.h; y++)
+    {
+        kernel(out + (size_t)y * pitch + rect.x, fb->pixels + (size_t)y * fb->pitch + rect.x, rect.w, &fb->palette);
+    }
+}
+
+void indexed_expand_with(const IndexedFramebuffer *fb, uint32_t *out, int pitch, SimdLevel level)
+{
+    expand_rect(fb, out, pitch, (Rect){0, 0, fb->width, fb->height}, level);
+}
+
+void indexed_expand(const IndexedFramebuffer *fb, uint32_t *out, int pitch)
+{
+    indexed_expand_with(fb, out, pitch, simd_level());
+}
+
+void indexed_expand_rect(const IndexedFramebuffer *fb, uint32_t *out, int pitch, Rect rect)
+{
+    expand_rect(fb, out, pitch, rect, simd_level());
+}
@@ -0,0 +1,67 @@
+/**
+ * Software rasterizer
+ * Draws a DrawList into a 32-bit ARGB framebuffer in memory. The game can
+ * show it through a streaming texture, and tests compare it pixel by pixel.
+ *
+ * The scene only has a handful of colours, so it can also be drawn into an
+ * 8-bit indexed framebuffer with a palette, a quarter of the memory
+ * traffic, and expanded to ARGB only on the way to the texture.
+ */
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu_dispatch.h"
+#include "render.h"
+
+#define PALETTE_SIZE 256
+
+typedef struct
+{
+    int width, height;
+    int pitch; // pixels per row
+    uint32_t *pixels;
+} Framebuffer;
+
+// Colours get indices as they are first drawn, so the same colour keeps
+// its index from frame to frame
+typedef struct
+{
+    uint32_t colors[PALETTE_SIZE]; // 0xAARRGGBB; unused entries are 0
+    int count;
+} Palette;
+
+typedef struct
+{
+    int width, height;
+    int pitch; // bytes (and pixels) per row
+    uint8_t *pixels;
+    Palette palette;
+} IndexedFramebuffer;
+
+bool framebuffer_init(Framebuffer *fb, int width, int height);
+void framebuffer_free(Framebuffer *fb);
+
+bool indexed_framebuffer_init(IndexedFramebuffer *fb, int width, int height);
+void indexed_framebuffer_free(IndexedFramebuffer *fb);
+
+// Index of color, added to the palette if new; once the palette is full
+// new colours share its last entry
+uint8_t palette_index(Palette *palette, uint32_t color);
+
+// Draws every command, clipped to the framebuffer
+void raster_draw_list(Framebuffer *fb, const DrawList *list);
+void raster_draw_list_indexed(IndexedFramebuffer *fb, const DrawList *list);
+
+// Looks every pixel up in the palette, writing ARGB rows pitch pixels apart
+// (a locked texture, say)
+void indexed_expand(const IndexedFramebuffer *fb, uint32_t *out, int pitch);
+void indexed_expand_with(const IndexedFramebuffer *fb, uint32_t *out, int pitch, SimdLevel level);
+
+// Only the pixels in rect, to the same place in out
+void indexed_expand_rect(const IndexedFramebuffer *fb, uint32_t *out, int pitch, Rect rect);
+
+#endif
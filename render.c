@@ -0,0 +1,135 @@
+/**
+ * Frame description
+ * The layout here is what render_game used to issue as SDL calls directly.
+ */
+
+#include "render.h"
+
+#define COLOR_SKY 0xFF87CEFAu
+#define COLOR_PIPE 0xFF008000u
+#define COLOR_GROUND 0xFF8B4513u
+#define COLOR_BIRD 0xFFFFFF00u
+#define COLOR_BIRD_SHIELDED 0xFF00FFFFu
+#define COLOR_COIN 0xFFFFD700u
+#define COLOR_SHIELD 0xFF00BFFFu
+#define COLOR_GAME_OVER 0xFFFF0000u
+#define COLOR_SCORE 0xFFFFFFFFu
+
+static void push(DrawList *list, DrawOp op, uint32_t color, int x0, int y0, int x1, int y1)
+{
+    if (list->count < MAX_DRAW_CMDS)
+    {
+        list->cmds[list->count++] = (DrawCmd){op, color, x0, y0, x1, y1};
+    }
+}
+
+static void push_rect(DrawList *list, uint32_t color, int x, int y, int w, int h)
+{
+    push(list, DRAW_RECT, color, x, y, x + w, y + h);
+}
+
+static void push_line(DrawList *list, uint32_t color, int x0, int y0, int x1, int y1)
+{
+    push(list, DRAW_LINE, color, x0, y0, x1, y1);
+}
+
+void render_world(DrawList *list, const World *world)
+{
+    list->count = 0;
+
+    // Sky
+    push(list, DRAW_CLEAR, COLOR_SKY, 0, 0, 0, 0);
+
+    // Pipes
+    const Pipes *pipes = &world->pipes;
+    for (int i = 0; i < pipes->count; i++)
+    {
+        if (pipes->x[i] + PIPE_WIDTH > 0 && pipes->x[i] < SCREEN_WIDTH)
+        {
+            Rect top = pipe_top_rect(pipes, i);
+            Rect bottom = pipe_bottom_rect(pipes, i);
+            push_rect(list, COLOR_PIPE, top.x, top.y, top.w, top.h);
+            push_rect(list, COLOR_PIPE, bottom.x, bottom.y, bottom.w, bottom.h);
+        }
+    }
+
+    // Pickups
+    for (int i = 0; i < world->pickups.count; i++)
+    {
+        int x = pickup_screen_x(world, i);
+        if (x + PICKUP_SIZE > 0 && x < SCREEN_WIDTH)
+        {
+            uint32_t color = world->pickups.kind[i] == PICKUP_SHIELD ? COLOR_SHIELD : COLOR_COIN;
+            push_rect(list, color, x, world->pickups.y[i], PICKUP_SIZE, PICKUP_SIZE);
+        }
+    }
+
+    // Ground
+    push_rect(list, COLOR_GROUND, 0, SCREEN_HEIGHT - GROUND_HEIGHT, SCREEN_WIDTH, GROUND_HEIGHT);
+
+    // Birds
+    for (int b = 0; b < world->birds.count; b++)
+    {
+        Rect bird = bird_rect(&world->birds, b);
+        push_rect(list, world->shield_ticks > 0 ? COLOR_BIRD_SHIELDED : COLOR_BIRD, bird.x, bird.y, bird.w, bird.h);
+    }
+
+    // Game over indicator (red rectangle in center)
+    if (world->game_over)
+    {
+        push_rect(list, COLOR_GAME_OVER, SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 30, 200, 60);
+    }
+
+    // Score in the top-left corner, drawn from rectangles and lines since
+    // there is no font
+    int score_display = world->score;
+    int digit_width = 20;
+    int digit_spacing = 5;
+    int x = 20;
+
+    if (score_display == 0)
+    {
+        push_rect(list, COLOR_SCORE, x, 20, digit_width, 4);                       // top
+        push_rect(list, COLOR_SCORE, x, 20 + digit_width, digit_width, 4);         // bottom
+        push_rect(list, COLOR_SCORE, x, 20, 4, digit_width + 4);                   // left
+        push_rect(list, COLOR_SCORE, x + digit_width - 4, 20, 4, digit_width + 4); // right
+    }
+
+    while (score_display > 0)
+    {
+        int digit = score_display % 10;
+        score_display /= 10;
+
+        int right = x + digit_width;
+        int middle = 20 + digit_width / 2;
+        int bottom = 20 + digit_width;
+        switch (digit)
+        {
+        case 0:
+            push_line(list, COLOR_SCORE, x, 20, right, 20);
+            push_line(list, COLOR_SCORE, x, bottom, right, bottom);
+            push_line(list, COLOR_SCORE, x, 20, x, bottom);
+            push_line(list, COLOR_SCORE, right, 20, right, bottom);
+            break;
+
+        case 1:
+            push_line(list, COLOR_SCORE, right, 20, right, bottom);
+            break;
+
+        case 2:
+            push_line(list, COLOR_SCORE, x, 20, right, 20);
+            push_line(list, COLOR_SCORE, x, middle, right, middle);
+            push_line(list, COLOR_SCORE, x, bottom, right, bottom);
+            push_line(list, COLOR_SCORE, right, 20, right, middle);
+            push_line(list, COLOR_SCORE, x, middle, x, bottom);
+            break;
+
+        // Other digits are a filled block until they get segments
+        default:
+            push_rect(list, COLOR_SCORE, x, 20, digit_width, digit_width);
+            break;
+        }
+
+        x += digit_width + digit_spacing;
+    }
+}
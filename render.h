@@ -0,0 +1,40 @@
+/**
+ * Frame description
+ * Turns a world into a list of flat-colour draw commands without touching
+ * SDL, so the same frame can go to the SDL renderer, the software
+ * rasterizer or a golden-image test.
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdint.h>
+
+#include "game.h"
+
+#define MAX_DRAW_CMDS (128 + MAX_PICKUPS)
+
+typedef enum
+{
+    DRAW_CLEAR, // fill the whole target
+    DRAW_RECT,  // fill [x0, x1) x [y0, y1)
+    DRAW_LINE   // line from (x0, y0) to (x1, y1), both ends included
+} DrawOp;
+
+typedef struct
+{
+    DrawOp op;
+    uint32_t color; // 0xAARRGGBB
+    int x0, y0, x1, y1;
+} DrawCmd;
+
+typedef struct
+{
+    int count;
+    DrawCmd cmds[MAX_DRAW_CMDS];
+} DrawList;
+
+// Replaces the contents of list with the frame for world
+void render_world(DrawList *list, const World *world);
+
+#endif
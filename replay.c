@@ -0,0 +1,131 @@
+/**
+ * Replay files
+ * Loading, saving and headless playback of recorded runs.
+ */
+
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void replay_add_jump(Replay *replay, uint32_t tick)
+{
+    if (replay->num_jumps == replay->capacity)
+    {
+        uint32_t capacity = replay->capacity ? replay->capacity * 2 : 256;
+        uint32_t *jump_ticks = realloc(replay->jump_ticks, capacity * sizeof(uint32_t));
+        if (jump_ticks == NULL)
+        {
+            fprintf(stderr, "Out of memory recording replay\n");
+            return;
+        }
+        replay->jump_ticks = jump_ticks;
+        replay->capacity = capacity;
+    }
+    replay->jump_ticks[replay->num_jumps++] = tick;
+}
+
+bool replay_save(const Replay *replay, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Could not write replay %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "%s %d\n", REPLAY_MAGIC, REPLAY_VERSION);
+    fprintf(file, "seed %llu\n", (unsigned long long)replay->seed);
+    if (replay->features != 0)
+    {
+        // Left out for plain runs, so older readers still load those
+        fprintf(file, "features %u\n", replay->features);
+    }
+    fprintf(file, "ticks %u\n", replay->num_ticks);
+    fprintf(file, "score %d\n", replay->score);
+    fprintf(file, "jumps %u\n", replay->num_jumps);
+    for (uint32_t i = 0; i < replay->num_jumps; i++)
+    {
+        fprintf(file, "%u%c", replay->jump_ticks[i], (i % 16 == 15 || i + 1 == replay->num_jumps) ? '\n' : ' ');
+    }
+
+    return fclose(file) == 0;
+}
+
+bool replay_load(Replay *replay, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    char magic[32];
+    int version;
+    unsigned long long seed;
+    unsigned int features = 0, num_ticks, num_jumps;
+    int score;
+    bool ok = fscanf(file, "%31s %d", magic, &version) == 2 &&
+              strcmp(magic, REPLAY_MAGIC) == 0 && version == REPLAY_VERSION &&
+              fscanf(file, " seed %llu", &seed) == 1;
+
+    // Optional; a failed match stops at the 't' of "ticks" and leaves it
+    ok = ok && fscanf(file, " features %u", &features) != EOF;
+    ok = ok && fscanf(file, " ticks %u", &num_ticks) == 1 &&
+              fscanf(file, " score %d", &score) == 1 &&
+              fscanf(file, " jumps %u", &num_jumps) == 1;
+
+    replay_free(replay);
+    if (ok)
+    {
+        replay->seed = seed;
+        replay->features = features;
+        replay->num_ticks = num_ticks;
+        replay->score = score;
+
+        uint32_t previous = 0;
+        for (unsigned int i = 0; i < num_jumps && ok; i++)
+        {
+            unsigned int tick;
+            ok = fscanf(file, "%u", &tick) == 1 && tick >= previous;
+            if (ok)
+            {
+                replay_add_jump(replay, tick);
+                previous = tick;
+            }
+        }
+        ok = ok && replay->num_jumps == num_jumps;
+    }
+
+    fclose(file);
+    if (!ok)
+    {
+        replay_free(replay);
+    }
+    return ok;
+}
+
+void replay_free(Replay *replay)
+{
+    free(replay->jump_ticks);
+    memset(replay, 0, sizeof(*replay));
+}
+
+bool replay_run(const Replay *replay, World *world, UpdateFn update)
+{
+    uint32_t next_jump = 0;
+
+    world_reset_features(world, replay->seed, replay->features);
+    while (!world->game_over && world->tick < replay->num_ticks)
+    {
+        if (next_jump < replay->num_jumps && replay->jump_ticks[next_jump] == world->tick)
+        {
+            world_jump(world);
+            next_jump++;
+        }
+        update(world);
+    }
+
+    return world->game_over && world->tick == replay->num_ticks && world->score == replay->score;
+}
@@ -0,0 +1,36 @@
+/**
+ * Replay files
+ * A recorded run is the course seed (and optional features) plus the ticks
+ * on which the bird jumped.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.h"
+
+// Replay file header
+#define REPLAY_MAGIC "FLAPPY-REPLAY"
+#define REPLAY_VERSION 1
+
+typedef struct
+{
+    uint64_t seed;
+    uint32_t features; // WORLD_* flags the run was played with
+    uint32_t num_ticks;
+    int score;
+    uint32_t num_jumps;
+    uint32_t capacity;
+    uint32_t *jump_ticks;
+} Replay;
+
+void replay_add_jump(Replay *replay, uint32_t tick);
+bool replay_save(const Replay *replay, const char *path);
+bool replay_load(Replay *replay, const char *path);
+void replay_free(Replay *replay);
+
+// Resets world to the replay's course and plays it to the end with update;
+// returns true if the run ends on the recorded tick with the recorded score
+bool replay_run(const Replay *replay, World *world, UpdateFn update);
+
+#endif
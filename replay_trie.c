@@ -0,0 +1,446 @@
+/**
+ * Replay store
+ * A node is one jump; the path from a root spells out a replay's jump
+ * ticks as gaps. Snapshots are taken of the world with the node's jump
+ * applied, just before that tick's update.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay_trie.h"
+
+#define TRIE_MAGIC "FLAPPY-REPLAY-TRIE"
+#define TRIE_VERSION 1
+
+// Grows an array to hold at least count + 1 items; false when out of memory
+static bool reserve(void **items, uint32_t *capacity, uint32_t count, size_t size)
+{
+    if (count < *capacity)
+        return true;
+
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 256;
+    void *grown = realloc(*items, new_capacity * size);
+    if (grown == NULL)
+    {
+        fprintf(stderr, "Out of memory in replay store\n");
+        return false;
+    }
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static uint32_t add_node(ReplayTrie *trie, uint32_t parent, uint32_t delta)
+{
+    if (!reserve((void **)&trie->nodes, &trie->node_capacity, trie->num_nodes, sizeof(TrieNode)))
+        return TRIE_NONE;
+
+    uint32_t index = trie->num_nodes++;
+    TrieNode *node = &trie->nodes[index];
+    node->delta = delta;
+    node->parent = parent;
+    node->first_child = TRIE_NONE;
+    node->next_sibling = TRIE_NONE;
+    node->first_end = TRIE_NONE;
+    node->checkpoint = TRIE_NONE;
+
+    if (parent != TRIE_NONE)
+    {
+        node->next_sibling = trie->nodes[parent].first_child;
+        trie->nodes[parent].first_child = index;
+    }
+    return index;
+}
+
+static uint32_t add_root(ReplayTrie *trie, uint64_t seed)
+{
+    if (!reserve((void **)&trie->roots, &trie->root_capacity, trie->num_roots, sizeof(TrieRoot)))
+        return TRIE_NONE;
+
+    uint32_t node = add_node(trie, TRIE_NONE, 0);
+    if (node != TRIE_NONE)
+        trie->roots[trie->num_roots++] = (TrieRoot){seed, node};
+    return node;
+}
+
+static bool add_end(ReplayTrie *trie, uint32_t id, uint32_t node, uint32_t num_ticks, int score)
+{
+    while (trie->end_capacity <= id)
+    {
+        if (!reserve((void **)&trie->ends, &trie->end_capacity, trie->end_capacity, sizeof(TrieEnd)))
+            return false;
+    }
+    for (; trie->num_ends <= id; trie->num_ends++)
+        trie->ends[trie->num_ends].node = TRIE_NONE;
+
+    trie->ends[id] = (TrieEnd){node, num_ticks, score, trie->nodes[node].first_end};
+    trie->nodes[node].first_end = id;
+    return true;
+}
+
+static const TrieRoot *find_root(const ReplayTrie *trie, uint32_t node)
+{
+    while (trie->nodes[node].parent != TRIE_NONE)
+        node = trie->nodes[node].parent;
+
+    for (uint32_t r = 0; r < trie->num_roots; r++)
+    {
+        if (trie->roots[r].node == node)
+            return &trie->roots[r];
+    }
+    return NULL;
+}
+
+// Nodes that get a snapshot: paths split here or some replay ends here
+static bool is_branch(const ReplayTrie *trie, const TrieNode *node)
+{
+    return node->first_end != TRIE_NONE ||
+           (node->first_child != TRIE_NONE && trie->nodes[node->first_child].next_sibling != TRIE_NONE);
+}
+
+// False when out of memory, leaving the node without a snapshot
+static bool save_checkpoint(ReplayTrie *trie, uint32_t node, const World *world)
+{
+    if (trie->nodes[node].checkpoint != TRIE_NONE)
+        return true;
+    if (!reserve((void **)&trie->checkpoints, &trie->checkpoint_capacity, trie->num_checkpoints, sizeof(World)))
+        return false;
+
+    trie->checkpoints[trie->num_checkpoints] = *world;
+    trie->nodes[node].checkpoint = trie->num_checkpoints++;
+    return true;
+}
+
+// Steps world to the tick of a child delta ticks on and applies its jump
+static uint64_t advance_to_jump(World *world, uint32_t delta)
+{
+    uint32_t start = world->tick;
+    uint32_t target = world->tick + delta;
+    while (!world->game_over && world->tick < target)
+        update_game(world);
+
+    if (!world->game_over)
+        world_jump(world);
+    return world->tick - start;
+}
+
+// Plays out the end of a replay from its last jump; same rules as replay_run
+static uint64_t finish_run(World *world, const TrieEnd *end, bool *ok)
+{
+    uint32_t start = world->tick;
+    while (!world->game_over && world->tick < end->num_ticks)
+        update_game(world);
+
+    *ok = world->game_over && world->tick == end->num_ticks && world->score == end->score;
+    return world->tick - start;
+}
+
+void replay_trie_init(ReplayTrie *trie)
+{
+    memset(trie, 0, sizeof(*trie));
+}
+
+void replay_trie_free(ReplayTrie *trie)
+{
+    free(trie->nodes);
+    free(trie->ends);
+    free(trie->roots);
+    free(trie->checkpoints);
+    memset(trie, 0, sizeof(*trie));
+}
+
+uint32_t replay_trie_insert(ReplayTrie *trie, const Replay *replay)
+{
+    // Roots are plain courses; runs with optional features aren't stored
+    if (replay->features != 0)
+        return TRIE_NONE;
+
+    uint32_t node = TRIE_NONE;
+    for (uint32_t r = 0; r < trie->num_roots; r++)
+    {
+        if (trie->roots[r].seed == replay->seed)
+            node = trie->roots[r].node;
+    }
+    if (node == TRIE_NONE && (node = add_root(trie, replay->seed)) == TRIE_NONE)
+        return TRIE_NONE;
+
+    uint32_t previous = 0;
+    for (uint32_t j = 0; j < replay->num_jumps; j++)
+    {
+        uint32_t delta = replay->jump_ticks[j] - previous;
+        previous = replay->jump_ticks[j];
+
+        uint32_t child = trie->nodes[node].first_child;
+        while (child != TRIE_NONE && trie->nodes[child].delta != delta)
+            child = trie->nodes[child].next_sibling;
+
+        // Snapshots stay valid: a node's world doesn't depend on what
+        // comes after it, and new branch points get theirs on the next run
+        if (child == TRIE_NONE && (child = add_node(trie, node, delta)) == TRIE_NONE)
+            return TRIE_NONE;
+        node = child;
+    }
+
+    uint32_t id = trie->num_ends;
+    if (!add_end(trie, id, node, replay->num_ticks, replay->score))
+        return TRIE_NONE;
+    return id;
+}
+
+bool replay_trie_extract(const ReplayTrie *trie, uint32_t id, Replay *replay)
+{
+    if (id >= trie->num_ends || trie->ends[id].node == TRIE_NONE)
+        return false;
+
+    const TrieEnd *end = &trie->ends[id];
+    const TrieRoot *root = find_root(trie, end->node);
+
+    // Collect the gaps leaf to root, then turn them into ticks root to leaf
+    replay->num_jumps = 0;
+    for (uint32_t node = end->node; trie->nodes[node].parent != TRIE_NONE; node = trie->nodes[node].parent)
+        replay_add_jump(replay, trie->nodes[node].delta);
+
+    uint32_t n = replay->num_jumps;
+    for (uint32_t i = 0; i < n / 2; i++)
+    {
+        uint32_t swap = replay->jump_ticks[i];
+        replay->jump_ticks[i] = replay->jump_ticks[n - 1 - i];
+        replay->jump_ticks[n - 1 - i] = swap;
+    }
+    for (uint32_t i = 1; i < n; i++)
+        replay->jump_ticks[i] += replay->jump_ticks[i - 1];
+
+    replay->seed = root->seed;
+    replay->features = 0;
+    replay->num_ticks = end->num_ticks;
+    replay->score = end->score;
+    return true;
+}
+
+bool replay_trie_run(ReplayTrie *trie, bool *ok, uint64_t *ticks)
+{
+    *ticks = 0;
+    uint32_t *stack = malloc((trie->num_nodes + 1) * sizeof(uint32_t));
+    if (stack == NULL)
+    {
+        fprintf(stderr, "Out of memory in replay store\n");
+        return false;
+    }
+    World world;
+
+    for (uint32_t r = 0; r < trie->num_roots; r++)
+    {
+        // Depth first; the world is always the state at the node just
+        // visited, so a child either continues from it directly (only
+        // child) or restores its parent's snapshot (branch)
+        uint32_t depth = 0;
+        stack[depth++] = trie->roots[r].node;
+        world_reset(&world, trie->roots[r].seed);
+
+        while (depth > 0)
+        {
+            uint32_t index = stack[--depth];
+            const TrieNode *node = &trie->nodes[index];
+
+            if (node->parent != TRIE_NONE)
+            {
+                const TrieNode *parent = &trie->nodes[node->parent];
+                if (is_branch(trie, parent))
+                    world = trie->checkpoints[parent->checkpoint];
+                *ticks += advance_to_jump(&world, node->delta);
+            }
+
+            // Every branch has its snapshot before its children are
+            // visited, so the restore above never misses
+            if (is_branch(trie, node) && !save_checkpoint(trie, index, &world))
+            {
+                free(stack);
+                return false;
+            }
+
+            for (uint32_t e = node->first_end; e != TRIE_NONE; e = trie->ends[e].next)
+            {
+                World end_world = world;
+                *ticks += finish_run(&end_world, &trie->ends[e], &ok[e]);
+            }
+
+            for (uint32_t child = node->first_child; child != TRIE_NONE; child = trie->nodes[child].next_sibling)
+                stack[depth++] = child;
+        }
+    }
+
+    free(stack);
+    return true;
+}
+
+bool replay_trie_play(const ReplayTrie *trie, uint32_t id, World *world)
+{
+    if (id >= trie->num_ends || trie->ends[id].node == TRIE_NONE)
+        return false;
+
+    // Walk up to the nearest snapshot (or the root), remembering the path
+    uint32_t path_length = 0;
+    uint32_t node = trie->ends[id].node;
+    for (uint32_t n = node; trie->nodes[n].checkpoint == TRIE_NONE && trie->nodes[n].parent != TRIE_NONE;
+         n = trie->nodes[n].parent)
+        path_length++;
+
+    uint32_t *path = malloc((path_length + 1) * sizeof(uint32_t));
+    if (path == NULL)
+    {
+        fprintf(stderr, "Out of memory in replay store\n");
+        return false;
+    }
+    uint32_t i = path_length;
+    for (; trie->nodes[node].checkpoint == TRIE_NONE && trie->nodes[node].parent != TRIE_NONE;
+         node = trie->nodes[node].parent)
+        path[--i] = node;
+
+    if (trie->nodes[node].checkpoint != TRIE_NONE)
+        *world = trie->checkpoints[trie->nodes[node].checkpoint];
+    else
+        world_reset(world, find_root(trie, node)->seed);
+
+    for (i = 0; i < path_length; i++)
+        advance_to_jump(world, trie->nodes[path[i]].delta);
+    free(path);
+
+    bool ok;
+    finish_run(world, &trie->ends[id], &ok);
+    return ok;
+}
+
+bool replay_trie_save(const ReplayTrie *trie, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    uint32_t *stack = malloc((trie->num_nodes + 1) * sizeof(uint32_t));
+    if (stack == NULL)
+    {
+        fprintf(stderr, "Out of memory in replay store\n");
+        fclose(file);
+        return false;
+    }
+    fprintf(file, "%s %d\n", TRIE_MAGIC, TRIE_VERSION);
+
+    for (uint32_t r = 0; r < trie->num_roots; r++)
+    {
+        uint32_t depth = 0;
+        stack[depth++] = trie->roots[r].node;
+        while (depth > 0)
+        {
+            uint32_t index = stack[--depth];
+            const TrieNode *node = &trie->nodes[index];
+
+            uint32_t num_children = 0, num_ends = 0;
+            for (uint32_t c = node->first_child; c != TRIE_NONE; c = trie->nodes[c].next_sibling)
+                stack[depth++] = c, num_children++;
+            for (uint32_t e = node->first_end; e != TRIE_NONE; e = trie->ends[e].next)
+                num_ends++;
+
+            // "r seed ..." starts a course, "n gap ..." is a jump
+            if (node->parent == TRIE_NONE)
+                fprintf(file, "r %llu %u %u\n", (unsigned long long)trie->roots[r].seed, num_children, num_ends);
+            else
+                fprintf(file, "n %u %u %u\n", node->delta, num_children, num_ends);
+
+            for (uint32_t e = node->first_end; e != TRIE_NONE; e = trie->ends[e].next)
+                fprintf(file, "e %u %u %d\n", e, trie->ends[e].num_ticks, trie->ends[e].score);
+        }
+    }
+
+    free(stack);
+    if (fclose(file) != 0)
+    {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+bool replay_trie_load(ReplayTrie *trie, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    replay_trie_init(trie);
+
+    char magic[32];
+    int version;
+    if (fscanf(file, "%31s %d", magic, &version) != 2 || strcmp(magic, TRIE_MAGIC) != 0 || version != TRIE_VERSION)
+    {
+        fprintf(stderr, "%s: not a version %d replay store\n", path, TRIE_VERSION);
+        fclose(file);
+        return false;
+    }
+
+    // Nodes still waiting for children, with how many they have left
+    uint32_t depth = 0, stack_capacity = 0;
+    uint32_t (*stack)[2] = NULL;
+    bool ok = true;
+    char kind[2];
+
+    while (ok && fscanf(file, "%1s", kind) == 1)
+    {
+        uint32_t index, num_children, num_ends;
+        if (kind[0] == 'r' && depth == 0)
+        {
+            unsigned long long seed;
+            ok = fscanf(file, "%llu %u %u", &seed, &num_children, &num_ends) == 3 &&
+                 (index = add_root(trie, seed)) != TRIE_NONE;
+        }
+        else if (kind[0] == 'n' && depth > 0)
+        {
+            uint32_t delta;
+            uint32_t parent = stack[depth - 1][0];
+            ok = fscanf(file, "%u %u %u", &delta, &num_children, &num_ends) == 3 &&
+                 (index = add_node(trie, parent, delta)) != TRIE_NONE;
+            if (ok && --stack[depth - 1][1] == 0)
+                depth--;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        for (uint32_t e = 0; ok && e < num_ends; e++)
+        {
+            uint32_t id, num_ticks;
+            int score;
+            ok = fscanf(file, " e %u %u %d", &id, &num_ticks, &score) == 3 &&
+                 add_end(trie, id, index, num_ticks, score);
+        }
+
+        if (ok && num_children > 0)
+        {
+            ok = reserve((void **)&stack, &stack_capacity, depth, sizeof(*stack));
+            if (ok)
+            {
+                stack[depth][0] = index;
+                stack[depth][1] = num_children;
+                depth++;
+            }
+        }
+    }
+
+    free(stack);
+    fclose(file);
+    if (!ok || depth != 0)
+    {
+        fprintf(stderr, "%s: malformed replay store\n", path);
+        replay_trie_free(trie);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * Replay store
+ * Keeps many replays as one trie per course seed over the gaps between
+ * jumps, so replays sharing a prefix (fuzzer mutants, retries of the same
+ * opening) store and simulate that prefix once. Nodes where paths split
+ * or a replay ends get a world snapshot the first time they are
+ * simulated, so later playback resumes from the nearest one.
+ */
+
+#ifndef REPLAY_TRIE_H
+#define REPLAY_TRIE_H
+
+#include "replay.h"
+
+#define TRIE_NONE UINT32_MAX
+
+typedef struct
+{
+    uint32_t delta;  // ticks since the parent's jump (since tick 0 below a root)
+    uint32_t parent; // TRIE_NONE for a root
+    uint32_t first_child;
+    uint32_t next_sibling;
+    uint32_t first_end;  // replays ending after this jump, chained by TrieEnd.next
+    uint32_t checkpoint; // index into checkpoints, TRIE_NONE until simulated
+} TrieNode;
+
+typedef struct
+{
+    uint32_t node;
+    uint32_t num_ticks;
+    int score;
+    uint32_t next;
+} TrieEnd;
+
+typedef struct
+{
+    uint64_t seed;
+    uint32_t node;
+} TrieRoot;
+
+typedef struct
+{
+    TrieNode *nodes;
+    uint32_t num_nodes, node_capacity;
+    TrieEnd *ends; // indexed by replay id, in insertion order
+    uint32_t num_ends, end_capacity;
+    TrieRoot *roots;
+    uint32_t num_roots, root_capacity;
+    World *checkpoints;
+    uint32_t num_checkpoints, checkpoint_capacity;
+} ReplayTrie;
+
+void replay_trie_init(ReplayTrie *trie);
+void replay_trie_free(ReplayTrie *trie);
+
+// Adds a replay and returns its id (ids count up from 0), or TRIE_NONE for
+// a replay played with optional features
+uint32_t replay_trie_insert(ReplayTrie *trie, const Replay *replay);
+
+// Rebuilds replay id into replay, replacing its contents
+bool replay_trie_extract(const ReplayTrie *trie, uint32_t id, Replay *replay);
+
+// Simulates every replay, each shared prefix once, and sets ok[id] to
+// whether replay id ended as recorded and *ticks to the ticks simulated;
+// false when out of memory for the snapshots, with ok incomplete
+bool replay_trie_run(ReplayTrie *trie, bool *ok, uint64_t *ticks);
+
+// Plays replay id into world from the nearest snapshot on its path;
+// returns true if it ended as recorded
+bool replay_trie_play(const ReplayTrie *trie, uint32_t id, World *world);
+
+// Text format: one line per node in preorder, so shared prefixes are
+// written once
+bool replay_trie_save(const ReplayTrie *trie, const char *path);
+bool replay_trie_load(ReplayTrie *trie, const char *path);
+
+#endif
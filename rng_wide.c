@@ -0,0 +1,216 @@
+/**
+ * Wide pipe-gap generator
+ * Scalar, SSE2 (4 lanes) and AVX2 (8 lanes) versions of lane-wise
+ * rng_range(). The SIMD paths are compiled with target attributes and
+ * picked through cpu_dispatch.
+ */
+
+#include "rng_wide.h"
+#include "cpu_dispatch.h"
+#include "game.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RNG_WIDE_X86 1
+#endif
+
+static void rng_range_scalar(uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        if (!mask[i])
+            continue;
+
+        Rng rng = {{state[0][i], state[1][i], state[2][i], state[3][i]}};
+        out[i] = rng_range(&rng, n);
+        for (int k = 0; k < 4; k++)
+        {
+            state[k][i] = rng.s[k];
+        }
+    }
+}
+
+static void rng_range_all_scalar(uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count)
+{
+    rng_range_scalar(state, mask, n, out, 0, count);
+}
+
+#ifdef RNG_WIDE_X86
+
+__attribute__((target("sse2"))) static inline __m128i rotl_x4(__m128i x, int k)
+{
+    return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+}
+
+// SSE2 has no blendv; masks are all ones or all zeros per lane
+__attribute__((target("sse2"))) static inline __m128i select_x4(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+__attribute__((target("sse2"))) static void rng_range_sse2(uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count)
+{
+    const __m128i range = _mm_set1_epi32((int)n);
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    const __m128i threshold = _mm_xor_si128(_mm_set1_epi32((int)(-n % n)), sign);
+    const __m128i even_lanes = _mm_set_epi32(0, -1, 0, -1);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int i = 0; i + 4 <= count; i += 4)
+    {
+        uint32_t mask_bytes;
+        memcpy(&mask_bytes, &mask[i], sizeof(mask_bytes));
+        __m128i pending = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)mask_bytes), zero);
+        pending = _mm_unpacklo_epi16(pending, zero);
+        pending = _mm_cmpgt_epi32(pending, zero);
+        if (_mm_movemask_epi8(pending) == 0)
+            continue;
+
+        __m128i s0 = _mm_loadu_si128((const __m128i *)&state[0][i]);
+        __m128i s1 = _mm_loadu_si128((const __m128i *)&state[1][i]);
+        __m128i s2 = _mm_loadu_si128((const __m128i *)&state[2][i]);
+        __m128i s3 = _mm_loadu_si128((const __m128i *)&state[3][i]);
+        __m128i result = _mm_loadu_si128((const __m128i *)&out[i]);
+
+        while (_mm_movemask_epi8(pending) != 0)
+        {
+            __m128i x = _mm_add_epi32(s1, _mm_slli_epi32(s1, 2));
+            x = rotl_x4(x, 7);
+            x = _mm_add_epi32(x, _mm_slli_epi32(x, 3));
+
+            __m128i t = _mm_slli_epi32(s1, 9);
+            __m128i n2 = _mm_xor_si128(s2, s0);
+            __m128i n3 = _mm_xor_si128(s3, s1);
+            __m128i n1 = _mm_xor_si128(s1, n2);
+            __m128i n0 = _mm_xor_si128(s0, n3);
+            n2 = _mm_xor_si128(n2, t);
+            n3 = rotl_x4(n3, 11);
+
+            s0 = select_x4(pending, n0, s0);
+            s1 = select_x4(pending, n1, s1);
+            s2 = select_x4(pending, n2, s2);
+            s3 = select_x4(pending, n3, s3);
+
+            __m128i even = _mm_mul_epu32(x, range);
+            __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), range);
+            __m128i high = select_x4(even_lanes, _mm_srli_epi64(even, 32), odd);
+            __m128i low = select_x4(even_lanes, even, _mm_slli_epi64(odd, 32));
+
+            // Unsigned low < threshold via the sign-flip trick
+            __m128i reject = _mm_cmpgt_epi32(threshold, _mm_xor_si128(low, sign));
+            __m128i accept = _mm_andnot_si128(reject, pending);
+            result = select_x4(accept, high, result);
+            pending = _mm_andnot_si128(accept, pending);
+        }
+
+        _mm_storeu_si128((__m128i *)&state[0][i], s0);
+        _mm_storeu_si128((__m128i *)&state[1][i], s1);
+        _mm_storeu_si128((__m128i *)&state[2][i], s2);
+        _mm_storeu_si128((__m128i *)&state[3][i], s3);
+        _mm_storeu_si128((__m128i *)&out[i], result);
+    }
+
+    int tail = count - count % 4;
+    rng_range_scalar(state, mask, n, out, tail, count);
+}
+
+__attribute__((target("avx2"))) static inline __m256i rotl_x8(__m256i x, int k)
+{
+    return _mm256_or_si256(_mm256_slli_epi32(x, k), _mm256_srli_epi32(x, 32 - k));
+}
+
+__attribute__((target("avx2"))) static void rng_range_avx2(uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count)
+{
+    const __m256i range = _mm256_set1_epi32((int)n);
+    const __m256i threshold = _mm256_set1_epi32((int)(-n % n));
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int i = 0; i + RNG_WIDE_LANES <= count; i += RNG_WIDE_LANES)
+    {
+        // Widen the byte mask to one all-ones dword per requesting lane
+        __m256i pending = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)&mask[i]));
+        pending = _mm256_cmpgt_epi32(pending, zero);
+        if (_mm256_testz_si256(pending, pending))
+            continue;
+
+        __m256i s0 = _mm256_loadu_si256((const __m256i *)&state[0][i]);
+        __m256i s1 = _mm256_loadu_si256((const __m256i *)&state[1][i]);
+        __m256i s2 = _mm256_loadu_si256((const __m256i *)&state[2][i]);
+        __m256i s3 = _mm256_loadu_si256((const __m256i *)&state[3][i]);
+        __m256i result = _mm256_loadu_si256((const __m256i *)&out[i]);
+
+        // Rejections are about one in ten million draws, so this rarely loops
+        while (!_mm256_testz_si256(pending, pending))
+        {
+            // xoshiro128**: rotl(s1 * 5, 7) * 9, then advance the state
+            __m256i x = _mm256_add_epi32(s1, _mm256_slli_epi32(s1, 2));
+            x = rotl_x8(x, 7);
+            x = _mm256_add_epi32(x, _mm256_slli_epi32(x, 3));
+
+            __m256i t = _mm256_slli_epi32(s1, 9);
+            __m256i n2 = _mm256_xor_si256(s2, s0);
+            __m256i n3 = _mm256_xor_si256(s3, s1);
+            __m256i n1 = _mm256_xor_si256(s1, n2);
+            __m256i n0 = _mm256_xor_si256(s0, n3);
+            n2 = _mm256_xor_si256(n2, t);
+            n3 = rotl_x8(n3, 11);
+
+            // Only lanes still drawing advance their generator
+            s0 = _mm256_blendv_epi8(s0, n0, pending);
+            s1 = _mm256_blendv_epi8(s1, n1, pending);
+            s2 = _mm256_blendv_epi8(s2, n2, pending);
+            s3 = _mm256_blendv_epi8(s3, n3, pending);
+
+            // 32x32->64 products of the even and odd lanes give Lemire's m
+            __m256i even = _mm256_mul_epu32(x, range);
+            __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), range);
+            __m256i high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+            __m256i low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+
+            __m256i accept = _mm256_cmpeq_epi32(_mm256_max_epu32(low, threshold), low);
+            accept = _mm256_and_si256(accept, pending);
+            result = _mm256_blendv_epi8(result, high, accept);
+            pending = _mm256_andnot_si256(accept, pending);
+        }
+
+        _mm256_storeu_si256((__m256i *)&state[0][i], s0);
+        _mm256_storeu_si256((__m256i *)&state[1][i], s1);
+        _mm256_storeu_si256((__m256i *)&state[2][i], s2);
+        _mm256_storeu_si256((__m256i *)&state[3][i], s3);
+        _mm256_storeu_si256((__m256i *)&out[i], result);
+    }
+
+    int tail = count - count % RNG_WIDE_LANES;
+    rng_range_scalar(state, mask, n, out, tail, count);
+}
+
+#endif
+
+typedef void (*RngWideKernel)(uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count);
+
+// Indexed by SimdLevel; AVX-512 gains nothing over AVX2 at these batch sizes
+#ifdef RNG_WIDE_X86
+static const RngWideKernel kernels[SIMD_LEVEL_COUNT] = {rng_range_all_scalar, rng_range_sse2, rng_range_avx2, rng_range_avx2};
+static const SimdLevel kernel_levels[SIMD_LEVEL_COUNT] = {SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX2};
+#else
+static const RngWideKernel kernels[SIMD_LEVEL_COUNT] = {rng_range_all_scalar, rng_range_all_scalar, rng_range_all_scalar, rng_range_all_scalar};
+static const SimdLevel kernel_levels[SIMD_LEVEL_COUNT] = {SIMD_SCALAR, SIMD_SCALAR, SIMD_SCALAR, SIMD_SCALAR};
+#endif
+
+void rng_range_wide(uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count)
+{
+    kernels[simd_level()](state, mask, n, out, count);
+}
+
+void rng_range_wide_with(SimdLevel level, uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count)
+{
+    kernels[level](state, mask, n, out, count);
+}
+
+const char *rng_wide_kernel_name(SimdLevel level)
+{
+    return simd_level_name(kernel_levels[level]);
+}
@@ -0,0 +1,28 @@
+/**
+ * Wide pipe-gap generator
+ * Runs many xoshiro128** generators side by side, with state stored lane by
+ * lane (one array per state word), so a whole batch can draw its pipe gaps
+ * at once. Every lane produces exactly what rng_range() would have produced
+ * from the same state, so batched worlds stay reproducible per world.
+ */
+
+#ifndef RNG_WIDE_H
+#define RNG_WIDE_H
+
+#include <stdint.h>
+
+#include "cpu_dispatch.h"
+
+#define RNG_WIDE_LANES 8
+
+// For each of count lanes with mask[i] set, draws out[i] = rng_range(n) from
+// the generator (state[0][i], ..., state[3][i]); other lanes are untouched
+void rng_range_wide(uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count);
+
+// Same, with the variant for a given (supported) level instead of simd_level()
+void rng_range_wide_with(SimdLevel level, uint32_t *const state[4], const uint8_t *mask, uint32_t n, uint32_t *out, int count);
+
+// Which implementation a level maps to
+const char *rng_wide_kernel_name(SimdLevel level);
+
+#endif
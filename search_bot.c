@@ -0,0 +1,98 @@
+/**
+ * Search bot
+ * Plain depth-first minimax without an opponent: the value of a state is
+ * the best value over its two actions.
+ */
+
+#include <stdlib.h>
+
+#include "search_bot.h"
+
+#define ALIVE_TICK_VALUE 1000 // per tick survived; outweighs any distance
+
+void search_bot_init(SearchBot *bot, TransTable *table, int depth)
+{
+    bot->table = table;
+    bot->stats = (TransStats){0};
+    bot->depth = depth;
+    bot->nodes = 0;
+}
+
+// Distance from the bird's centre to the centre of the next gap ahead
+static int gap_distance(const World *world)
+{
+    int target = SCREEN_HEIGHT / 2;
+    int best_x = SCREEN_WIDTH * 4;
+    const Pipes *pipes = &world->pipes;
+    for (int i = 0; i < pipes->count; i++)
+    {
+        if (pipes->x[i] + PIPE_WIDTH >= BIRD_X && pipes->x[i] < best_x)
+        {
+            best_x = pipes->x[i];
+            target = pipes->gap_y[i];
+        }
+    }
+    return abs(world->birds.row[0] + BIRD_HEIGHT / 2 - target);
+}
+
+// Steps one ply, jumping on its first tick if asked; returns ticks survived
+static int step_ply(World *world, bool jump)
+{
+    if (jump)
+        world_jump(world);
+
+    int ticks = 0;
+    for (; ticks < SEARCH_STEP_TICKS && !world->game_over; ticks++)
+        update_game(world);
+    return ticks - world->game_over;
+}
+
+static int32_t search(SearchBot *bot, const World *world, int depth, bool *best_move)
+{
+    if (depth == 0 || world->game_over)
+        return -gap_distance(world);
+
+    uint64_t key = 0;
+    TransData cached;
+    if (bot->table != NULL)
+    {
+        key = trans_key(world);
+        if (trans_probe(bot->table, key, &cached, &bot->stats) && cached.depth >= depth)
+        {
+            *best_move = cached.move;
+            return cached.value;
+        }
+    }
+
+    int32_t best = INT32_MIN;
+    for (int move = 0; move < 2; move++)
+    {
+        World next = *world;
+        bool child_move;
+        int32_t value = step_ply(&next, move) * ALIVE_TICK_VALUE;
+        bot->nodes++;
+        value += search(bot, &next, next.game_over ? 0 : depth - 1, &child_move);
+
+        if (value > best)
+        {
+            best = value;
+            *best_move = move;
+        }
+    }
+
+    if (bot->table != NULL)
+        trans_store(bot->table, key, (TransData){best, (uint8_t)depth, *best_move}, &bot->stats);
+    return best;
+}
+
+bool search_bot_wants_jump(SearchBot *bot, const World *world)
+{
+    // Only decide on ply boundaries so every search lines up with the
+    // states earlier searches stored
+    if (world->tick % SEARCH_STEP_TICKS != 0)
+        return false;
+
+    bool jump = false;
+    search(bot, world, bot->depth, &jump);
+    return jump;
+}
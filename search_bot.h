@@ -0,0 +1,28 @@
+/**
+ * Search bot
+ * Plays by looking ahead: a depth-limited search over jump / no jump, one
+ * choice every SEARCH_STEP_TICKS ticks, scoring each line by how long the
+ * bird survives and how close it ends to the next gap. Lines reaching a
+ * state already in the transposition table reuse its value instead of
+ * being searched again; bots on other threads can share the table.
+ */
+
+#ifndef SEARCH_BOT_H
+#define SEARCH_BOT_H
+
+#include "transposition.h"
+
+#define SEARCH_STEP_TICKS 4
+
+typedef struct
+{
+    TransTable *table; // may be NULL to search without one
+    TransStats stats;
+    int depth;         // plies of SEARCH_STEP_TICKS ticks
+    uint64_t nodes;    // plies simulated
+} SearchBot;
+
+void search_bot_init(SearchBot *bot, TransTable *table, int depth);
+bool search_bot_wants_jump(SearchBot *bot, const World *world);
+
+#endif
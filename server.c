@@ -0,0 +1,387 @@
+/**
+ * Local multiplayer server
+ */
+
+#define _GNU_SOURCE // sendmmsg
+
+#include "server.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_MESSAGE 16 // largest client message
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// A non-blocking UDP socket, bound to 127.0.0.1:port if port is given
+static int open_socket(uint16_t port, bool bind_port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return -1;
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    if (bind_port)
+    {
+        struct sockaddr_in address = {0};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+static bool same_address(const struct sockaddr_in *a, const struct sockaddr_in *b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+bool server_open(Server *server, uint16_t port, uint64_t seed)
+{
+    memset(server, 0, sizeof(*server));
+    server->socket = open_socket(port, true);
+    if (server->socket < 0)
+        return false;
+    server->seed = seed;
+    course_init(&server->course, seed);
+    return true;
+}
+
+void server_close(Server *server)
+{
+    close(server->socket);
+    course_free(&server->course);
+    server->socket = -1;
+}
+
+uint16_t server_port(const Server *server)
+{
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getsockname(server->socket, (struct sockaddr *)&address, &length) < 0)
+        return 0;
+    return ntohs(address.sin_port);
+}
+
+static void welcome(Server *server, const struct sockaddr_in *address, int player)
+{
+    uint8_t message[10] = {NET_WELCOME, (uint8_t)player};
+    memcpy(message + 2, &server->seed, sizeof(server->seed));
+    sendto(server->socket, message, sizeof(message), 0, (const struct sockaddr *)address, sizeof(*address));
+}
+
+static void handle_join(Server *server, const struct sockaddr_in *address)
+{
+    // A repeated join (the welcome got lost) gets the same seat
+    int free_seat = -1;
+    for (int p = 0; p < MAX_PLAYERS; p++)
+    {
+        if (server->connected[p] && same_address(&server->addresses[p], address))
+        {
+            welcome(server, address, p);
+            return;
+        }
+        if (!server->connected[p] && free_seat < 0)
+            free_seat = p;
+    }
+    if (free_seat < 0)
+    {
+        welcome(server, address, NET_FULL);
+        return;
+    }
+
+    // Seated, watching until the next round
+    server->connected[free_seat] = true;
+    server->addresses[free_seat] = *address;
+    server->playing[free_seat] = false;
+    server->jump[free_seat] = false;
+    course_world_reset(&server->birds[free_seat]);
+    server->num_connected++;
+    welcome(server, address, free_seat);
+}
+
+// Drains every waiting message; returns how many there were
+static uint32_t receive_inputs(Server *server)
+{
+    uint32_t count = 0;
+    uint8_t message[MAX_MESSAGE];
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    ssize_t size;
+    while ((size = recvfrom(server->socket, message, sizeof(message), 0, (struct sockaddr *)&address, &length)) > 0)
+    {
+        count++;
+        length = sizeof(address);
+
+        if (message[0] == NET_JOIN)
+        {
+            handle_join(server, &address);
+            continue;
+        }
+
+        // Everything else names a seat, which must be the sender's
+        if (size < 2 || message[1] >= MAX_PLAYERS || !server->connected[message[1]] ||
+            !same_address(&server->addresses[message[1]], &address))
+            continue;
+        int player = message[1];
+        if (message[0] == NET_JUMP && size >= 4)
+        {
+            uint16_t round;
+            memcpy(&round, message + 2, sizeof(round));
+            if (round == server->round && server->playing[player])
+                server->jump[player] = true;
+        }
+        else if (message[0] == NET_LEAVE)
+        {
+            server->connected[player] = false;
+            server->playing[player] = false;
+            server->num_connected--;
+        }
+    }
+    return count;
+}
+
+static void start_round(Server *server)
+{
+    server->round++;
+    server->tick = 0;
+    course_free(&server->course);
+    course_init(&server->course, server->seed + server->round);
+    for (int p = 0; p < MAX_PLAYERS; p++)
+    {
+        server->playing[p] = server->connected[p];
+        server->jump[p] = false;
+        course_world_reset(&server->birds[p]);
+    }
+}
+
+static void simulate(Server *server)
+{
+    bool any_playing = false;
+    for (int p = 0; p < MAX_PLAYERS; p++)
+        any_playing |= server->playing[p];
+    if (!any_playing)
+    {
+        if (server->num_connected == 0)
+            return;
+        start_round(server);
+    }
+
+    server->tick++;
+    for (int p = 0; p < MAX_PLAYERS; p++)
+    {
+        if (!server->playing[p])
+            continue;
+        CourseWorld *bird = &server->birds[p];
+        if (server->jump[p])
+        {
+            course_world_jump(bird);
+            server->jump[p] = false;
+        }
+        course_world_step(bird, &server->course);
+        if (bird->game_over)
+            server->playing[p] = false;
+    }
+}
+
+static SnapshotBird snapshot_bird(const Server *server, int player, bool near)
+{
+    const CourseWorld *bird = &server->birds[player];
+    SnapshotBird out = {(uint8_t)player, near, bird->y, bird->velocity, bird->score};
+    return out;
+}
+
+// Marks with stamp the live birds (order, sorted by rows) nearest to a
+// viewer at viewer_row: walking out both ways from where it sits in the
+// order finds them nearest first, so at most MAX_NEAR_BIRDS are looked at
+static void mark_near(const int *order, const int *rows, int num_live, int viewer, int viewer_row, uint32_t *near,
+                      uint32_t stamp)
+{
+    int above = 0;
+    while (above < num_live && rows[above] < viewer_row)
+        above++;
+    int below = above - 1;
+    for (int n = 0; n < MAX_NEAR_BIRDS;)
+    {
+        if (above < num_live && order[above] == viewer)
+            above++;
+        if (below >= 0 && order[below] == viewer)
+            below--;
+        int up = below >= 0 ? viewer_row - rows[below] : INT_MAX;
+        int down = above < num_live ? rows[above] - viewer_row : INT_MAX;
+        if ((up < down ? up : down) > INTEREST_RADIUS)
+            break;
+        near[order[up <= down ? below-- : above++]] = stamp;
+        n++;
+    }
+}
+
+static void send_snapshots(Server *server, ServerTickStats *stats)
+{
+    // Everyone sees the same birds, so sort the live ones by row once
+    int order[MAX_PLAYERS], rows[MAX_PLAYERS], num_live = 0;
+    for (int p = 0; p < MAX_PLAYERS; p++)
+    {
+        if (!server->playing[p])
+            continue;
+        int row = (int)server->birds[p].y, i = num_live++;
+        for (; i > 0 && rows[i - 1] > row; i--)
+        {
+            order[i] = order[i - 1];
+            rows[i] = rows[i - 1];
+        }
+        order[i] = p;
+        rows[i] = row;
+    }
+
+    // Encode every snapshot, then hand them all to the kernel in one call
+    struct mmsghdr messages[MAX_PLAYERS];
+    struct iovec vectors[MAX_PLAYERS];
+    uint32_t near[MAX_PLAYERS] = {0};
+    int num_messages = 0;
+    Snapshot snap;
+    snap.round = server->round;
+    snap.tick = server->tick;
+    for (int viewer = 0; viewer < MAX_PLAYERS; viewer++)
+    {
+        if (!server->connected[viewer])
+            continue;
+
+        uint32_t stamp = (uint32_t)viewer + 1;
+        mark_near(order, rows, num_live, viewer, (int)server->birds[viewer].y, near, stamp);
+        snap.alive = server->playing[viewer];
+        snap.self = snapshot_bird(server, viewer, true);
+        snap.num_birds = 0;
+        for (int i = 0; i < num_live; i++)
+        {
+            if (order[i] != viewer)
+                snap.birds[snap.num_birds++] = snapshot_bird(server, order[i], near[order[i]] == stamp);
+        }
+
+        uint8_t *packet = server->packets[num_messages];
+        packet[0] = NET_SNAPSHOT;
+        size_t size = 1 + snapshot_encode(&snap, packet + 1);
+        vectors[num_messages] = (struct iovec){packet, size};
+        messages[num_messages] = (struct mmsghdr){0};
+        messages[num_messages].msg_hdr.msg_name = &server->addresses[viewer];
+        messages[num_messages].msg_hdr.msg_namelen = sizeof(server->addresses[viewer]);
+        messages[num_messages].msg_hdr.msg_iov = &vectors[num_messages];
+        messages[num_messages].msg_hdr.msg_iovlen = 1;
+        num_messages++;
+
+        if (stats != NULL)
+        {
+            for (int i = 0; i < snap.num_birds; i++)
+            {
+                stats->near += snap.birds[i].near;
+                stats->far += !snap.birds[i].near;
+            }
+            stats->bytes += size;
+        }
+    }
+
+    // A full socket buffer drops the rest, as the network might have
+    int sent = 0;
+    while (sent < num_messages)
+    {
+        int count = sendmmsg(server->socket, messages + sent, num_messages - sent, 0);
+        if (count <= 0)
+            break;
+        sent += count;
+    }
+    if (stats != NULL)
+        stats->snapshots += (uint32_t)sent;
+}
+
+void server_tick(Server *server, ServerTickStats *stats)
+{
+    double start = now_ns();
+    uint32_t inputs = receive_inputs(server);
+    double received = now_ns();
+    simulate(server);
+    double simulated = now_ns();
+    send_snapshots(server, stats);
+    if (stats != NULL)
+    {
+        stats->inputs += inputs;
+        stats->receive_ns += received - start;
+        stats->simulate_ns += simulated - received;
+        stats->send_ns += now_ns() - simulated;
+    }
+}
+
+bool net_client_open(NetClient *client, uint16_t port)
+{
+    client->socket = open_socket(0, false);
+    if (client->socket < 0)
+        return false;
+    memset(&client->server, 0, sizeof(client->server));
+    client->server.sin_family = AF_INET;
+    client->server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    client->server.sin_port = htons(port);
+    client->player = -1;
+    client->seed = 0;
+
+    uint8_t message[1] = {NET_JOIN};
+    return sendto(client->socket, message, sizeof(message), 0, (const struct sockaddr *)&client->server,
+                  sizeof(client->server)) == sizeof(message);
+}
+
+void net_client_close(NetClient *client)
+{
+    if (client->player >= 0 && client->player != NET_FULL)
+    {
+        uint8_t message[2] = {NET_LEAVE, (uint8_t)client->player};
+        sendto(client->socket, message, sizeof(message), 0, (const struct sockaddr *)&client->server,
+               sizeof(client->server));
+    }
+    close(client->socket);
+    client->socket = -1;
+}
+
+void net_client_jump(NetClient *client, uint16_t round)
+{
+    if (client->player < 0 || client->player == NET_FULL)
+        return;
+    uint8_t message[4] = {NET_JUMP, (uint8_t)client->player};
+    memcpy(message + 2, &round, sizeof(round));
+    sendto(client->socket, message, sizeof(message), 0, (const struct sockaddr *)&client->server,
+           sizeof(client->server));
+}
+
+bool net_client_receive(NetClient *client, Snapshot *snap)
+{
+    uint8_t packet[1 + SNAPSHOT_MAX_BYTES];
+    ssize_t size;
+    while ((size = recv(client->socket, packet, sizeof(packet), 0)) > 0)
+    {
+        if (packet[0] == NET_WELCOME && size >= 10)
+        {
+            client->player = packet[1];
+            memcpy(&client->seed, packet + 2, sizeof(client->seed));
+        }
+        else if (packet[0] == NET_SNAPSHOT && snapshot_decode(snap, packet + 1, (size_t)size - 1))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,96 @@
+/**
+ * Local multiplayer server
+ * One authoritative course for up to MAX_PLAYERS birds, each flown by a
+ * client over UDP. Every bird is a CourseWorld on the round's shared
+ * Course, so a tick for all of them is a few float operations each. The
+ * server runs rounds: a round starts for everyone connected once every
+ * bird of the last one is down, and clients joining mid-round watch until
+ * then.
+ *
+ * Each tick the server drains the clients' inputs, steps every bird and
+ * sends each client its own snapshot. Clients send a jump tagged with the
+ * round they saw, so a late one can't leak into the next round; it is
+ * applied on the server's next tick.
+ *
+ * Messages start with a type byte:
+ *   join      client -> server
+ *   welcome   server -> client: player index (NET_FULL if no room), seed
+ *   jump      client -> server: player, round
+ *   leave     client -> server: player
+ *   snapshot  server -> client: snapshot_encode
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <netinet/in.h>
+
+#include "course.h"
+#include "snapshot.h"
+
+#define NET_FULL 0xFF // welcome's player index when the server has no room
+
+typedef enum
+{
+    NET_JOIN,
+    NET_WELCOME,
+    NET_JUMP,
+    NET_LEAVE,
+    NET_SNAPSHOT,
+} NetMessage;
+
+typedef struct
+{
+    int socket;
+    uint64_t seed; // round r plays course seed + r
+    uint16_t round; // 0 until the first round starts
+    uint32_t tick;  // ticks into the round
+    Course course;
+    CourseWorld birds[MAX_PLAYERS];
+    struct sockaddr_in addresses[MAX_PLAYERS];
+    bool connected[MAX_PLAYERS];
+    bool playing[MAX_PLAYERS]; // in the round and still flying
+    bool jump[MAX_PLAYERS];    // jump asked for since the last tick
+    int num_connected;
+    uint8_t packets[MAX_PLAYERS][1 + SNAPSHOT_MAX_BYTES]; // this tick's snapshots
+} Server;
+
+typedef struct
+{
+    double receive_ns, simulate_ns, send_ns;
+    uint32_t inputs;    // messages drained
+    uint32_t snapshots; // sent
+    uint64_t bytes;     // snapshot bytes sent
+    uint32_t near, far; // birds sent in full and as a row
+} ServerTickStats;
+
+// Binds 127.0.0.1:port (0 for any free port)
+bool server_open(Server *server, uint16_t port, uint64_t seed);
+void server_close(Server *server);
+uint16_t server_port(const Server *server);
+
+// One fixed tick: drain inputs, step every bird, send every snapshot.
+// Adds what it did to stats, which may be NULL
+void server_tick(Server *server, ServerTickStats *stats);
+
+// A client of a server on localhost
+typedef struct
+{
+    int socket;
+    struct sockaddr_in server;
+    int player; // -1 until welcomed, NET_FULL if turned away
+    uint64_t seed;
+} NetClient;
+
+// Opens a socket and asks to join; the welcome arrives with the snapshots
+bool net_client_open(NetClient *client, uint16_t port);
+void net_client_close(NetClient *client);
+
+// Asks for a jump in round, that of the last snapshot seen
+void net_client_jump(NetClient *client, uint16_t round);
+
+// Handles waiting messages without blocking up to the next snapshot;
+// returns true with snap filled, or false once none are left
+bool net_client_receive(NetClient *client, Snapshot *snap);
+
+#endif
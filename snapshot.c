@@ -0,0 +1,157 @@
+/**
+ * Multiplayer snapshots
+ */
+
+#include "snapshot.h"
+
+#include <string.h>
+
+#define PLAYER_BITS 7 // fits MAX_PLAYERS
+#define ROW_BITS 10   // fits SCREEN_HEIGHT
+#define SCORE_BITS 16
+
+// Bits are written least significant first, into bytes in order
+typedef struct
+{
+    uint8_t *data;
+    size_t bits;
+} BitWriter;
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t bits, size_bits;
+} BitReader;
+
+static void put_bits(BitWriter *writer, uint32_t value, int count)
+{
+    for (int i = 0; i < count;)
+    {
+        size_t byte = writer->bits >> 3;
+        int shift = writer->bits & 7;
+        int take = 8 - shift < count - i ? 8 - shift : count - i;
+        if (shift == 0)
+            writer->data[byte] = 0;
+        writer->data[byte] |= (uint8_t)(((value >> i) & ((1u << take) - 1)) << shift);
+        writer->bits += take;
+        i += take;
+    }
+}
+
+static uint32_t get_bits(BitReader *reader, int count)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < count;)
+    {
+        size_t byte = reader->bits >> 3;
+        int shift = reader->bits & 7;
+        int take = 8 - shift < count - i ? 8 - shift : count - i;
+        value |= (uint32_t)((reader->data[byte] >> shift) & ((1u << take) - 1)) << i;
+        reader->bits += take;
+        i += take;
+    }
+    return value;
+}
+
+static void put_float(BitWriter *writer, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_bits(writer, bits, 32);
+}
+
+static float get_float(BitReader *reader)
+{
+    uint32_t bits = get_bits(reader, 32);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Exact state: both floats and the score
+static void put_near(BitWriter *writer, const SnapshotBird *bird)
+{
+    put_float(writer, bird->y);
+    put_float(writer, bird->velocity);
+    put_bits(writer, (uint32_t)bird->score, SCORE_BITS);
+}
+
+static void get_near(BitReader *reader, SnapshotBird *bird)
+{
+    bird->y = get_float(reader);
+    bird->velocity = get_float(reader);
+    bird->score = (int)get_bits(reader, SCORE_BITS);
+}
+
+size_t snapshot_encode(const Snapshot *snap, uint8_t *out)
+{
+    BitWriter writer = {out, 0};
+    put_bits(&writer, snap->round, 16);
+    put_bits(&writer, snap->tick, 32);
+    put_bits(&writer, snap->self.player, PLAYER_BITS);
+    put_bits(&writer, snap->alive, 1);
+    put_near(&writer, &snap->self);
+
+    put_bits(&writer, (uint32_t)snap->num_birds, PLAYER_BITS);
+    for (int i = 0; i < snap->num_birds; i++)
+    {
+        const SnapshotBird *bird = &snap->birds[i];
+        put_bits(&writer, bird->player, PLAYER_BITS);
+        put_bits(&writer, bird->near, 1);
+        if (bird->near)
+        {
+            put_near(&writer, bird);
+        }
+        else
+        {
+            int row = (int)bird->y;
+            put_bits(&writer, (uint32_t)(row < 0 ? 0 : row), ROW_BITS);
+        }
+    }
+    return (writer.bits + 7) >> 3;
+}
+
+bool snapshot_decode(Snapshot *snap, const uint8_t *data, size_t size)
+{
+    // Sizes are checked per section, so get_bits never runs off the end
+    BitReader reader = {data, 0, size * 8};
+    size_t header_bits = 16 + 32 + PLAYER_BITS + 1 + 64 + SCORE_BITS + PLAYER_BITS;
+    if (reader.size_bits < header_bits)
+        return false;
+
+    snap->round = (uint16_t)get_bits(&reader, 16);
+    snap->tick = get_bits(&reader, 32);
+    snap->self.player = (uint8_t)get_bits(&reader, PLAYER_BITS);
+    snap->alive = get_bits(&reader, 1);
+    snap->self.near = true;
+    get_near(&reader, &snap->self);
+
+    snap->num_birds = (int)get_bits(&reader, PLAYER_BITS);
+    if (snap->num_birds > MAX_PLAYERS)
+        return false;
+    int num_near = 0;
+    for (int i = 0; i < snap->num_birds; i++)
+    {
+        SnapshotBird *bird = &snap->birds[i];
+        if (reader.bits + PLAYER_BITS + 1 > reader.size_bits)
+            return false;
+        bird->player = (uint8_t)get_bits(&reader, PLAYER_BITS);
+        bird->near = get_bits(&reader, 1);
+        num_near += bird->near;
+        if (num_near > MAX_NEAR_BIRDS)
+            return false;
+        if (reader.bits + (bird->near ? 64 + SCORE_BITS : ROW_BITS) > reader.size_bits)
+            return false;
+        if (bird->near)
+        {
+            get_near(&reader, bird);
+        }
+        else
+        {
+            bird->y = (float)get_bits(&reader, ROW_BITS);
+            bird->velocity = 0;
+            bird->score = 0;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * Multiplayer snapshots
+ * What the server tells one client each tick: the client's own bird, and
+ * every other live bird on the course, packed to the bit. Interest
+ * management keeps packets small: the few birds nearest the client's own
+ * (the ones it could overlap on screen) go out with exact floats and
+ * score, so the client can predict them, while the rest only get the row
+ * they are drawn at.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+
+#include "game.h"
+
+#define MAX_PLAYERS 100
+#define INTEREST_RADIUS 120 // pixels between rows for a bird to count as near
+#define MAX_NEAR_BIRDS 16   // only the nearest this many are sent in full
+
+// Header and own bird, then 11 bytes per near bird and 18 bits per other
+#define SNAPSHOT_MAX_BYTES (18 + 11 * MAX_NEAR_BIRDS + (18 * MAX_PLAYERS + 7) / 8)
+
+typedef struct
+{
+    uint8_t player; // index on the server
+    bool near;      // exact state; otherwise y is the row and the rest zero
+    float y, velocity;
+    int score;
+} SnapshotBird;
+
+typedef struct
+{
+    uint16_t round; // the course is seed + round
+    uint32_t tick;
+    bool alive; // the client's own bird, false while waiting for a round
+    SnapshotBird self;
+    int num_birds;
+    SnapshotBird birds[MAX_PLAYERS]; // other live birds
+} Snapshot;
+
+// Packs snap, with at most MAX_NEAR_BIRDS near birds, into out (at least
+// SNAPSHOT_MAX_BYTES); returns the bytes used
+size_t snapshot_encode(const Snapshot *snap, uint8_t *out);
+
+// Unpacks a snapshot; false if data is cut short or malformed
+bool snapshot_decode(Snapshot *snap, const uint8_t *data, size_t size);
+
+#endif
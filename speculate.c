@@ -0,0 +1,50 @@
+/**
+ * Speculative next tick
+ */
+
+#include "speculate.h"
+
+bool speculation_init(Speculation *spec, int width, int height)
+{
+    spec->ready = false;
+    if (!framebuffer_init(&spec->frames[0], width, height))
+        return false;
+    if (!framebuffer_init(&spec->frames[1], width, height))
+    {
+        framebuffer_free(&spec->frames[0]);
+        return false;
+    }
+    return true;
+}
+
+void speculation_free(Speculation *spec)
+{
+    framebuffer_free(&spec->frames[0]);
+    framebuffer_free(&spec->frames[1]);
+    spec->ready = false;
+}
+
+void speculation_prepare(Speculation *spec, const World *world, UpdateFn update)
+{
+    DrawList list;
+
+    for (int jump = 0; jump < 2; jump++)
+    {
+        World *next = &spec->worlds[jump];
+        *next = *world;
+        if (jump)
+            world_jump(next);
+        update(next);
+
+        render_world(&list, next);
+        raster_draw_list(&spec->frames[jump], &list);
+    }
+    spec->ready = true;
+}
+
+const Framebuffer *speculation_commit(Speculation *spec, bool jump, World *world)
+{
+    *world = spec->worlds[jump];
+    spec->ready = false;
+    return &spec->frames[jump];
+}
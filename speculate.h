@@ -0,0 +1,31 @@
+/**
+ * Speculative next tick
+ * The only input is jump or no jump, so the next tick has exactly two
+ * possible outcomes. Simulating and rendering both while waiting for the
+ * tick (or for input) means that when it comes, showing the right frame
+ * is a copy and an upload, with no simulation or rasterization in between.
+ */
+
+#ifndef SPECULATE_H
+#define SPECULATE_H
+
+#include "raster.h"
+
+typedef struct
+{
+    World worlds[2];       // the next tick without and with a jump
+    Framebuffer frames[2]; // those worlds, rendered
+    bool ready;
+} Speculation;
+
+bool speculation_init(Speculation *spec, int width, int height);
+void speculation_free(Speculation *spec);
+
+// Simulates and renders both outcomes of world's next tick
+void speculation_prepare(Speculation *spec, const World *world, UpdateFn update);
+
+// Replaces world with the prepared outcome for jump and returns its frame;
+// the speculation is used up until prepared again
+const Framebuffer *speculation_commit(Speculation *spec, bool jump, World *world);
+
+#endif
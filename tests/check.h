@@ -0,0 +1,25 @@
+/**
+ * Test checks
+ * CHECK(cond, format, ...) reports a failed condition on stderr and counts
+ * it in failures; tests print the count and exit nonzero when it isn't 0.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                           \
+    do                                             \
+    {                                              \
+        if (!(cond))                               \
+        {                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__); \
+            fprintf(stderr, "\n");                 \
+            failures++;                            \
+        }                                          \
+    } while (0)
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * Test: audio mixer
+ * Checks the command ring keeps order and refuses to overfill, and that a
+ * producer and consumer thread hammering it lose or reorder nothing. Then
+ * plays sounds and music through the mixer at every SIMD level this CPU
+ * has, with buffer sizes that leave kernel tails, checking every level
+ * matches the scalar kernel, output stays within [-1, 1], voices end when
+ * their sound does, and a stop silences them.
+ *
+ * Usage: test_audio
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include "audio.h"
+#include "check.h"
+
+#define HAMMER_COMMANDS 200000 // exact as float gains
+#define MAX_FRAMES 1024
+
+static void *produce(void *arg)
+{
+    AudioQueue *queue = arg;
+    for (int i = 0; i < HAMMER_COMMANDS; i++)
+    {
+        AudioCommand command = {AUDIO_PLAY, (uint8_t)i, (float)i};
+        while (!audio_queue_push(queue, command))
+            sched_yield(); // full: let the consumer run
+    }
+    return NULL;
+}
+
+static void check_queue(void)
+{
+    static AudioQueue queue;
+    audio_queue_init(&queue);
+    AudioCommand command;
+    int pushed = 0;
+    while (audio_queue_push(&queue, (AudioCommand){AUDIO_PLAY, 0, (float)pushed}))
+        pushed++;
+    CHECK(pushed == AUDIO_QUEUE_SIZE, "ring took %d commands", pushed);
+    for (int i = 0; i < pushed; i++)
+        CHECK(audio_queue_pop(&queue, &command) && command.gain == i, "command %d out of order", i);
+    CHECK(!audio_queue_pop(&queue, &command), "empty ring gave a command");
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce, &queue);
+    int next = 0, out_of_order = 0;
+    while (next < HAMMER_COMMANDS)
+    {
+        if (!audio_queue_pop(&queue, &command))
+        {
+            sched_yield();
+            continue;
+        }
+        out_of_order += command.gain != next || command.sound != (uint8_t)next;
+        next++;
+    }
+    pthread_join(producer, NULL);
+    CHECK(out_of_order == 0, "%d commands lost or reordered between threads", out_of_order);
+}
+
+// Renders the same command sequence at level and at scalar; returns the
+// largest difference, or -1 if output left [-1, 1] or a voice misbehaved
+static double compare_level(SimdLevel level)
+{
+    static Mixer mixers[2];
+    static float out[2][MAX_FRAMES];
+    SimdLevel levels[2] = {SIMD_SCALAR, level};
+    for (int m = 0; m < 2; m++)
+    {
+        if (!mixer_init(&mixers[m], 7))
+            return -1;
+    }
+
+    double worst = 0;
+    bool ok = true;
+    Rng rng;
+    rng_seed(&rng, 11);
+    for (int buffer = 0; buffer < 400 && ok; buffer++)
+    {
+        int frames = 1 + (int)rng_range(&rng, MAX_FRAMES);
+        AudioCommand command = {AUDIO_PLAY, (uint8_t)rng_range(&rng, SOUND_COUNT), 0.5f + rng_range(&rng, 4)};
+        if (buffer == 10)
+            command = (AudioCommand){AUDIO_MUSIC, 0, 0.8f};
+        else if (buffer == 300)
+            command = (AudioCommand){AUDIO_STOP, 0, 0};
+        for (int m = 0; m < 2; m++)
+        {
+            if (buffer % 3 == 0 || buffer == 10 || buffer == 300)
+                audio_queue_push(&mixers[m].queue, command);
+            mixer_render_with(&mixers[m], out[m], frames, levels[m]);
+        }
+        for (int i = 0; i < frames; i++)
+        {
+            ok &= out[1][i] >= -1 && out[1][i] <= 1;
+            double difference = fabs(out[0][i] - out[1][i]);
+            worst = difference > worst ? difference : worst;
+        }
+        if (buffer == 300)
+        {
+            for (int v = 0; v < AUDIO_MAX_VOICES; v++)
+                ok &= mixers[1].voices[v].samples == NULL;
+        }
+    }
+
+    // With the music off, every voice runs out and leaves silence
+    for (int m = 0; m < 2; m++)
+        mixer_set_music(&mixers[m], 0);
+    for (int buffer = 0; buffer < 50; buffer++)
+        mixer_render_with(&mixers[1], out[1], MAX_FRAMES, level);
+    for (int i = 0; i < MAX_FRAMES; i++)
+        ok &= out[1][i] == 0;
+
+    for (int m = 0; m < 2; m++)
+        mixer_free(&mixers[m]);
+    return ok ? worst : -1;
+}
+
+int main(void)
+{
+    check_queue();
+
+    // A lone jump comes out, and only for as long as it lasts
+    static Mixer mixer;
+    static float out[AUDIO_RATE];
+    CHECK(mixer_init(&mixer, 1), "mixer did not initialise");
+    mixer_play(&mixer, SOUND_JUMP, 1);
+    mixer_render(&mixer, out, AUDIO_RATE);
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < AUDIO_RATE; i++)
+        last = out[i] != 0 ? i : last;
+    CHECK(last > 0 && last < mixer.sound_lengths[SOUND_JUMP], "jump sounded until frame %u", last);
+    mixer_free(&mixer);
+
+    for (int level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (!simd_level_supported((SimdLevel)level))
+            continue;
+        double worst = compare_level((SimdLevel)level);
+        CHECK(worst >= 0 && worst < 1e-6, "%s mixing off the scalar kernel (%g)", simd_level_name((SimdLevel)level),
+              worst);
+    }
+
+    printf("test_audio: %d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * Test: differential check of every fast simulation path
+ * Drives many worlds with autopilot input (random tap rates, random aim)
+ * and steps the reference update_game alongside each optimized path in
+ * lockstep, comparing state after every tick:
+ *   branchless   update_game_branchless, whole World must match
+ *   batch        Batch in the compiled BATCH_LAYOUT, whole World must match
+ *   course       CourseWorld on a shared Course, whole World must match
+ *   fixed/<lvl>  every supported fixed-point kernel against the scalar one,
+ *                bit for bit, and the scalar one against the reference on
+ *                the integer pipe state (the bird itself is a different,
+ *                coarser model, so only its drift is reported)
+ * The reference's incremental world hash is also checked against
+ * world_hash_full every tick.
+ * The first divergence of each path is reported with the world, its seed,
+ * the tick and the field; the exit status is non-zero if any path diverged.
+ *
+ * Build once per layout to cover them all (`make test` does):
+ * gcc -O2 -DBATCH_LAYOUT=BATCH_LAYOUT_SOA -o test_diff tests/test_diff.c batch.c autopilot.c
+ *     course.c fixed_batch.c rng_wide.c cpu_dispatch.c game.c replay.c -I. -lm
+ *
+ * Usage: test_diff [num_worlds] [ticks] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "autopilot.h"
+#include "batch.h"
+#include "course.h"
+#include "fixed_batch.h"
+
+typedef struct
+{
+    const char *name;
+    bool diverged;
+} Path;
+
+static int failures = 0;
+
+// Name of the first field where a and b differ, or NULL if they match
+static const char *world_diff(const World *a, const World *b)
+{
+    if (a->birds.count != b->birds.count)
+        return "bird count";
+    for (int i = 0; i < a->birds.count; i++)
+    {
+        if (a->birds.y[i] != b->birds.y[i])
+            return "bird position";
+        if (a->birds.velocity[i] != b->birds.velocity[i])
+            return "bird velocity";
+        if (a->birds.row[i] != b->birds.row[i])
+            return "bird row";
+    }
+    if (a->game_over != b->game_over)
+        return "game_over";
+    if (a->score != b->score)
+        return "score";
+    if (a->tick != b->tick || a->last_pipe_tick != b->last_pipe_tick)
+        return "tick";
+    if (memcmp(&a->rng, &b->rng, sizeof(Rng)) != 0)
+        return "rng";
+    if (a->pipes.count != b->pipes.count)
+        return "pipe count";
+    for (int i = 0; i < a->pipes.count; i++)
+    {
+        if (a->pipes.x[i] != b->pipes.x[i] || a->pipes.gap_y[i] != b->pipes.gap_y[i] ||
+            a->pipes.passed[i] != b->pipes.passed[i])
+            return "pipe";
+    }
+    if (a->hash != b->hash)
+        return "hash";
+    return NULL;
+}
+
+static void diverge(Path *path, int world, uint64_t seed, uint32_t tick, const char *field)
+{
+    if (path->diverged)
+        return;
+    path->diverged = true;
+    failures++;
+    fprintf(stderr, "FAIL %s: world %d (seed %llu) diverges at tick %u in %s\n", path->name, world,
+            (unsigned long long)seed, tick, field);
+}
+
+// First array in the fixed batch where lane i of a and b differ, or NULL
+static const char *fixed_diff(const FixedBatch *a, const FixedBatch *b, int i)
+{
+    if (a->y[i] != b->y[i] || a->velocity[i] != b->velocity[i])
+        return "bird";
+    if (a->alive[i] != b->alive[i])
+        return "alive";
+    if (a->score[i] != b->score[i])
+        return "score";
+    if (a->tick[i] != b->tick[i] || a->last_pipe_tick[i] != b->last_pipe_tick[i])
+        return "tick";
+    for (int k = 0; k < 4; k++)
+    {
+        if (a->rng[k][i] != b->rng[k][i])
+            return "rng";
+    }
+    for (int p = 0; p < MAX_PIPES; p++)
+    {
+        if (a->pipe_x[p][i] != b->pipe_x[p][i] || a->pipe_gap_y[p][i] != b->pipe_gap_y[p][i] ||
+            a->pipe_passed[p][i] != b->pipe_passed[p][i])
+            return "pipe";
+    }
+    return NULL;
+}
+
+// The reference's pipes must match the newest ones in the fixed model's ring
+static const char *fixed_pipes_diff(const World *world, const FixedBatch *fixed, int i)
+{
+    const Pipes *pipes = &world->pipes;
+    for (int n = 0; n < pipes->count; n++)
+    {
+        int p = (fixed->next_pipe[i] - pipes->count + n + MAX_PIPES) % MAX_PIPES;
+        if (pipes->x[n] != fixed->pipe_x[p][i] || pipes->gap_y[n] != fixed->pipe_gap_y[p][i])
+            return "pipe";
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_worlds = argc > 1 ? atoi(argv[1]) : 256;
+    int ticks = argc > 2 ? atoi(argv[2]) : 5000;
+    uint64_t next_seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    if (num_worlds <= 0 || ticks <= 0)
+    {
+        fprintf(stderr, "Usage: %s [num_worlds] [ticks] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    World *reference = malloc(num_worlds * sizeof(World));
+    World *branchless = malloc(num_worlds * sizeof(World));
+    Autopilot *pilots = malloc(num_worlds * sizeof(Autopilot));
+    uint64_t *seeds = malloc(num_worlds * sizeof(uint64_t));
+    CourseWorld *course_worlds = malloc(num_worlds * sizeof(CourseWorld));
+    Course *courses = malloc(num_worlds * sizeof(Course));
+
+    Batch batch;
+    FixedBatch fixed[SIMD_LEVEL_COUNT];
+    SimdLevel levels[SIMD_LEVEL_COUNT];
+    int num_levels = 0;
+    for (SimdLevel level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (simd_level_supported(level))
+            levels[num_levels++] = level;
+    }
+
+    if (!batch_init(&batch, num_worlds))
+        return 1;
+    for (int l = 0; l < num_levels; l++)
+    {
+        if (!fixed_batch_init(&fixed[l], num_worlds))
+            return 1;
+    }
+
+    Path hash_path = {"reference hash", false};
+    Path branchless_path = {"branchless", false};
+    Path batch_path = {batch_layout_name(), false};
+    Path course_path = {"course", false};
+    Path fixed_path = {"fixed/reference", false};
+    Path level_paths[SIMD_LEVEL_COUNT];
+    char level_names[SIMD_LEVEL_COUNT][32];
+    for (int l = 0; l < num_levels; l++)
+    {
+        snprintf(level_names[l], sizeof(level_names[l]), "fixed/%s", simd_level_name(levels[l]));
+        level_paths[l] = (Path){level_names[l], false};
+    }
+
+    for (int i = 0; i < num_worlds; i++)
+    {
+        seeds[i] = next_seed++;
+        world_reset(&reference[i], seeds[i]);
+        world_reset(&branchless[i], seeds[i]);
+        batch_reset_world(&batch, i, seeds[i]);
+        course_init(&courses[i], seeds[i]);
+        course_world_reset(&course_worlds[i]);
+        for (int l = 0; l < num_levels; l++)
+            fixed_batch_reset_world(&fixed[l], i, seeds[i]);
+        autopilot_init(&pilots[i], seeds[i]);
+    }
+
+    uint64_t world_ticks = 0;
+    uint64_t runs = 0;
+    long fixed_death_drift = 0;
+    for (int t = 0; t < ticks; t++)
+    {
+        for (int i = 0; i < num_worlds; i++)
+        {
+            bool jump = autopilot_wants_jump(&pilots[i], &reference[i]);
+            if (jump)
+            {
+                world_jump(&reference[i]);
+                world_jump(&branchless[i]);
+                course_world_jump(&course_worlds[i]);
+            }
+            batch.jump[i] = jump;
+            for (int l = 0; l < num_levels; l++)
+                fixed[l].jump[i] = jump;
+
+            update_game(&reference[i]);
+            update_game_branchless(&branchless[i]);
+            course_world_step(&course_worlds[i], &courses[i]);
+        }
+        batch_step(&batch);
+        for (int l = 0; l < num_levels; l++)
+            fixed_batch_step_with(&fixed[l], levels[l]);
+        world_ticks += num_worlds;
+
+        for (int i = 0; i < num_worlds; i++)
+        {
+            const World *expected = &reference[i];
+            const char *field;
+
+            if (expected->hash != world_hash_full(expected))
+                diverge(&hash_path, i, seeds[i], expected->tick, "incremental hash");
+
+            if ((field = world_diff(expected, &branchless[i])) != NULL)
+                diverge(&branchless_path, i, seeds[i], expected->tick, field);
+
+            World from_batch;
+            batch_get_world(&batch, i, &from_batch);
+            if ((field = world_diff(expected, &from_batch)) != NULL)
+                diverge(&batch_path, i, seeds[i], expected->tick, field);
+
+            World from_course;
+            course_world_get_world(&course_worlds[i], &courses[i], &from_course);
+            if ((field = world_diff(expected, &from_course)) != NULL)
+                diverge(&course_path, i, seeds[i], expected->tick, field);
+
+            for (int l = 1; l < num_levels; l++)
+            {
+                if ((field = fixed_diff(&fixed[0], &fixed[l], i)) != NULL)
+                    diverge(&level_paths[l], i, seeds[i], expected->tick, field);
+            }
+            if (fixed[0].alive[i] && (field = fixed_pipes_diff(expected, &fixed[0], i)) != NULL)
+                diverge(&fixed_path, i, seeds[i], expected->tick, field);
+
+            if (!expected->game_over)
+                continue;
+
+            // Start every path on a fresh course once the reference run ends
+            fixed_death_drift += labs((long)fixed[0].tick[i] - (long)expected->tick);
+            runs++;
+            seeds[i] = next_seed++;
+            world_reset(&reference[i], seeds[i]);
+            world_reset(&branchless[i], seeds[i]);
+            batch_reset_world(&batch, i, seeds[i]);
+            course_free(&courses[i]);
+            course_init(&courses[i], seeds[i]);
+            course_world_reset(&course_worlds[i]);
+            for (int l = 0; l < num_levels; l++)
+                fixed_batch_reset_world(&fixed[l], i, seeds[i]);
+            autopilot_init(&pilots[i], seeds[i]);
+        }
+    }
+
+    printf("test_diff: %llu world ticks, %llu runs, batch layout %s, fixed levels", (unsigned long long)world_ticks,
+           (unsigned long long)runs, batch_layout_name());
+    for (int l = 0; l < num_levels; l++)
+        printf(" %s", simd_level_name(levels[l]));
+    printf("\n  fixed-point death tick off the reference by %.2f ticks on average\n",
+           runs ? (double)fixed_death_drift / runs : 0.0);
+    printf("test_diff: %d diverging paths\n", failures);
+
+    for (int l = 0; l < num_levels; l++)
+        fixed_batch_free(&fixed[l]);
+    batch_free(&batch);
+    for (int i = 0; i < num_worlds; i++)
+        course_free(&courses[i]);
+    free(courses);
+    free(course_worlds);
+    free(seeds);
+    free(pilots);
+    free(branchless);
+    free(reference);
+    return failures != 0;
+}
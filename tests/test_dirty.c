@@ -0,0 +1,179 @@
+/**
+ * Test: dirty regions
+ * Plays random runs and keeps a stand-in texture up to date by copying
+ * only the dirty rects of each frame into it, for ARGB frames and for
+ * indexed frames expanded rect by rect. The texture must equal the frame
+ * every time, every pixel that changed must lie in a rect, and rects must
+ * stay on screen. Also checks random scribbles on an odd-sized frame,
+ * that an unchanged frame has no rects and that invalidating makes the
+ * whole frame dirty, and reports how much of a game frame goes up.
+ *
+ * Usage: test_dirty
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "dirty.h"
+#include "raster.h"
+
+#define RUNS 8
+
+static bool in_rects(const DirtyTracker *tracker, int x, int y)
+{
+    for (int i = 0; i < tracker->num_rects; i++)
+    {
+        const Rect *r = &tracker->rects[i];
+        if (x >= r->x && x < r->x + r->w && y >= r->y && y < r->y + r->h)
+            return true;
+    }
+    return false;
+}
+
+// Checks the rects against the last frame and the new one, and copies
+// them into texture; returns the pixels copied
+static long upload(const DirtyTracker *tracker, const Framebuffer *last, const Framebuffer *frame,
+                   Framebuffer *texture, const char *what)
+{
+    long copied = 0;
+    for (int i = 0; i < tracker->num_rects; i++)
+    {
+        Rect r = tracker->rects[i];
+        CHECK(r.x >= 0 && r.y >= 0 && r.w > 0 && r.h > 0 && r.x + r.w <= frame->width &&
+                  r.y + r.h <= frame->height,
+              "%s: rect %d,%d %dx%d off screen", what, r.x, r.y, r.w, r.h);
+        for (int y = r.y; y < r.y + r.h; y++)
+        {
+            memcpy(texture->pixels + (size_t)y * texture->pitch + r.x, frame->pixels + (size_t)y * frame->pitch + r.x,
+                   r.w * sizeof(uint32_t));
+        }
+        copied += (long)r.w * r.h;
+    }
+
+    int missed = 0, stale = 0;
+    for (int y = 0; y < frame->height; y++)
+    {
+        for (int x = 0; x < frame->width; x++)
+        {
+            size_t i = (size_t)y * frame->pitch + x;
+            missed += last->pixels[i] != frame->pixels[i] && !in_rects(tracker, x, y);
+            stale += texture->pixels[i] != frame->pixels[i];
+        }
+    }
+    CHECK(missed == 0 && stale == 0, "%s: %d changed pixels outside the rects, %d stale", what, missed, stale);
+    return copied;
+}
+
+static bool init_frames(Framebuffer *frames, int count, int width, int height)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!framebuffer_init(&frames[i], width, height))
+            return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    static DrawList list;
+    Framebuffer argb[2], texture[2]; // last and current frame; ARGB and indexed textures
+    IndexedFramebuffer indexed;
+    DirtyTracker tracker, indexed_tracker;
+    if (!init_frames(argb, 2, SCREEN_WIDTH, SCREEN_HEIGHT) || !init_frames(texture, 2, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !indexed_framebuffer_init(&indexed, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !dirty_init(&tracker, SCREEN_WIDTH, SCREEN_HEIGHT, sizeof(uint32_t)) ||
+        !dirty_init(&indexed_tracker, SCREEN_WIDTH, SCREEN_HEIGHT, 1))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    Rng rng;
+    rng_seed(&rng, 9);
+    long frames = 0, copied = 0, rects = 0;
+    int current = 0;
+    for (int run = 0; run < RUNS; run++)
+    {
+        World world;
+        world_reset_features(&world, 40 + run, run & 1 ? WORLD_PICKUPS | WORLD_MOVING_GAPS : 0);
+        for (int tick = 0; !world.game_over; tick++)
+        {
+            if (rng_range(&rng, 18) == 0)
+                world_jump(&world);
+            update_game(&world);
+
+            current ^= 1;
+            Framebuffer *frame = &argb[current], *last = &argb[current ^ 1];
+            render_world(&list, &world);
+            raster_draw_list(frame, &list);
+            raster_draw_list_indexed(&indexed, &list);
+
+            dirty_update(&tracker, frame->pixels, frame->pitch * sizeof(uint32_t));
+            long argb_copied = upload(&tracker, last, frame, &texture[0], "argb");
+
+            // Indexed frames expand only their dirty rects
+            dirty_update(&indexed_tracker, indexed.pixels, indexed.pitch);
+            for (int i = 0; i < indexed_tracker.num_rects; i++)
+                indexed_expand_rect(&indexed, texture[1].pixels, texture[1].pitch, indexed_tracker.rects[i]);
+            CHECK(upload(&indexed_tracker, last, frame, &texture[1], "indexed") == argb_copied,
+                  "indexed and argb frames dirty differently");
+
+            if (tick > 0)
+            {
+                frames++;
+                copied += argb_copied;
+                rects += tracker.num_rects;
+            }
+        }
+    }
+    double share = (double)copied / frames / (SCREEN_WIDTH * SCREEN_HEIGHT);
+    CHECK(share < 0.5, "%.0f%% of each game frame dirty", 100 * share);
+
+    // The same frame again changes nothing; invalidating dirties it all
+    Framebuffer *frame = &argb[current];
+    CHECK(dirty_update(&tracker, frame->pixels, frame->pitch * sizeof(uint32_t)) == 0, "unchanged frame was dirty");
+    dirty_invalidate(&tracker);
+    dirty_update(&tracker, frame->pixels, frame->pitch * sizeof(uint32_t));
+    CHECK(tracker.num_rects == 1 && tracker.rects[0].w == SCREEN_WIDTH && tracker.rects[0].h == SCREEN_HEIGHT,
+          "invalidated frame not all dirty");
+    dirty_free(&tracker);
+
+    // Scattered scribbles on an odd size: partial tiles, and more runs
+    // than there are rects
+    Framebuffer small[2], small_texture;
+    init_frames(small, 2, 403, 161);
+    init_frames(&small_texture, 1, 403, 161);
+    dirty_init(&tracker, 403, 161, sizeof(uint32_t));
+    bool overflowed = false;
+    for (int step = 0; step < 200; step++)
+    {
+        Framebuffer *next = &small[(step + 1) & 1], *last = &small[step & 1];
+        for (int y = 0; y < 161; y++)
+            memcpy(next->pixels + (size_t)y * next->pitch, last->pixels + (size_t)y * last->pitch, 403 * 4);
+        int scribbles = (int)rng_range(&rng, step % 10 == 0 ? 200 : 6);
+        for (int i = 0; i < scribbles; i++)
+            next->pixels[(size_t)rng_range(&rng, 161) * next->pitch + rng_range(&rng, 403)] = rng_next(&rng);
+        dirty_update(&tracker, next->pixels, next->pitch * sizeof(uint32_t));
+        upload(&tracker, last, next, &small_texture, "scribbles");
+        overflowed |= scribbles > MAX_DIRTY_RECTS && tracker.num_rects < MAX_DIRTY_RECTS / 2;
+    }
+    CHECK(overflowed, "scribbles never overflowed the rects");
+
+    dirty_free(&tracker);
+    dirty_free(&indexed_tracker);
+    indexed_framebuffer_free(&indexed);
+    for (int i = 0; i < 2; i++)
+    {
+        framebuffer_free(&argb[i]);
+        framebuffer_free(&texture[i]);
+        framebuffer_free(&small[i]);
+    }
+    framebuffer_free(&small_texture);
+
+    printf("test_dirty: %ld frames, %.1f%% of a frame and %.1f rects uploaded per frame, %d failures\n", frames,
+           100 * share, (double)rects / frames, failures);
+    return failures != 0;
+}
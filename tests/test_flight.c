@@ -0,0 +1,87 @@
+/**
+ * Test: exact flight
+ * Launches the bird from heights across the screen, with a jump's velocity,
+ * from rest and falling, offset so it never passes within the closed form's
+ * rounding of a whole row (where update_game's own rounding decides), steps it with update_game's float operations, and checks
+ * that flight_at lands on every tick's position (through the ceiling too),
+ * that flight_ground_tick names the tick it hits the ground, and that
+ * advancing in several smaller steps ends where one big step does.
+ *
+ * Usage: test_flight
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "check.h"
+#include "flight.h"
+
+#define MAX_POSITION_ERROR 0.01 // pixels
+
+int main(void)
+{
+    static const float launch_velocities[] = {JUMP_FORCE, 0, 5.2f};
+    double worst = 0;
+    int flights = 0, ceilings = 0;
+
+    for (int v = 0; v < 3; v++)
+    {
+        for (int y0 = 0; y0 < SCREEN_HEIGHT - GROUND_HEIGHT - BIRD_HEIGHT; y0 += 3)
+        {
+            float y = y0 + 0.3f, velocity = launch_velocities[v];
+            Flight launch = {y, velocity};
+            bool hit_ceiling = false;
+            uint32_t ground = 0;
+            for (uint32_t tick = 1; ground == 0; tick++)
+            {
+                // Same float operations as update_game
+                velocity += GRAVITY;
+                y += velocity;
+                if ((int)y < 0)
+                {
+                    y = 0;
+                    velocity = 0;
+                    hit_ceiling = true;
+                }
+                if ((int)y + BIRD_HEIGHT > SCREEN_HEIGHT - GROUND_HEIGHT)
+                    ground = tick;
+
+                Flight at = flight_at(launch, tick);
+                double error = fabs(at.y - y);
+                if (error > worst)
+                    worst = error;
+                CHECK(error < MAX_POSITION_ERROR && fabs(at.velocity - velocity) < 1e-4,
+                      "launch %d,%.1f: tick %u at %.4f,%.4f, stepped %.4f,%.4f", y0, launch_velocities[v], tick, at.y,
+                      at.velocity, y, velocity);
+            }
+            ceilings += hit_ceiling;
+            flights++;
+
+            CHECK(flight_ground_tick(launch) == ground, "launch %d,%.1f: ground on tick %u, stepped %u", y0,
+                  launch_velocities[v], flight_ground_tick(launch), ground);
+
+            // A server at 30 Hz and a client at 240 Hz, each moving on from
+            // its last sample, agree with one step at every shared tick (the
+            // ceiling is checked on whole ticks from the launch, so only
+            // flights that miss it can re-anchor between ticks)
+            if (hit_ceiling)
+                continue;
+            Flight server = launch, client = launch;
+            for (int tick = 2; tick <= 60; tick += 2)
+            {
+                server = flight_at(server, 2);
+                for (int k = 0; k < 8; k++)
+                    client = flight_at(client, 0.25);
+                Flight direct = flight_at(launch, tick);
+                CHECK(fabs(server.y - direct.y) < 1e-6 && fabs(client.y - direct.y) < 1e-6,
+                      "launch %d,%.1f: tick %d server %.6f client %.6f direct %.6f", y0, launch_velocities[v], tick,
+                      server.y, client.y, direct.y);
+            }
+        }
+    }
+    CHECK(ceilings > 0, "no flight reached the ceiling");
+
+    printf("test_flight: %d flights, %d through the ceiling, worst error %.5f px, %d failures\n", flights, ceilings,
+           worst, failures);
+    return failures != 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * Test: golden frames
+ * Plays corpus replays to fixed ticks, rasterizes the frame offscreen and
+ * compares a 64-bit hash of it with the one stored in tests/golden/frames.txt.
+ * The hash covers the same RGB bytes a PPM of the frame holds, so any
+ * change to a pixel fails; a failing frame is written out as a PPM next to
+ * the hashes for a look.
+ *
+ * Usage: test_golden [--update] [REPLAY_DIR [GOLDEN_DIR]]
+ *   --update   rewrite the hashes from the current renderer, and write
+ *              every frame as a PPM (not checked in) to review
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raster.h"
+#include "render.h"
+#include "replay.h"
+
+#define HASH_FILE "frames.txt"
+
+typedef struct
+{
+    const char *name;
+    const char *replay;
+    uint32_t tick; // 0 = the replay's last tick
+} GoldenFrame;
+
+static const GoldenFrame frames[] = {
+    {"start", "000.rep", 1},        // bird, ground and a zero score only
+    {"pipes", "012.rep", 400},      // several pipes, one partly off screen
+    {"score_2", "025.rep", 0},      // line-drawn digit and game over box
+    {"score_7", "012.rep", 0},      // block digit
+};
+#define NUM_FRAMES ((int)(sizeof(frames) / sizeof(frames[0])))
+
+static bool write_ppm(const char *path, const Framebuffer *fb)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", fb->width, fb->height);
+    for (int y = 0; y < fb->height; y++)
+    {
+        for (int x = 0; x < fb->width; x++)
+        {
+            uint32_t pixel = fb->pixels[(size_t)y * fb->pitch + x];
+            uint8_t rgb[3] = {pixel >> 16, pixel >> 8, pixel};
+            fwrite(rgb, 1, 3, file);
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+// FNV-1a over the frame's RGB bytes, row by row
+static uint64_t frame_hash(const Framebuffer *fb)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int y = 0; y < fb->height; y++)
+    {
+        for (int x = 0; x < fb->width; x++)
+        {
+            uint32_t pixel = fb->pixels[(size_t)y * fb->pitch + x];
+            uint8_t rgb[3] = {pixel >> 16, pixel >> 8, pixel};
+            for (int c = 0; c < 3; c++)
+                hash = (hash ^ rgb[c]) * 0x100000001B3ULL;
+        }
+    }
+    return hash;
+}
+
+// Reads "name hash" lines into hashes, in the order of frames; a frame
+// missing from the file keeps hash 0
+static bool read_hashes(const char *path, uint64_t *hashes)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    char name[64];
+    unsigned long long hash;
+    while (fscanf(file, "%63s %llx", name, &hash) == 2)
+    {
+        for (int f = 0; f < NUM_FRAMES; f++)
+        {
+            if (strcmp(name, frames[f].name) == 0)
+                hashes[f] = hash;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static bool write_hashes(const char *path, const uint64_t *hashes)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    for (int f = 0; f < NUM_FRAMES; f++)
+        fprintf(file, "%s %016llx\n", frames[f].name, (unsigned long long)hashes[f]);
+    return fclose(file) == 0;
+}
+
+static bool render_frame(const GoldenFrame *frame, const char *replay_dir, Framebuffer *fb)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", replay_dir, frame->replay);
+
+    Replay replay = {0};
+    if (!replay_load(&replay, path))
+    {
+        fprintf(stderr, "Could not load replay %s\n", path);
+        return false;
+    }
+
+    // Playing a copy cut short at the tick leaves the world there
+    Replay cut = replay;
+    if (frame->tick != 0)
+        cut.num_ticks = frame->tick;
+
+    World world;
+    DrawList list;
+    replay_run(&cut, &world, update_game);
+    render_world(&list, &world);
+    raster_draw_list(fb, &list);
+
+    replay_free(&replay);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    bool update = false;
+    const char *replay_dir = "replays";
+    const char *golden_dir = "tests/golden";
+
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "--update") == 0)
+    {
+        update = true;
+        arg++;
+    }
+    if (arg < argc)
+        replay_dir = argv[arg++];
+    if (arg < argc)
+        golden_dir = argv[arg++];
+
+    Framebuffer fb;
+    if (!framebuffer_init(&fb, SCREEN_WIDTH, SCREEN_HEIGHT))
+        return 1;
+
+    char hash_path[4096];
+    snprintf(hash_path, sizeof(hash_path), "%s/%s", golden_dir, HASH_FILE);
+    uint64_t expected[NUM_FRAMES] = {0}, hashes[NUM_FRAMES] = {0};
+    if (!update && !read_hashes(hash_path, expected))
+    {
+        framebuffer_free(&fb);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int f = 0; f < NUM_FRAMES; f++)
+    {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s.ppm", golden_dir, frames[f].name);
+
+        if (!render_frame(&frames[f], replay_dir, &fb))
+        {
+            failures++;
+            continue;
+        }
+        hashes[f] = frame_hash(&fb);
+
+        if (update)
+        {
+            if (write_ppm(path, &fb))
+                printf("Wrote %s\n", path);
+            else
+                failures++;
+            continue;
+        }
+
+        if (hashes[f] == expected[f])
+        {
+            printf("%-8s ok\n", frames[f].name);
+        }
+        else
+        {
+            printf("%-8s FAIL: hash %016llx, expected %016llx; frame written to %s\n", frames[f].name,
+                   (unsigned long long)hashes[f], (unsigned long long)expected[f], path);
+            write_ppm(path, &fb);
+            failures++;
+        }
+    }
+
+    if (update && failures == 0)
+    {
+        if (write_hashes(hash_path, hashes))
+            printf("Wrote %s\n", hash_path);
+        else
+            failures++;
+    }
+
+    framebuffer_free(&fb);
+    return failures != 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * Test: moving gaps
+ * Flies autopilot runs with WORLD_MOVING_GAPS (every other one with pickups
+ * too) through both update kernels and checks, every tick, that the kernels
+ * agree, that the incremental hash matches world_hash_full, that every gap
+ * stays in bounds and sits where course_gap_at puts it, and that a shared
+ * course world steps to the same World. Also checks some gaps actually
+ * moved and that replays keep the feature.
+ *
+ * Usage: test_moving_gaps [runs] [max ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "autopilot.h"
+#include "check.h"
+#include "course.h"
+
+// Every live gap in bounds and where the course puts it
+static bool check_gaps(const World *world, const Course *course, int *moved)
+{
+    const Pipes *pipes = &world->pipes;
+    for (int i = 0; i < pipes->count; i++)
+    {
+        uint32_t k = pipes->spawn_tick[i] / COURSE_PIPE_TICKS - 1;
+        if (pipes->gap_y[i] < MIN_GAP_Y || pipes->gap_y[i] > MAX_GAP_Y || k >= course->count ||
+            pipes->gap_y[i] != course_gap_at(course, k, world->tick))
+            return false;
+        *moved += pipes->gap_y[i] != pipes->gap_base[i];
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 256;
+    uint32_t max_ticks = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 4000;
+
+    int moved = 0;
+    uint64_t ticks = 0;
+    for (int r = 0; r < runs; r++)
+    {
+        uint64_t seed = 1 + r;
+        uint32_t features = WORLD_MOVING_GAPS | (r & 1 ? WORLD_PICKUPS : 0);
+        Autopilot pilot;
+        World reference, branchless, rebuilt;
+        Course course;
+        CourseWorld compact;
+        autopilot_init(&pilot, seed);
+        world_reset_features(&reference, seed, features);
+        world_reset_features(&branchless, seed, features);
+        course_init_features(&course, seed, WORLD_MOVING_GAPS);
+        course_world_reset(&compact);
+
+        // Courses leave out pickups, whose shields change what a pipe does
+        bool shared = !(features & WORLD_PICKUPS);
+        while (!reference.game_over && reference.tick < max_ticks)
+        {
+            if (autopilot_wants_jump(&pilot, &reference))
+            {
+                world_jump(&reference);
+                world_jump(&branchless);
+                course_world_jump(&compact);
+            }
+            update_game(&reference);
+            update_game_branchless(&branchless);
+            course_world_step(&compact, &course);
+            ticks++;
+
+            if (reference.hash != world_hash_full(&reference))
+            {
+                CHECK(false, "seed %llu: incremental hash wrong at tick %u", (unsigned long long)seed, reference.tick);
+                break;
+            }
+            if (branchless.hash != reference.hash || branchless.game_over != reference.game_over)
+            {
+                CHECK(false, "seed %llu: kernels disagree at tick %u", (unsigned long long)seed, reference.tick);
+                break;
+            }
+            if (!check_gaps(&reference, &course, &moved))
+            {
+                CHECK(false, "seed %llu: gap out of place at tick %u", (unsigned long long)seed, reference.tick);
+                break;
+            }
+            if (shared)
+            {
+                course_world_get_world(&compact, &course, &rebuilt);
+                if (rebuilt.hash != reference.hash || rebuilt.game_over != reference.game_over)
+                {
+                    CHECK(false, "seed %llu: course world differs at tick %u", (unsigned long long)seed,
+                          reference.tick);
+                    break;
+                }
+            }
+        }
+        course_free(&course);
+    }
+
+    CHECK(moved > 0, "no gap ever moved");
+
+    // A replay keeps the feature, and plays back the same with it
+    Replay replay = {0}, loaded = {0};
+    World world;
+    Autopilot pilot;
+    autopilot_init(&pilot, 7);
+    world_reset_features(&world, 7, WORLD_MOVING_GAPS);
+    replay.seed = 7;
+    replay.features = WORLD_MOVING_GAPS;
+    while (!world.game_over && world.tick < max_ticks)
+    {
+        if (autopilot_wants_jump(&pilot, &world))
+        {
+            replay_add_jump(&replay, world.tick);
+            world_jump(&world);
+        }
+        update_game(&world);
+    }
+    replay.num_ticks = world.tick;
+    replay.score = world.score;
+
+    char path[] = "/tmp/test_moving_gaps_XXXXXX";
+    CHECK(mkstemp(path) >= 0, "could not create a temporary file");
+    CHECK(replay_save(&replay, path) && replay_load(&loaded, path), "replay did not save and load");
+    CHECK(loaded.features == WORLD_MOVING_GAPS, "replay lost its features");
+    World played;
+    CHECK(replay_run(&loaded, &played, update_game) && played.hash == world.hash, "replay played back differently");
+    remove(path);
+    replay_free(&replay);
+    replay_free(&loaded);
+
+    printf("test_moving_gaps: %d runs, %llu ticks, %d moved gap checks, %d failures\n", runs,
+           (unsigned long long)ticks, moved, failures);
+    return failures != 0;
+}
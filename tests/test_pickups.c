@@ -0,0 +1,143 @@
+/**
+ * Test: pickups and their grid
+ * Flies autopilot runs with WORLD_PICKUPS through both update kernels and
+ * checks, every tick, that the kernels agree, that the incremental hash
+ * matches world_hash_full, and that the grid finds exactly the pickups a
+ * scan of the whole table finds, for birds at heights across the screen.
+ * Also checks the runs actually met coins, shields and a bonus stage, and
+ * that replays keep the feature flags.
+ *
+ * Usage: test_pickups [runs] [max ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "autopilot.h"
+#include "check.h"
+
+static int compare_ints(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+// Every pickup touching bird b, by scanning the whole table
+static int touching_by_scan(const World *world, int b, int *hits)
+{
+    int32_t left = BIRD_X + PIPE_SPEED * (int32_t)world->tick;
+    int top = world->birds.row[b];
+    int n = 0;
+    for (int i = 0; i < world->pickups.count; i++)
+    {
+        if (world->pickups.x[i] < left + BIRD_WIDTH && world->pickups.x[i] + PICKUP_SIZE > left &&
+            world->pickups.y[i] < top + BIRD_HEIGHT && world->pickups.y[i] + PICKUP_SIZE > top)
+            hits[n++] = i;
+    }
+    return n;
+}
+
+// Moves the bird through every height and compares grid and scan
+static bool check_grid(const World *world)
+{
+    World probe = *world;
+    int grid[MAX_PICKUPS], scan[MAX_PICKUPS];
+    for (int row = 0; row < SCREEN_HEIGHT; row += 7)
+    {
+        probe.birds.row[0] = row;
+        int n = world_pickups_touching(&probe, 0, grid);
+        int m = touching_by_scan(&probe, 0, scan);
+        qsort(grid, n, sizeof(int), compare_ints);
+        if (n != m || memcmp(grid, scan, n * sizeof(int)) != 0)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 256;
+    uint32_t max_ticks = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 4000;
+
+    int total_coins = 0, shields = 0, most_pickups = 0;
+    for (int r = 0; r < runs; r++)
+    {
+        uint64_t seed = 1 + r;
+        Autopilot pilot;
+        World reference, branchless;
+        autopilot_init(&pilot, seed);
+        world_reset_features(&reference, seed, WORLD_PICKUPS);
+        world_reset_features(&branchless, seed, WORLD_PICKUPS);
+
+        while (!reference.game_over && reference.tick < max_ticks)
+        {
+            if (autopilot_wants_jump(&pilot, &reference))
+            {
+                world_jump(&reference);
+                world_jump(&branchless);
+            }
+            int shield_before = reference.shield_ticks;
+            update_game(&reference);
+            update_game_branchless(&branchless);
+            shields += reference.shield_ticks > shield_before;
+
+            if (reference.hash != world_hash_full(&reference))
+            {
+                CHECK(false, "seed %llu: incremental hash wrong at tick %u", (unsigned long long)seed, reference.tick);
+                break;
+            }
+            if (branchless.hash != reference.hash || branchless.coins != reference.coins ||
+                branchless.shield_ticks != reference.shield_ticks || branchless.game_over != reference.game_over)
+            {
+                CHECK(false, "seed %llu: kernels disagree at tick %u", (unsigned long long)seed, reference.tick);
+                break;
+            }
+            if ((reference.tick & 3) == 0 && !check_grid(&reference))
+            {
+                CHECK(false, "seed %llu: grid and scan disagree at tick %u", (unsigned long long)seed, reference.tick);
+                break;
+            }
+            if (reference.pickups.count > most_pickups)
+                most_pickups = reference.pickups.count;
+        }
+        total_coins += reference.coins;
+    }
+
+    CHECK(total_coins > 0, "no coins collected");
+    CHECK(shields > 0, "no shields collected");
+    CHECK(most_pickups > MAX_PICKUPS / 2, "no bonus stage reached (at most %d pickups)", most_pickups);
+
+    // A replay keeps its features, and plays back the same with them
+    Autopilot pilot;
+    Replay replay = {0}, loaded = {0};
+    World world;
+    autopilot_init(&pilot, 7);
+    world_reset_features(&world, 7, WORLD_PICKUPS);
+    replay.seed = 7;
+    replay.features = WORLD_PICKUPS;
+    while (!world.game_over && world.tick < max_ticks)
+    {
+        if (autopilot_wants_jump(&pilot, &world))
+        {
+            replay_add_jump(&replay, world.tick);
+            world_jump(&world);
+        }
+        update_game(&world);
+    }
+    replay.num_ticks = world.tick;
+    replay.score = world.score;
+
+    char path[] = "/tmp/test_pickups_XXXXXX";
+    CHECK(mkstemp(path) >= 0, "could not create a temporary file");
+    CHECK(replay_save(&replay, path) && replay_load(&loaded, path), "replay did not save and load");
+    CHECK(loaded.features == WORLD_PICKUPS, "replay lost its features");
+    World played;
+    CHECK(replay_run(&loaded, &played, update_game) && played.hash == world.hash, "replay played back differently");
+    remove(path);
+    replay_free(&replay);
+    replay_free(&loaded);
+
+    printf("test_pickups: %d runs, %d coins, %d shields, up to %d pickups, %d failures\n", runs, total_coins, shields,
+           most_pickups, failures);
+    return failures != 0;
+}
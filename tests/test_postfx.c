@@ -0,0 +1,140 @@
+/**
+ * Test: post-processing
+ * Runs every combination of effects over random frames with random shakes
+ * at every SIMD level this CPU has and checks each matches the scalar
+ * kernel exactly, then that the worker pool gives the same frame as one
+ * thread. Also checks effect names parse, no effects is a copy, shaken
+ * edges are black, alpha passes through and scanlines darken odd rows.
+ *
+ * Usage: test_postfx
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "postfx.h"
+
+// Odd width so every kernel leaves a tail
+#define WIDTH 203
+#define HEIGHT 61
+
+static bool same_frame(const Framebuffer *a, const Framebuffer *b)
+{
+    for (int y = 0; y < a->height; y++)
+    {
+        if (memcmp(a->pixels + (size_t)y * a->pitch, b->pixels + (size_t)y * b->pitch, a->width * sizeof(uint32_t)))
+            return false;
+    }
+    return true;
+}
+
+static void random_frame(Framebuffer *fb, Rng *rng)
+{
+    for (int y = 0; y < fb->height; y++)
+    {
+        for (int x = 0; x < fb->width; x++)
+            fb->pixels[(size_t)y * fb->pitch + x] = rng_next(rng);
+    }
+}
+
+static void check_effects(uint32_t effects, Framebuffer *src, Framebuffer *expected, Framebuffer *out, Rng *rng)
+{
+    PostFx fx;
+    CHECK(postfx_init(&fx, WIDTH, HEIGHT, effects, 1), "postfx_init failed");
+    for (int frame = 0; frame < 8; frame++)
+    {
+        random_frame(src, rng);
+        fx.shake_x = (int)rng_range(rng, 2 * WIDTH + 1) - WIDTH;
+        fx.shake_y = (int)rng_range(rng, 21) - 10;
+        postfx_apply_rows(&fx, src, expected, 0, HEIGHT, SIMD_SCALAR);
+        for (int level = SIMD_SSE2; level < SIMD_LEVEL_COUNT; level++)
+        {
+            if (!simd_level_supported((SimdLevel)level))
+                continue;
+            memset(out->pixels, 0, (size_t)out->pitch * HEIGHT * sizeof(uint32_t));
+            postfx_apply_rows(&fx, src, out, 0, HEIGHT, (SimdLevel)level);
+            CHECK(same_frame(expected, out), "effects %#x, shake %d,%d: %s off the scalar kernel", effects,
+                  fx.shake_x, fx.shake_y, simd_level_name((SimdLevel)level));
+        }
+    }
+    postfx_free(&fx);
+}
+
+int main(void)
+{
+    uint32_t effects;
+    CHECK(postfx_parse("scanlines,vignette", &effects) && effects == (POSTFX_SCANLINES | POSTFX_VIGNETTE),
+          "scanlines,vignette parsed as %#x", effects);
+    CHECK(postfx_parse("all", &effects) && effects == POSTFX_ALL, "all parsed as %#x", effects);
+    CHECK(!postfx_parse("grade,bloom", &effects), "unknown effect accepted");
+
+    Framebuffer src, expected, out;
+    if (!framebuffer_init(&src, WIDTH, HEIGHT) || !framebuffer_init(&expected, WIDTH, HEIGHT) ||
+        !framebuffer_init(&out, WIDTH, HEIGHT))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    Rng rng;
+    rng_seed(&rng, 5);
+
+    for (uint32_t combination = 0; combination <= POSTFX_ALL; combination++)
+        check_effects(combination, &src, &expected, &out, &rng);
+
+    // No effects copies; a shake leaves black where nothing moved in
+    PostFx fx;
+    postfx_init(&fx, WIDTH, HEIGHT, 0, 1);
+    random_frame(&src, &rng);
+    postfx_apply(&fx, &src, &out);
+    CHECK(same_frame(&src, &out), "no effects changed the frame");
+    postfx_free(&fx);
+
+    postfx_init(&fx, WIDTH, HEIGHT, POSTFX_SHAKE, 1);
+    fx.shake_x = 3;
+    fx.shake_y = -2;
+    postfx_apply(&fx, &src, &out);
+    CHECK(out.pixels[2] == 0xFF000000 && out.pixels[(size_t)(HEIGHT - 1) * out.pitch + 10] == 0xFF000000,
+          "shaken edges not black");
+    CHECK(out.pixels[(size_t)10 * out.pitch + 20] == src.pixels[(size_t)12 * src.pitch + 17], "shake moved wrongly");
+    postfx_free(&fx);
+
+    // Scanlines keep even rows and alpha, and darken odd rows
+    postfx_init(&fx, WIDTH, HEIGHT, POSTFX_SCANLINES, 1);
+    for (int x = 0; x < WIDTH; x++)
+    {
+        src.pixels[x] = 0x80C0C0C0;
+        src.pixels[src.pitch + x] = 0x80C0C0C0;
+    }
+    postfx_apply(&fx, &src, &out);
+    CHECK(out.pixels[7] == 0x80C0C0C0, "scanlines changed an even row (%08x)", out.pixels[7]);
+    CHECK(out.pixels[out.pitch + 7] >> 24 == 0x80 && (out.pixels[out.pitch + 7] & 0xFF) < 0xC0,
+          "scanlines left an odd row as %08x", out.pixels[out.pitch + 7]);
+    postfx_free(&fx);
+
+    // Any number of threads gives the single-threaded frame
+    random_frame(&src, &rng);
+    for (int threads = 2; threads <= 7; threads++)
+    {
+        PostFx single, pooled;
+        postfx_init(&single, WIDTH, HEIGHT, POSTFX_ALL, 1);
+        postfx_init(&pooled, WIDTH, HEIGHT, POSTFX_ALL, threads);
+        CHECK(pooled.num_threads == threads, "pool started %d of %d threads", pooled.num_threads, threads);
+        for (int frame = 0; frame < 20; frame++)
+        {
+            single.shake_x = pooled.shake_x = frame % 5 - 2;
+            single.shake_y = pooled.shake_y = frame % 3 - 1;
+            postfx_apply(&single, &src, &expected);
+            postfx_apply(&pooled, &src, &out);
+            CHECK(same_frame(&expected, &out), "%d threads, frame %d differs", threads, frame);
+        }
+        postfx_free(&single);
+        postfx_free(&pooled);
+    }
+
+    framebuffer_free(&src);
+    framebuffer_free(&expected);
+    framebuffer_free(&out);
+    printf("test_postfx: %d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * Test: replay store
+ * Packs the replays given on the command line plus branching variants of
+ * them (a prefix kept, the autopilot finishing the run) into a store and
+ * checks every replay comes back out unchanged, ends as recorded when the
+ * store is simulated in one pass or played one by one, and survives a
+ * save/load round trip.
+ *
+ * Usage: test_replay_trie FILE...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "autopilot.h"
+#include "check.h"
+#include "replay_trie.h"
+
+#define VARIANTS 4
+
+// Keeps the jumps of base before cut and lets the autopilot fly the rest
+static void make_variant(Replay *variant, const Replay *base, uint32_t cut, uint64_t pilot_seed)
+{
+    Autopilot pilot;
+    World world;
+    uint32_t next_jump = 0;
+
+    autopilot_init(&pilot, pilot_seed);
+    world_reset(&world, base->seed);
+    variant->seed = base->seed;
+    variant->num_jumps = 0;
+
+    while (!world.game_over && world.tick < 20000)
+    {
+        bool jump;
+        if (world.tick < cut)
+        {
+            jump = next_jump < base->num_jumps && base->jump_ticks[next_jump] == world.tick;
+            next_jump += jump;
+        }
+        else
+        {
+            jump = autopilot_wants_jump(&pilot, &world);
+        }
+
+        if (jump)
+        {
+            replay_add_jump(variant, world.tick);
+            world_jump(&world);
+        }
+        update_game(&world);
+    }
+
+    variant->num_ticks = world.tick;
+    variant->score = world.score;
+}
+
+static bool same_replay(const Replay *a, const Replay *b)
+{
+    return a->seed == b->seed && a->num_ticks == b->num_ticks && a->score == b->score &&
+           a->num_jumps == b->num_jumps &&
+           memcmp(a->jump_ticks, b->jump_ticks, a->num_jumps * sizeof(uint32_t)) == 0;
+}
+
+static void check_store(ReplayTrie *trie, const Replay *replays, uint32_t count, const char *what)
+{
+    Replay extracted = {0};
+    bool *ok = calloc(count, sizeof(bool));
+
+    uint64_t flat_ticks = 0;
+    for (uint32_t id = 0; id < count; id++)
+        flat_ticks += replays[id].num_ticks;
+
+    uint64_t ticks = 0;
+    CHECK(replay_trie_run(trie, ok, &ticks), "%s: one-pass run ran out of memory", what);
+    CHECK(ticks < flat_ticks, "%s: shared prefixes were simulated more than once", what);
+
+    for (uint32_t id = 0; id < count; id++)
+    {
+        World world;
+        CHECK(ok[id], "%s: replay %u did not end as recorded in the one-pass run", what, id);
+        CHECK(replay_trie_play(trie, id, &world), "%s: replay %u did not end as recorded when played", what, id);
+        CHECK(replay_trie_extract(trie, id, &extracted) && same_replay(&extracted, &replays[id]),
+              "%s: replay %u came back out different", what, id);
+    }
+
+    printf("%s: %u replays, %u nodes, %llu of %llu ticks simulated\n", what, count, trie->num_nodes,
+           (unsigned long long)ticks, (unsigned long long)flat_ticks);
+    replay_free(&extracted);
+    free(ok);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t count = (uint32_t)(argc - 1) * (1 + VARIANTS);
+    Replay *replays = calloc(count, sizeof(Replay));
+    ReplayTrie trie;
+    replay_trie_init(&trie);
+
+    uint32_t n = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        Replay *base = &replays[n];
+        CHECK(replay_load(base, argv[i]), "%s: could not load", argv[i]);
+        CHECK(replay_trie_insert(&trie, base) == n, "%s: unexpected id", argv[i]);
+        n++;
+
+        for (int v = 0; v < VARIANTS; v++)
+        {
+            uint32_t cut = base->num_ticks * (v + 1) / (VARIANTS + 1);
+            make_variant(&replays[n], base, cut, (uint64_t)i * VARIANTS + v);
+            CHECK(replay_trie_insert(&trie, &replays[n]) == n, "%s: unexpected id for variant %d", argv[i], v);
+            n++;
+        }
+    }
+
+    check_store(&trie, replays, count, "built");
+
+    char path[] = "/tmp/test_replay_trie_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0, "could not create a temporary file");
+    if (fd >= 0)
+    {
+        ReplayTrie loaded;
+        bool ok = replay_trie_save(&trie, path) && replay_trie_load(&loaded, path);
+        CHECK(ok, "save/load failed");
+        if (ok)
+        {
+            CHECK(loaded.num_nodes == trie.num_nodes, "round trip changed the node count");
+            check_store(&loaded, replays, count, "loaded");
+            replay_trie_free(&loaded);
+        }
+        remove(path);
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+        replay_free(&replays[i]);
+    free(replays);
+    replay_trie_free(&trie);
+
+    printf("test_replay_trie: %d failures\n", failures);
+    return failures != 0;
+}
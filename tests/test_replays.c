@@ -0,0 +1,68 @@
+/**
+ * Test: every replay given on the command line ends on its recorded tick
+ * with its recorded score under both update kernels, and survives a
+ * save/load round trip unchanged.
+ *
+ * Usage: test_replays FILE...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "replay.h"
+
+static void check_round_trip(const Replay *replay, const char *name)
+{
+    char path[] = "/tmp/test_replays_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0, "%s: could not create a temporary file", name);
+    if (fd < 0)
+        return;
+
+    Replay loaded = {0};
+    bool ok = replay_save(replay, path) && replay_load(&loaded, path);
+    CHECK(ok, "%s: save/load failed", name);
+    if (ok)
+    {
+        CHECK(loaded.seed == replay->seed && loaded.features == replay->features && loaded.num_ticks == replay->num_ticks &&
+                  loaded.score == replay->score && loaded.num_jumps == replay->num_jumps &&
+                  memcmp(loaded.jump_ticks, replay->jump_ticks, replay->num_jumps * sizeof(uint32_t)) == 0,
+              "%s: round trip changed the replay", name);
+    }
+
+    replay_free(&loaded);
+    remove(path);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        Replay replay = {0};
+        World world;
+
+        CHECK(replay_load(&replay, argv[i]), "%s: could not load", argv[i]);
+        if (replay.num_ticks == 0)
+            continue;
+
+        CHECK(replay_run(&replay, &world, update_game), "%s: update_game ended at tick %u score %d, recorded %u / %d",
+              argv[i], world.tick, world.score, replay.num_ticks, replay.score);
+        CHECK(replay_run(&replay, &world, update_game_branchless),
+              "%s: update_game_branchless ended at tick %u score %d, recorded %u / %d", argv[i], world.tick,
+              world.score, replay.num_ticks, replay.score);
+        check_round_trip(&replay, argv[i]);
+
+        replay_free(&replay);
+    }
+
+    printf("test_replays: %d replays, %d failures\n", argc - 1, failures);
+    return failures != 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * Test: multiplayer snapshots and server
+ * Round-trips random snapshots through the bit packing, checking near
+ * birds come back exact, the rest at their row, that packets stay within
+ * SNAPSHOT_MAX_BYTES and that cut-short packets are refused. Then runs a
+ * server on a localhost port with a few clients flying their birds from
+ * their snapshots, and checks every snapshot of a client's own bird
+ * against a CourseWorld stepped locally with the same jumps, that the
+ * birds sent in full are the nearest ones, that rounds restart, and that
+ * a client past MAX_PLAYERS is turned away.
+ *
+ * Usage: test_server
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "server.h"
+
+#define CLIENTS 4
+
+static void check_packing(void)
+{
+    Rng rng;
+    rng_seed(&rng, 1);
+    static Snapshot snap, back;
+    uint8_t packet[SNAPSHOT_MAX_BYTES];
+    for (int run = 0; run < 1000; run++)
+    {
+        snap.round = (uint16_t)rng_range(&rng, 65536);
+        snap.tick = rng_next(&rng);
+        snap.alive = rng_range(&rng, 2);
+        snap.self = (SnapshotBird){0, true, (float)rng_range(&rng, 60000) / 100,
+                                   (float)rng_range(&rng, 2000) / 100 - 8, (int)rng_range(&rng, 65536)};
+        snap.num_birds = (int)rng_range(&rng, MAX_PLAYERS);
+        int near = 0;
+        for (int i = 0; i < snap.num_birds; i++)
+        {
+            bool is_near = near < MAX_NEAR_BIRDS && rng_range(&rng, 4) == 0;
+            near += is_near;
+            snap.birds[i] = (SnapshotBird){(uint8_t)(i + 1), is_near, (float)rng_range(&rng, 60000) / 100,
+                                           is_near ? (float)rng_range(&rng, 2000) / 100 - 8 : 0,
+                                           is_near ? (int)rng_range(&rng, 1000) : 0};
+        }
+
+        size_t size = snapshot_encode(&snap, packet);
+        CHECK(size <= SNAPSHOT_MAX_BYTES, "run %d: %zu bytes", run, size);
+        bool ok = snapshot_decode(&back, packet, size) && back.round == snap.round && back.tick == snap.tick &&
+                  back.alive == snap.alive && back.num_birds == snap.num_birds &&
+                  memcmp(&back.self.y, &snap.self.y, sizeof(float)) == 0 &&
+                  memcmp(&back.self.velocity, &snap.self.velocity, sizeof(float)) == 0 &&
+                  back.self.score == snap.self.score;
+        for (int i = 0; ok && i < snap.num_birds; i++)
+        {
+            const SnapshotBird *a = &snap.birds[i], *b = &back.birds[i];
+            ok = a->player == b->player && a->near == b->near &&
+                 (a->near ? a->y == b->y && a->velocity == b->velocity && a->score == b->score
+                          : b->y == (int)a->y);
+        }
+        CHECK(ok, "run %d: snapshot changed in packing", run);
+        CHECK(size == 0 || !snapshot_decode(&back, packet, size - 1), "run %d: cut-short packet accepted", run);
+    }
+}
+
+typedef struct
+{
+    NetClient client;
+    Course course; // the round's, for aiming and for the local bird
+    uint16_t round;
+    CourseWorld bird; // stepped locally with the jumps asked for
+    bool jump;        // asked for, so taken on the next tick
+    int aim_offset;
+} TestClient;
+
+// The birds sent in full must be the nearest MAX_NEAR_BIRDS within reach
+static bool nearest_in_full(const Snapshot *snap)
+{
+    int self_row = (int)snap->self.y;
+    int farthest_near = -1, nearest_far = INTEREST_RADIUS + 1, num_near = 0;
+    for (int i = 0; i < snap->num_birds; i++)
+    {
+        int distance = abs((int)snap->birds[i].y - self_row);
+        if (snap->birds[i].near)
+        {
+            num_near++;
+            farthest_near = distance > farthest_near ? distance : farthest_near;
+        }
+        else if (distance < nearest_far)
+        {
+            nearest_far = distance;
+        }
+    }
+    return farthest_near <= INTEREST_RADIUS && farthest_near <= nearest_far &&
+           (num_near == MAX_NEAR_BIRDS || nearest_far > INTEREST_RADIUS);
+}
+
+static void check_server(void)
+{
+    static Server server;
+    if (!server_open(&server, 0, 5))
+    {
+        CHECK(false, "could not open a server");
+        return;
+    }
+    uint16_t port = server_port(&server);
+
+    TestClient clients[CLIENTS] = {0};
+    Rng noise;
+    rng_seed(&noise, 3);
+    for (int c = 0; c < CLIENTS; c++)
+    {
+        CHECK(net_client_open(&clients[c].client, port), "client %d could not open", c);
+        clients[c].aim_offset = 30 * c - 45;
+    }
+
+    int snapshots = 0, mismatches = 0, crowded = 0;
+    for (int t = 0; t < 3000; t++)
+    {
+        server_tick(&server, NULL);
+        for (int c = 0; c < CLIENTS; c++)
+        {
+            TestClient *tc = &clients[c];
+            Snapshot snap;
+            if (!net_client_receive(&tc->client, &snap))
+                continue;
+            snapshots++;
+            CHECK(tc->client.player == snap.self.player, "client %d: snapshot of player %d", c, snap.self.player);
+
+            if (snap.round != tc->round)
+            {
+                course_free(&tc->course);
+                course_init(&tc->course, tc->client.seed + snap.round);
+                course_world_reset(&tc->bird);
+                tc->round = snap.round;
+                tc->jump = false;
+            }
+            if (!tc->bird.game_over)
+            {
+                if (tc->jump)
+                    course_world_jump(&tc->bird);
+                tc->jump = false;
+                course_world_step(&tc->bird, &tc->course);
+            }
+            if ((snap.alive && tc->bird.tick != snap.tick) || tc->bird.y != snap.self.y ||
+                tc->bird.velocity != snap.self.velocity || tc->bird.score != snap.self.score ||
+                tc->bird.game_over == snap.alive)
+                mismatches++;
+            crowded += !nearest_in_full(&snap);
+
+            // Aim at the next gap, with the odd random jump so rounds end
+            if (snap.alive)
+            {
+                uint32_t next = (uint32_t)snap.self.score;
+                int target = next < course_pipes_at(snap.tick) ? course_gap_at(&tc->course, next, snap.tick)
+                                                                : SCREEN_HEIGHT / 2;
+                if (((int)snap.self.y + BIRD_HEIGHT / 2 > target + tc->aim_offset && snap.self.velocity > 0) ||
+                    rng_range(&noise, 40) == 0)
+                {
+                    net_client_jump(&tc->client, snap.round);
+                    tc->jump = true;
+                }
+            }
+        }
+    }
+    CHECK(snapshots >= 3000 * CLIENTS - CLIENTS, "only %d snapshots arrived", snapshots);
+    CHECK(mismatches == 0, "%d snapshots differ from the local bird", mismatches);
+    CHECK(crowded == 0, "%d snapshots sent the wrong birds in full", crowded);
+    CHECK(server.round > 1, "rounds never restarted");
+    int rounds = server.round;
+
+    // Fill every other seat, then one more is turned away
+    static NetClient crowd[MAX_PLAYERS];
+    for (int c = 0; c < MAX_PLAYERS - CLIENTS + 1; c++)
+        net_client_open(&crowd[c], port);
+    server_tick(&server, NULL);
+    Snapshot snap;
+    int full = 0;
+    for (int c = 0; c < MAX_PLAYERS - CLIENTS + 1; c++)
+    {
+        while (net_client_receive(&crowd[c], &snap))
+            ;
+        full += crowd[c].player == NET_FULL;
+        net_client_close(&crowd[c]);
+    }
+    CHECK(full == 1, "%d clients turned away, expected 1", full);
+
+    for (int c = 0; c < CLIENTS; c++)
+    {
+        net_client_close(&clients[c].client);
+        course_free(&clients[c].course);
+    }
+    server_tick(&server, NULL);
+    CHECK(server.num_connected == 0, "%d clients still seated after leaving", server.num_connected);
+    server_close(&server);
+
+    printf("test_server: %d snapshots over %d rounds\n", snapshots, rounds);
+}
+
+int main(void)
+{
+    check_packing();
+    check_server();
+    printf("test_server: %d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * Test: transposition table under concurrent use
+ * Several threads hammer a deliberately small table with stores and probes
+ * of random keys whose data is derived from the key, so every hit can be
+ * checked: a torn or mixed-up entry would come back with the wrong data.
+ * Also checks that a search bot using the table still flies a course and
+ * searches fewer plies than one without it, and that worlds differing only
+ * in features, shield or pickups get different keys.
+ *
+ * Usage: test_transposition [threads] [operations per thread]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "autopilot.h"
+#include "search_bot.h"
+
+#define MAX_THREADS 64
+#define TABLE_LOG2_ENTRIES 10 // small, so threads collide on buckets
+
+typedef struct
+{
+    TransTable *table;
+    int thread;
+    long operations;
+    TransStats stats;
+    long bad_hits;
+} HammerJob;
+
+static uint64_t key_for(uint64_t n)
+{
+    uint64_t z = n * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    return (z ^ (z >> 31)) | 1;
+}
+
+static TransData data_for(uint64_t key)
+{
+    return (TransData){(int32_t)(key >> 32), (uint8_t)(key >> 8), (uint8_t)(key >> 16 & 1)};
+}
+
+static void *hammer(void *arg)
+{
+    HammerJob *job = arg;
+    uint64_t state = job->thread + 1;
+
+    for (long i = 0; i < job->operations; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t key = key_for(state >> 52); // 4096 distinct keys shared by all threads
+
+        TransData data;
+        if (state >> 40 & 1)
+        {
+            trans_store(job->table, key, data_for(key), &job->stats);
+        }
+        else if (trans_probe(job->table, key, &data, &job->stats))
+        {
+            TransData expected = data_for(key);
+            job->bad_hits += data.value != expected.value || data.depth != expected.depth || data.move != expected.move;
+        }
+    }
+    return NULL;
+}
+
+static int check_search_bot()
+{
+    TransTable table;
+    if (!trans_init(&table, 16))
+        return 1;
+
+    SearchBot plain, cached;
+    search_bot_init(&plain, NULL, 6);
+    search_bot_init(&cached, &table, 6);
+
+    // The table only merges states within a quantization band, so moves can
+    // legitimately differ now and then; the runs must still both survive
+    World a, b;
+    world_reset(&a, 7);
+    world_reset(&b, 7);
+    while (a.tick < 1500 && !a.game_over && !b.game_over)
+    {
+        if (search_bot_wants_jump(&plain, &a))
+            world_jump(&a);
+        if (search_bot_wants_jump(&cached, &b))
+            world_jump(&b);
+        update_game(&a);
+        update_game(&b);
+    }
+
+    int failures = 0;
+    if (a.game_over || b.game_over)
+    {
+        fprintf(stderr, "FAIL: bots died early (without table at %u, with at %u)\n", a.tick, b.tick);
+        failures++;
+    }
+    if (cached.nodes >= plain.nodes)
+    {
+        fprintf(stderr, "FAIL: table saved no work (%llu vs %llu plies)\n", (unsigned long long)cached.nodes,
+                (unsigned long long)plain.nodes);
+        failures++;
+    }
+    printf("search bot: %llu plies without table, %llu with, hit rate %.1f%%\n", (unsigned long long)plain.nodes,
+           (unsigned long long)cached.nodes, 100.0 * cached.stats.hits / cached.stats.probes);
+
+    trans_free(&table);
+    return failures;
+}
+
+static int check_keys()
+{
+    // A world on the same course as its plain twin, with pickups on screen
+    Autopilot pilot;
+    World plain, world;
+    autopilot_init(&pilot, 1);
+    world_reset(&plain, 1);
+    world_reset_features(&world, 1, WORLD_PICKUPS);
+    while (world.pickups.count < 2 && !world.game_over)
+    {
+        if (autopilot_wants_jump(&pilot, &world))
+        {
+            world_jump(&plain);
+            world_jump(&world);
+        }
+        update_game(&plain);
+        update_game(&world);
+    }
+
+    World shielded = world, richer = world, picked = world, moving = world;
+    shielded.shield_ticks = SHIELD_TICKS;
+    richer.coins++;
+    picked.pickups.kind[0] = PICKUP_NONE;
+    moving.features |= WORLD_MOVING_GAPS;
+
+    uint64_t key = trans_key(&world);
+    int failures = 0;
+    if (world.game_over || trans_key(&plain) == key || trans_key(&shielded) == key ||
+        trans_key(&richer) == key || trans_key(&picked) == key || trans_key(&moving) == key)
+    {
+        fprintf(stderr, "FAIL: worlds differing in features, shield or pickups share a key\n");
+        failures++;
+    }
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    long operations = argc > 2 ? atol(argv[2]) : 2000000;
+    if (threads < 1 || threads > MAX_THREADS || operations < 1)
+    {
+        fprintf(stderr, "Usage: %s [threads] [operations per thread]\n", argv[0]);
+        return 1;
+    }
+
+    TransTable table;
+    if (!trans_init(&table, TABLE_LOG2_ENTRIES))
+        return 1;
+
+    HammerJob jobs[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    for (int t = 0; t < threads; t++)
+    {
+        jobs[t] = (HammerJob){&table, t, operations, {0}, 0};
+        pthread_create(&ids[t], NULL, hammer, &jobs[t]);
+    }
+
+    TransStats total = {0};
+    long bad_hits = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(ids[t], NULL);
+        total.probes += jobs[t].stats.probes;
+        total.hits += jobs[t].stats.hits;
+        total.stores += jobs[t].stats.stores;
+        total.evictions += jobs[t].stats.evictions;
+        bad_hits += jobs[t].bad_hits;
+    }
+    trans_free(&table);
+
+    printf("%d threads: %llu probes, %llu hits, %llu stores, %llu evictions, %ld bad hits\n", threads,
+           (unsigned long long)total.probes, (unsigned long long)total.hits, (unsigned long long)total.stores,
+           (unsigned long long)total.evictions, bad_hits);
+
+    int failures = (bad_hits != 0) + (total.hits == 0) + (total.evictions == 0);
+    if (bad_hits != 0)
+        fprintf(stderr, "FAIL: probes returned data stored under another key\n");
+    if (total.hits == 0 || total.evictions == 0)
+        fprintf(stderr, "FAIL: the test didn't exercise hits and evictions\n");
+
+    failures += check_search_bot();
+    failures += check_keys();
+    printf("test_transposition: %d failures\n", failures);
+    return failures != 0;
+}
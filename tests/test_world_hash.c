@@ -0,0 +1,117 @@
+/**
+ * Test: incremental world hash
+ * Plays every replay given on the command line through both update kernels
+ * and checks after every tick that the incrementally kept hash equals
+ * world_hash_full. Also checks that changing any single hashed field of a
+ * world changes its hash.
+ *
+ * Usage: test_world_hash FILE...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "replay.h"
+
+// Same loop as replay_run, checking the hash on every tick
+static void check_replay(const Replay *replay, UpdateFn update, const char *what)
+{
+    World world;
+    uint32_t next_jump = 0;
+
+    world_reset(&world, replay->seed);
+    CHECK(world.hash == world_hash_full(&world), "%s: wrong hash after reset", what);
+
+    while (!world.game_over && world.tick < replay->num_ticks)
+    {
+        if (next_jump < replay->num_jumps && replay->jump_ticks[next_jump] == world.tick)
+        {
+            world_jump(&world);
+            next_jump++;
+        }
+        update(&world);
+
+        if (world.hash != world_hash_full(&world))
+        {
+            CHECK(false, "%s: incremental hash wrong at tick %u", what, world.tick);
+            return;
+        }
+    }
+}
+
+static void check_sensitivity(const World *world)
+{
+    uint64_t hash = world_hash_full(world);
+    World changed;
+
+#define CHANGES_HASH(field, name)                                                  \
+    do                                                                             \
+    {                                                                              \
+        changed = *world;                                                          \
+        changed.field += 1;                                                        \
+        CHECK(world_hash_full(&changed) != hash, "changing %s keeps the hash", name); \
+    } while (0)
+
+    CHANGES_HASH(birds.y[0], "bird y");
+    CHANGES_HASH(birds.velocity[0], "bird velocity");
+    CHANGES_HASH(score, "score");
+    CHANGES_HASH(tick, "tick");
+    CHANGES_HASH(last_pipe_tick, "last_pipe_tick");
+    CHANGES_HASH(pipes.count, "pipe count");
+    for (int k = 0; k < 4; k++)
+        CHANGES_HASH(rng.s[k], "rng");
+    for (int i = 0; i < world->pipes.count; i++)
+    {
+        CHANGES_HASH(pipes.x[i], "pipe x");
+        CHANGES_HASH(pipes.gap_y[i], "pipe gap_y");
+
+        changed = *world;
+        changed.pipes.passed[i] = !changed.pipes.passed[i];
+        CHECK(world_hash_full(&changed) != hash, "changing pipe passed keeps the hash");
+    }
+
+    changed = *world;
+    changed.game_over = !changed.game_over;
+    CHECK(world_hash_full(&changed) != hash, "changing game_over keeps the hash");
+
+    // Two pipes swapping slots is a different world too
+    if (world->pipes.count >= 2)
+    {
+        changed = *world;
+        changed.pipes.gap_y[0] = world->pipes.gap_y[1];
+        changed.pipes.gap_y[1] = world->pipes.gap_y[0];
+        CHECK(world->pipes.gap_y[0] == world->pipes.gap_y[1] || world_hash_full(&changed) != hash,
+              "swapping pipe gaps keeps the hash");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+        return 1;
+    }
+
+    Replay replay = {0};
+    for (int i = 1; i < argc; i++)
+    {
+        char what[4200];
+        CHECK(replay_load(&replay, argv[i]), "%s: could not load", argv[i]);
+
+        snprintf(what, sizeof(what), "%s (update_game)", argv[i]);
+        check_replay(&replay, update_game, what);
+        snprintf(what, sizeof(what), "%s (update_game_branchless)", argv[i]);
+        check_replay(&replay, update_game_branchless, what);
+
+        World world;
+        replay_run(&replay, &world, update_game);
+        check_sensitivity(&world);
+    }
+    replay_free(&replay);
+
+    printf("test_world_hash: %d replays, %d failures\n", argc - 1, failures);
+    return failures != 0;
+}
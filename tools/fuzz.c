@@ -0,0 +1,356 @@
+/**
+ * Input fuzzer
+ * Mutates jump timings on one course and keeps every input that reaches
+ * new coverage or a higher score. Coverage is the (tick bucket, pipe index,
+ * cause of death) each run ends on, the cause being worked out afterwards
+ * from the final world.
+ *
+ * Every kept input stores world snapshots every CHECKPOINT_TICKS ticks. A
+ * mutant first differs from its parent at some tick, so it resumes from
+ * the parent's last snapshot before that tick instead of replaying the
+ * shared prefix. --check N replays every Nth mutant from scratch as well
+ * and fails if the two runs disagree, which turns the fuzzer into a stress
+ * test of the snapshots and of update_game's determinism.
+ *
+ * Usage: fuzz [--seed S] [--execs N] [--max-ticks T] [--check N] [--out DIR]
+ *   --out DIR   write the best run and every kept input as replays
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "autopilot.h"
+#include "replay.h"
+
+#define CHECKPOINT_TICKS 64
+#define TICK_BUCKET 32
+#define TICK_BUCKETS 256
+#define PIPE_BUCKETS 64
+
+typedef enum
+{
+    DEATH_GROUND,
+    DEATH_TOP_PIPE,
+    DEATH_BOTTOM_PIPE,
+    DEATH_NONE, // still flying at max ticks
+    DEATH_CAUSES
+} DeathCause;
+
+static const char *cause_names[DEATH_CAUSES] = {"ground", "top pipe", "bottom pipe", "survived"};
+
+typedef struct
+{
+    Replay input;       // seed, jumps and where the run ended
+    World *checkpoints; // world before tick k * CHECKPOINT_TICKS
+    uint32_t num_checkpoints;
+    DeathCause cause;
+} Entry;
+
+typedef struct
+{
+    Entry *entries;
+    int count;
+    int capacity;
+    uint8_t coverage[DEATH_CAUSES][PIPE_BUCKETS][TICK_BUCKETS];
+    int covered;
+} Corpus;
+
+static uint64_t ticks_run = 0;
+static uint64_t ticks_skipped = 0;
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static DeathCause classify_death(const World *world)
+{
+    if (!world->game_over)
+        return DEATH_NONE;
+
+    Rect bird = bird_rect(&world->birds, 0);
+    if (bird.y + bird.h > SCREEN_HEIGHT - GROUND_HEIGHT)
+        return DEATH_GROUND;
+
+    for (int i = 0; i < world->pipes.count; i++)
+    {
+        if (check_collision(bird, pipe_top_rect(&world->pipes, i)))
+            return DEATH_TOP_PIPE;
+    }
+    return DEATH_BOTTOM_PIPE;
+}
+
+// Plays entry's input from the snapshot at or before resume_tick of parent
+// (or from scratch without one), recording the entry's own snapshots
+static void run_entry(Entry *entry, const Entry *parent, uint32_t resume_tick, uint32_t max_ticks)
+{
+    World world;
+    uint32_t next_jump = 0;
+    uint32_t max_checkpoints = max_ticks / CHECKPOINT_TICKS + 1;
+
+    entry->checkpoints = realloc(entry->checkpoints, max_checkpoints * sizeof(World));
+    entry->num_checkpoints = 0;
+
+    if (parent != NULL)
+    {
+        uint32_t k = resume_tick / CHECKPOINT_TICKS;
+        if (k >= parent->num_checkpoints)
+            k = parent->num_checkpoints - 1;
+
+        memcpy(entry->checkpoints, parent->checkpoints, (k + 1) * sizeof(World));
+        entry->num_checkpoints = k + 1;
+        world = parent->checkpoints[k];
+        ticks_skipped += world.tick;
+
+        while (next_jump < entry->input.num_jumps && entry->input.jump_ticks[next_jump] < world.tick)
+            next_jump++;
+    }
+    else
+    {
+        world_reset(&world, entry->input.seed);
+    }
+
+    uint32_t start_tick = world.tick;
+    while (!world.game_over && world.tick < max_ticks)
+    {
+        if (world.tick % CHECKPOINT_TICKS == 0 && world.tick / CHECKPOINT_TICKS >= entry->num_checkpoints)
+        {
+            entry->checkpoints[entry->num_checkpoints++] = world;
+        }
+        if (next_jump < entry->input.num_jumps && entry->input.jump_ticks[next_jump] == world.tick)
+        {
+            world_jump(&world);
+            next_jump++;
+        }
+        update_game(&world);
+    }
+    ticks_run += world.tick - start_tick;
+
+    // Jumps after the end never happened
+    entry->input.num_jumps = next_jump;
+    entry->input.num_ticks = world.tick;
+    entry->input.score = world.score;
+    entry->cause = classify_death(&world);
+}
+
+// Marks the entry's coverage; true if any of it is new
+static bool add_coverage(Corpus *corpus, const Entry *entry)
+{
+    int pipe = entry->input.score < PIPE_BUCKETS ? entry->input.score : PIPE_BUCKETS - 1;
+    uint32_t bucket = entry->input.num_ticks / TICK_BUCKET;
+    if (bucket >= TICK_BUCKETS)
+        bucket = TICK_BUCKETS - 1;
+
+    uint8_t *cell = &corpus->coverage[entry->cause][pipe][bucket];
+    if (*cell)
+        return false;
+    *cell = 1;
+    corpus->covered++;
+    return true;
+}
+
+static void corpus_add(Corpus *corpus, Entry *entry)
+{
+    if (corpus->count == corpus->capacity)
+    {
+        corpus->capacity = corpus->capacity ? corpus->capacity * 2 : 64;
+        corpus->entries = realloc(corpus->entries, corpus->capacity * sizeof(Entry));
+    }
+    corpus->entries[corpus->count++] = *entry;
+    memset(entry, 0, sizeof(*entry));
+}
+
+static void entry_free(Entry *entry)
+{
+    replay_free(&entry->input);
+    free(entry->checkpoints);
+    entry->checkpoints = NULL;
+}
+
+// Replaces child's input with a mutation of parent's; returns the first
+// tick at which the two inputs can differ
+static uint32_t mutate(Replay *child, const Replay *parent, Rng *rng, uint32_t max_ticks)
+{
+    const uint32_t *jumps = parent->jump_ticks;
+    uint32_t n = parent->num_jumps;
+    uint32_t horizon = parent->num_ticks + 1;
+    if (horizon > max_ticks)
+        horizon = max_ticks;
+
+    child->seed = parent->seed;
+    child->num_jumps = 0;
+
+    switch (rng_range(rng, 4))
+    {
+    case 0: // insert a jump
+    {
+        uint32_t tick = rng_range(rng, horizon);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (jumps[i] > tick && (i == 0 || jumps[i - 1] < tick))
+                replay_add_jump(child, tick);
+            replay_add_jump(child, jumps[i]);
+        }
+        if (n == 0 || jumps[n - 1] < tick)
+            replay_add_jump(child, tick);
+        return tick;
+    }
+    case 1: // delete a jump
+    {
+        if (n == 0)
+            return mutate(child, parent, rng, max_ticks);
+        uint32_t victim = rng_range(rng, n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (i != victim)
+                replay_add_jump(child, jumps[i]);
+        }
+        return jumps[victim];
+    }
+    case 2: // nudge a jump by a few ticks, keeping the list sorted
+    {
+        if (n == 0)
+            return mutate(child, parent, rng, max_ticks);
+        uint32_t moved = rng_range(rng, n);
+        int delta = (int)rng_range(rng, 17) - 8;
+        int64_t tick = (int64_t)jumps[moved] + delta;
+        int64_t low = moved > 0 ? jumps[moved - 1] + 1 : 0;
+        int64_t high = moved + 1 < n ? jumps[moved + 1] - 1 : max_ticks - 1;
+        tick = tick < low ? low : tick > high ? high : tick;
+        for (uint32_t i = 0; i < n; i++)
+            replay_add_jump(child, i == moved ? (uint32_t)tick : jumps[i]);
+        return (uint32_t)tick < jumps[moved] ? (uint32_t)tick : jumps[moved];
+    }
+    default: // keep a prefix and tap at random after it
+    {
+        uint32_t cut = rng_range(rng, horizon);
+        uint32_t i = 0;
+        for (; i < n && jumps[i] < cut; i++)
+            replay_add_jump(child, jumps[i]);
+
+        uint32_t interval = 12 + rng_range(rng, 24);
+        for (uint32_t tick = cut + rng_range(rng, interval); tick < max_ticks; tick += 1 + rng_range(rng, interval))
+            replay_add_jump(child, tick);
+        return cut;
+    }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t seed = 1;
+    uint64_t execs = 100000;
+    uint32_t max_ticks = 20000;
+    uint64_t check_every = 0;
+    const char *outdir = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--execs") == 0 && i + 1 < argc)
+            execs = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc)
+            max_ticks = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc)
+            check_every = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outdir = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--seed S] [--execs N] [--max-ticks T] [--check N] [--out DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (max_ticks == 0)
+        max_ticks = 1;
+
+    Corpus corpus = {0};
+    Rng rng;
+    rng_seed(&rng, seed ^ 0x5DEECE66DULL);
+
+    // Start from doing nothing and from one autopilot run
+    Entry entry = {0};
+    entry.input.seed = seed;
+    run_entry(&entry, NULL, 0, max_ticks);
+    add_coverage(&corpus, &entry);
+    corpus_add(&corpus, &entry);
+
+    Autopilot pilot;
+    autopilot_init(&pilot, seed);
+    autopilot_record(&pilot, &entry.input, seed, max_ticks);
+    run_entry(&entry, NULL, 0, max_ticks);
+    add_coverage(&corpus, &entry);
+    corpus_add(&corpus, &entry);
+
+    int best = corpus.entries[0].input.score > corpus.entries[1].input.score ? 0 : 1;
+    uint64_t mismatches = 0;
+    Entry child = {0};
+    double start = now_ns();
+
+    for (uint64_t exec = 1; exec <= execs; exec++)
+    {
+        const Entry *parent = &corpus.entries[rng_range(&rng, corpus.count)];
+        uint32_t first_change = mutate(&child.input, &parent->input, &rng, max_ticks);
+        run_entry(&child, parent, first_change, max_ticks);
+
+        if (check_every != 0 && exec % check_every == 0)
+        {
+            World world;
+            Replay cut = child.input;
+            cut.num_ticks = max_ticks;
+            replay_run(&cut, &world, update_game);
+            if (world.tick != child.input.num_ticks || world.score != child.input.score)
+            {
+                if (mismatches++ == 0)
+                    fprintf(stderr, "exec %llu: resumed run ended at tick %u score %d, from scratch %u / %d\n",
+                            (unsigned long long)exec, child.input.num_ticks, child.input.score, world.tick,
+                            world.score);
+            }
+        }
+
+        bool new_best = child.input.score > corpus.entries[best].input.score;
+        if (add_coverage(&corpus, &child) || new_best)
+        {
+            if (new_best)
+            {
+                best = corpus.count;
+                printf("exec %llu: score %d at tick %u (%s)\n", (unsigned long long)exec, child.input.score,
+                       child.input.num_ticks, cause_names[child.cause]);
+            }
+            corpus_add(&corpus, &child);
+        }
+    }
+
+    double elapsed = now_ns() - start;
+    const Entry *top = &corpus.entries[best];
+    printf("%llu execs in %.2f s (%.0f/s), %d kept, %d coverage cells\n", (unsigned long long)execs, elapsed / 1e9,
+           execs * 1e9 / elapsed, corpus.count, corpus.covered);
+    printf("ticks simulated %llu, skipped by snapshots %llu (%.1f%%)\n", (unsigned long long)ticks_run,
+           (unsigned long long)ticks_skipped, 100.0 * ticks_skipped / (ticks_run + ticks_skipped + 1));
+    printf("best score %d at tick %u (%s)\n", top->input.score, top->input.num_ticks, cause_names[top->cause]);
+    if (check_every != 0)
+        printf("%llu from-scratch mismatches\n", (unsigned long long)mismatches);
+
+    if (outdir != NULL)
+    {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/best.rep", outdir);
+        replay_save(&top->input, path);
+        for (int i = 0; i < corpus.count; i++)
+        {
+            snprintf(path, sizeof(path), "%s/%05d.rep", outdir, i);
+            replay_save(&corpus.entries[i].input, path);
+        }
+    }
+
+    entry_free(&child);
+    for (int i = 0; i < corpus.count; i++)
+        entry_free(&corpus.entries[i]);
+    free(corpus.entries);
+    return mismatches != 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * Replay generator
+ * Records autopilot runs on consecutive seeds into numbered replay files;
+ * this is how the bundled replays/ corpus was made.
+ *
+ * Usage: replay_gen [--count N] [--seed S] [--max-ticks T] OUTDIR
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "autopilot.h"
+#include "replay.h"
+
+int main(int argc, char *argv[])
+{
+    int count = 32;
+    uint64_t seed = 1;
+    uint32_t max_ticks = 10000;
+    const char *outdir = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc)
+            max_ticks = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (outdir == NULL && argv[i][0] != '-')
+            outdir = argv[i];
+        else
+            outdir = NULL, count = -1;
+    }
+    if (outdir == NULL || count <= 0)
+    {
+        fprintf(stderr, "Usage: %s [--count N] [--seed S] [--max-ticks T] OUTDIR\n", argv[0]);
+        return 1;
+    }
+
+    Replay replay = {0};
+    for (int r = 0; r < count; r++)
+    {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%03d.rep", outdir, r);
+
+        Autopilot pilot;
+        autopilot_init(&pilot, seed + r);
+        autopilot_record(&pilot, &replay, seed + r, max_ticks);
+        if (!replay_save(&replay, path))
+        {
+            replay_free(&replay);
+            return 1;
+        }
+        printf("%s: %u ticks, score %d\n", path, replay.num_ticks, replay.score);
+    }
+
+    replay_free(&replay);
+    return 0;
+}
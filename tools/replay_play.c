@@ -0,0 +1,78 @@
+/**
+ * Headless replay player
+ * Plays replay files through update_game as fast as possible, checks each
+ * ends the way it was recorded and reports throughput. Used to train the
+ * PGO build and to measure it.
+ *
+ * Usage: replay_play [--repeat N] FILE...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "replay.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    int repeat = 1;
+    int first_file = 1;
+    if (argc > 2 && strcmp(argv[1], "--repeat") == 0)
+    {
+        repeat = atoi(argv[2]);
+        first_file = 3;
+    }
+    if (first_file >= argc || repeat <= 0)
+    {
+        fprintf(stderr, "Usage: %s [--repeat N] FILE...\n", argv[0]);
+        return 1;
+    }
+
+    int num_replays = argc - first_file;
+    Replay *replays = calloc(num_replays, sizeof(Replay));
+    for (int r = 0; r < num_replays; r++)
+    {
+        if (!replay_load(&replays[r], argv[first_file + r]))
+        {
+            fprintf(stderr, "Could not load replay %s\n", argv[first_file + r]);
+            return 1;
+        }
+    }
+
+    uint64_t ticks = 0;
+    int mismatches = 0;
+    World world;
+    double start = now_ns();
+    for (int n = 0; n < repeat; n++)
+    {
+        for (int r = 0; r < num_replays; r++)
+        {
+            if (!replay_run(&replays[r], &world, update_game) && n == 0)
+            {
+                fprintf(stderr, "%s: ended at tick %u with score %d, recorded %u / %d\n", argv[first_file + r],
+                        world.tick, world.score, replays[r].num_ticks, replays[r].score);
+                mismatches++;
+            }
+            ticks += world.tick;
+        }
+    }
+    double elapsed = now_ns() - start;
+
+    printf("%d replays x %d: %llu ticks in %.1f ms, %.2f ns/tick, %.1f Mticks/s, %d mismatches\n", num_replays,
+           repeat, (unsigned long long)ticks, elapsed / 1e6, elapsed / ticks, ticks * 1e3 / elapsed, mismatches);
+
+    for (int r = 0; r < num_replays; r++)
+    {
+        replay_free(&replays[r]);
+    }
+    free(replays);
+    return mismatches != 0;
+}
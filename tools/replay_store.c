@@ -0,0 +1,133 @@
+/**
+ * Replay store tool
+ * Packs replay files into a prefix-sharing store, replays a whole store
+ * with each shared prefix simulated once, and gets replays back out.
+ *
+ * Usage:
+ *   replay_store pack STORE FILE...    build STORE from replay files
+ *   replay_store run STORE             simulate every replay, check outcomes
+ *   replay_store extract STORE ID OUT  write replay ID back out as a file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "replay_trie.h"
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static long file_size(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : 0;
+}
+
+static int pack(const char *store_path, int num_files, char *files[])
+{
+    ReplayTrie trie;
+    replay_trie_init(&trie);
+
+    Replay replay = {0};
+    uint64_t jumps = 0;
+    long bytes = 0;
+    for (int i = 0; i < num_files; i++)
+    {
+        if (!replay_load(&replay, files[i]) || replay_trie_insert(&trie, &replay) == TRIE_NONE)
+        {
+            fprintf(stderr, "Could not add %s\n", files[i]);
+            return 1;
+        }
+        jumps += replay.num_jumps;
+        bytes += file_size(files[i]);
+    }
+    replay_free(&replay);
+
+    bool ok = replay_trie_save(&trie, store_path);
+    if (ok)
+    {
+        printf("%d replays, %llu jumps -> %u courses, %u trie nodes (%.1f%% of the jumps)\n", num_files,
+               (unsigned long long)jumps, trie.num_roots, trie.num_nodes - trie.num_roots,
+               jumps ? 100.0 * (trie.num_nodes - trie.num_roots) / jumps : 0.0);
+        printf("%ld bytes of replay files -> %ld byte store\n", bytes, file_size(store_path));
+    }
+    replay_trie_free(&trie);
+    return !ok;
+}
+
+static int run(const char *store_path)
+{
+    ReplayTrie trie;
+    if (!replay_trie_load(&trie, store_path))
+        return 1;
+
+    uint64_t flat_ticks = 0;
+    for (uint32_t id = 0; id < trie.num_ends; id++)
+        flat_ticks += trie.ends[id].num_ticks;
+
+    bool *ok = calloc(trie.num_ends, sizeof(bool));
+    uint64_t ticks;
+    double start = now_ns();
+    if (!replay_trie_run(&trie, ok, &ticks))
+    {
+        fprintf(stderr, "%s: could not simulate the store\n", store_path);
+        free(ok);
+        replay_trie_free(&trie);
+        return 1;
+    }
+    double elapsed = now_ns() - start;
+
+    int failures = 0;
+    for (uint32_t id = 0; id < trie.num_ends; id++)
+    {
+        if (trie.ends[id].node != TRIE_NONE && !ok[id])
+        {
+            if (failures++ < 10)
+                fprintf(stderr, "replay %u did not end as recorded\n", id);
+        }
+    }
+
+    printf("%u replays: simulated %llu ticks instead of %llu (%.1f%%) in %.1f ms, %u snapshots, %d failures\n",
+           trie.num_ends, (unsigned long long)ticks, (unsigned long long)flat_ticks,
+           flat_ticks ? 100.0 * ticks / flat_ticks : 0.0, elapsed / 1e6, trie.num_checkpoints, failures);
+
+    free(ok);
+    replay_trie_free(&trie);
+    return failures != 0;
+}
+
+static int extract(const char *store_path, uint32_t id, const char *out_path)
+{
+    ReplayTrie trie;
+    if (!replay_trie_load(&trie, store_path))
+        return 1;
+
+    Replay replay = {0};
+    bool ok = replay_trie_extract(&trie, id, &replay) && replay_save(&replay, out_path);
+    if (!ok)
+        fprintf(stderr, "Could not extract replay %u\n", id);
+
+    replay_free(&replay);
+    replay_trie_free(&trie);
+    return !ok;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && strcmp(argv[1], "pack") == 0)
+        return pack(argv[2], argc - 3, argv + 3);
+    if (argc == 3 && strcmp(argv[1], "run") == 0)
+        return run(argv[2]);
+    if (argc == 5 && strcmp(argv[1], "extract") == 0)
+        return extract(argv[2], (uint32_t)strtoul(argv[3], NULL, 10), argv[4]);
+
+    fprintf(stderr, "Usage: %s pack STORE FILE... | run STORE | extract STORE ID OUT\n", argv[0]);
+    return 1;
+}
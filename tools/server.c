@@ -0,0 +1,63 @@
+/**
+ * Multiplayer server
+ * Hosts rounds on localhost for up to MAX_PLAYERS clients, ticking at
+ * TICK_RATE, and prints a line of load figures every few seconds.
+ *
+ * Usage: server [port] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "server.h"
+
+#define REPORT_TICKS (5 * TICK_RATE)
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    uint16_t port = argc > 1 ? (uint16_t)atoi(argv[1]) : 7777;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+
+    static Server server;
+    if (!server_open(&server, port, seed))
+    {
+        fprintf(stderr, "Could not open port %u\n", port);
+        return 1;
+    }
+    printf("Serving on 127.0.0.1:%u, seed %llu\n", server_port(&server), (unsigned long long)seed);
+    fflush(stdout);
+
+    ServerTickStats stats = {0};
+    double next_tick = now_ns();
+    for (uint64_t tick = 1;; tick++)
+    {
+        server_tick(&server, &stats);
+
+        if (tick % REPORT_TICKS == 0)
+        {
+            double busy_ns = stats.receive_ns + stats.simulate_ns + stats.send_ns;
+            printf("round %u: %d players, %.1f us per tick, %.0f bytes per snapshot\n", server.round,
+                   server.num_connected, busy_ns / REPORT_TICKS / 1000,
+                   stats.snapshots ? (double)stats.bytes / stats.snapshots : 0.0);
+            fflush(stdout);
+            stats = (ServerTickStats){0};
+        }
+
+        // Sleep to the next tick, or catch up without sleeping if behind
+        next_tick += 1e9 / TICK_RATE;
+        double wait = next_tick - now_ns();
+        if (wait > 0)
+        {
+            struct timespec ts = {(time_t)(wait / 1e9), (long)((uint64_t)wait % 1000000000)};
+            nanosleep(&ts, NULL);
+        }
+    }
+}
@@ -0,0 +1,146 @@
+/**
+ * Transposition table
+ * Buckets are 64-byte aligned so a probe touches one cache line. Stores
+ * reuse the slot holding the same key, else an empty slot, else the one
+ * with the shallowest search.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "transposition.h"
+
+static inline uint64_t pack(TransData data)
+{
+    return (uint32_t)data.value | (uint64_t)data.depth << 32 | (uint64_t)data.move << 40;
+}
+
+static inline TransData unpack(uint64_t bits)
+{
+    return (TransData){(int32_t)(uint32_t)bits, (uint8_t)(bits >> 32), (uint8_t)(bits >> 40)};
+}
+
+static inline uint64_t mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+bool trans_init(TransTable *table, int log2_entries)
+{
+    uint64_t buckets = ((uint64_t)1 << log2_entries) / TRANS_BUCKET;
+    if (buckets == 0)
+        buckets = 1;
+
+    table->entries = aligned_alloc(64, buckets * TRANS_BUCKET * sizeof(TransEntry));
+    if (table->entries == NULL)
+        return false;
+
+    table->bucket_mask = buckets - 1;
+    trans_clear(table);
+    return true;
+}
+
+void trans_free(TransTable *table)
+{
+    free(table->entries);
+    table->entries = NULL;
+}
+
+void trans_clear(TransTable *table)
+{
+    // Only call while no other thread uses the table
+    memset(table->entries, 0, (table->bucket_mask + 1) * TRANS_BUCKET * sizeof(TransEntry));
+}
+
+uint64_t trans_key(const World *world)
+{
+    // The pipes on screen follow from the tick on a given course, so the
+    // phase only adds the spawn timer and how many pipes have been passed
+    int y_band = world->birds.row[0] / TRANS_Y_BAND;
+    int velocity_band = (int)lrintf(world->birds.velocity[0] * TRANS_VELOCITY_BANDS);
+    uint32_t phase = (world->tick - world->last_pipe_tick) | (uint32_t)world->score << 8;
+
+    uint64_t key = mix64(world->tick ^ (uint64_t)phase << 32);
+    key = mix64(key ^ ((uint64_t)(uint32_t)y_band << 32 | (uint32_t)velocity_band));
+    key = mix64(key ^ world->rng.s[0] ^ (uint64_t)world->rng.s[1] << 32);
+
+    // Features change what the same bird does; so do a running shield and
+    // which pickups are still there (summed, as slots move on every sort)
+    key = mix64(key ^ world->features ^ (uint64_t)(uint32_t)world->shield_ticks << 32);
+    if (world->features & WORLD_PICKUPS)
+    {
+        const Pickups *pickups = &world->pickups;
+        uint64_t left = 0;
+        for (int i = 0; i < pickups->count; i++)
+        {
+            if (pickups->kind[i] != PICKUP_NONE)
+                left += mix64((uint32_t)pickups->x[i] | (uint64_t)(uint16_t)pickups->y[i] << 32 |
+                              (uint64_t)pickups->kind[i] << 48);
+        }
+        key = mix64(key ^ left ^ (uint32_t)world->coins);
+        key = mix64(key ^ world->pickup_rng.s[0] ^ (uint64_t)world->pickup_rng.s[1] << 32);
+    }
+    if (world->features & WORLD_MOVING_GAPS)
+        key = mix64(key ^ world->motion_rng.s[0] ^ (uint64_t)world->motion_rng.s[1] << 32);
+
+    // Zero marks empty slots
+    return key | 1;
+}
+
+bool trans_probe(TransTable *table, uint64_t key, TransData *data, TransStats *stats)
+{
+    TransEntry *bucket = &table->entries[(key & table->bucket_mask) * TRANS_BUCKET];
+    stats->probes++;
+
+    for (int i = 0; i < TRANS_BUCKET; i++)
+    {
+        uint64_t bits = atomic_load_explicit(&bucket[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&bucket[i].check, memory_order_relaxed);
+        if ((check ^ bits) == key)
+        {
+            *data = unpack(bits);
+            stats->hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void trans_store(TransTable *table, uint64_t key, TransData data, TransStats *stats)
+{
+    TransEntry *bucket = &table->entries[(key & table->bucket_mask) * TRANS_BUCKET];
+    int victim = 0;
+    int victim_depth = 256;
+    bool evicting = true;
+
+    for (int i = 0; i < TRANS_BUCKET; i++)
+    {
+        uint64_t bits = atomic_load_explicit(&bucket[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&bucket[i].check, memory_order_relaxed);
+        uint64_t slot_key = check ^ bits;
+
+        if (slot_key == key || slot_key == 0)
+        {
+            victim = i;
+            evicting = false;
+            break;
+        }
+
+        int depth = unpack(bits).depth;
+        if (depth < victim_depth)
+        {
+            victim = i;
+            victim_depth = depth;
+        }
+    }
+
+    uint64_t bits = pack(data);
+    atomic_store_explicit(&bucket[victim].data, bits, memory_order_relaxed);
+    atomic_store_explicit(&bucket[victim].check, key ^ bits, memory_order_relaxed);
+
+    stats->stores++;
+    stats->evictions += evicting;
+}
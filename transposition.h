@@ -0,0 +1,69 @@
+/**
+ * Transposition table
+ * A fixed-size hash table shared by any number of search threads without
+ * locks. Worlds are keyed by a quantized summary (course RNG state, tick,
+ * bird row band, velocity band, pipe phase, plus features, shield and the
+ * pickups left), so nearly identical states share an entry and a search
+ * only expands one of them.
+ *
+ * Each entry is two 64-bit words written independently: the data and the
+ * key XOR the data. A reader that races a writer sees a pair that doesn't
+ * XOR back to its key and treats it as a miss, so no locks are needed and
+ * a torn entry is never returned. Concurrent stores to one slot simply
+ * let one of them win.
+ */
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define TRANS_BUCKET 4 // entries probed per key, one 64-byte line
+
+// Quantization of the key
+#define TRANS_Y_BAND 2        // pixels
+#define TRANS_VELOCITY_BANDS 5 // per pixel/tick
+
+typedef struct
+{
+    _Atomic uint64_t check; // key ^ data
+    _Atomic uint64_t data;
+} TransEntry;
+
+typedef struct
+{
+    TransEntry *entries;
+    uint64_t bucket_mask;
+} TransTable;
+
+typedef struct
+{
+    int32_t value;
+    uint8_t depth; // plies searched below this state
+    uint8_t move;  // best action, 1 = jump
+} TransData;
+
+// Per-thread counters; sum them for table-wide rates
+typedef struct
+{
+    uint64_t probes;
+    uint64_t hits;      // key found
+    uint64_t stores;
+    uint64_t evictions; // stores that threw out another key
+} TransStats;
+
+// Allocates 2^log2_entries entries (rounded up to whole buckets)
+bool trans_init(TransTable *table, int log2_entries);
+void trans_free(TransTable *table);
+void trans_clear(TransTable *table);
+
+uint64_t trans_key(const World *world);
+
+bool trans_probe(TransTable *table, uint64_t key, TransData *data, TransStats *stats);
+void trans_store(TransTable *table, uint64_t key, TransData data, TransStats *stats);
+
+#endif